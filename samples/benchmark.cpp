@@ -0,0 +1,642 @@
+/*
+
+Copyright (C) Grame 2002-2013
+
+This library is free software; you can redistribute it and modify it under
+the terms of the GNU Library General Public License as published by the
+Free Software Foundation version 2 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public License
+for more details.
+
+You should have received a copy of the GNU Library General Public License
+along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+Grame Research Laboratory, 9, rue du Garet 69001 Lyon - France
+research@grame.fr
+
+*/
+
+#include "TAudioGlobals.h"
+#include "TAudioContext.h"
+#include "TBufferedAudioStream.h"
+#include "TAudioEffect.h"
+#include "TVolAudioEffect.h"
+#include "TPanAudioEffect.h"
+#include "TPitchShiftAudioEffect.h"
+#include "TSampleRateAudioStream.h"
+#include "TRubberBandAudioStream.h"
+#include "TScratchArena.h"
+#include "UAudioTools.h"
+#include "UTools.h"
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+
+/*
+Times the UAudioTools kernels, TBufferedAudioStream::HandleBuffer, the effect lists with each
+built-in effect, and the resampler and time-stretch streams, at common block sizes and channel
+counts. Results are written as JSON (on stdout, or in the file given as first argument) so that
+runs of different versions can be compared.
+
+Each measure is calibrated to last at least kMinRunTime, then repeated kRuns times: the best run
+gives ns_per_frame, the average gives ns_per_frame_mean.
+*/
+
+extern "C" long LibVersion();
+
+#define SAMPLE_RATE 44100
+#define BUFFER_SIZE 4096
+#define STREAM_BUFFER_SIZE 65536
+#define MAX_CHANNELS 8
+
+static const double kMinRunTime = 0.01;
+static const int kRuns = 5;
+
+static const long kFrames[] = {64, 256, 1024, 4096};
+static const long kChannels[] = {1, 2, 8};
+
+#define COUNT(array) long(sizeof(array) / sizeof(array[0]))
+
+//---------------------
+// Benchmark reporting
+//---------------------
+
+static FILE* gOut = stdout;
+static bool gFirst = true;
+
+struct TBenchData
+{
+    float* fIn;
+    float* fOut;
+    short* fShortIn;
+    short* fShortOut;
+    long* fLongOut;
+    float* fInPlanes[MAX_CHANNELS];
+    float* fOutPlanes[MAX_CHANNELS];
+    float fGain;
+    void* fObject;      // Effect list, stream...
+};
+
+typedef void (*BenchFun)(TBenchData* data, long frames, long channelsIn, long channelsOut);
+
+static double RunBench(BenchFun fun, TBenchData* data, long frames, long channelsIn, long channelsOut, long iterations)
+{
+    double start = UTools::GetTime();
+    for (long i = 0; i < iterations; i++) {
+        fun(data, frames, channelsIn, channelsOut);
+    }
+    return UTools::GetTime() - start;
+}
+
+static void Measure(const char* name, BenchFun fun, TBenchData* data, long frames, long channelsIn, long channelsOut)
+{
+    // Warm up, then calibrate
+    long iterations = 1;
+    fun(data, frames, channelsIn, channelsOut);
+    while (RunBench(fun, data, frames, channelsIn, channelsOut, iterations) < kMinRunTime && iterations < (LONG_MAX / 2)) {
+        iterations *= 2;
+    }
+
+    double best = 0.0;
+    double total = 0.0;
+    for (int run = 0; run < kRuns; run++) {
+        double duration = RunBench(fun, data, frames, channelsIn, channelsOut, iterations);
+        best = (run == 0 || duration < best) ? duration : best;
+        total += duration;
+    }
+
+    double scale = 1e9 / (double(iterations) * double(frames));
+    fprintf(gOut, "%s\n    {\"name\": \"%s\", \"frames\": %ld, \"channels_in\": %ld, \"channels\": %ld, \"iterations\": %ld, \"ns_per_frame\": %.3f, \"ns_per_frame_mean\": %.3f}",
+            (gFirst) ? "" : ",", name, frames, channelsIn, channelsOut, iterations, best * scale, (total / kRuns) * scale);
+    gFirst = false;
+    fflush(gOut);
+}
+
+static void Fill(float* buffer, long samples)
+{
+    for (long i = 0; i < samples; i++) {
+        buffer[i] = 0.5f * sinf(2.f * float(M_PI) * 440.f * float(i) / float(SAMPLE_RATE));
+    }
+}
+
+static void Fill(short* buffer, long samples)
+{
+    for (long i = 0; i < samples; i++) {
+        buffer[i] = short(16000.f * sinf(2.f * float(M_PI) * 440.f * float(i) / float(SAMPLE_RATE)));
+    }
+}
+
+//-------------------
+// UAudioTools kernels
+//-------------------
+
+static void MixFrameToFrameBlk(TBenchData* data, long frames, long channelsIn, long channelsOut)
+{
+    UAudioTools::MixFrameToFrameBlk(data->fOut, data->fIn, frames, channelsOut);
+}
+
+static void MixFrameToFrameBlkGain(TBenchData* data, long frames, long channelsIn, long channelsOut)
+{
+    UAudioTools::MixFrameToFrameBlk(data->fOut, data->fIn, frames, channelsOut, 0.7f, 0.3f);
+}
+
+static void MixFrameToFrameBlkMatrix(TBenchData* data, long frames, long channelsIn, long channelsOut)
+{
+    UAudioTools::MixFrameToFrameBlk(data->fOut, data->fIn, frames, channelsOut, 0.7f, 0.3f, 0.2f, 0.8f);
+}
+
+static void MixFrameToFrameBlk1(TBenchData* data, long frames, long channelsIn, long channelsOut)
+{
+    UAudioTools::MixFrameToFrameBlk1(data->fOut, data->fIn, frames, channelsOut);
+}
+
+static void MixUpFrameToFrameBlk(TBenchData* data, long frames, long channelsIn, long channelsOut)
+{
+    UAudioTools::MixUpFrameToFrameBlk(data->fOut, data->fIn, frames, channelsIn, channelsOut, 0.7f, 0.3f, 0.2f, 0.8f);
+}
+
+static void ReplaceFrameToFrameBlk(TBenchData* data, long frames, long channelsIn, long channelsOut)
+{
+    UAudioTools::ReplaceFrameToFrameBlk(data->fOut, data->fIn, frames, channelsOut, 0.7f, 0.3f);
+}
+
+static void ReplaceFrameToFrameBlk1(TBenchData* data, long frames, long channelsIn, long channelsOut)
+{
+    UAudioTools::ReplaceFrameToFrameBlk1(data->fOut, data->fIn, frames, channelsOut);
+}
+
+static void MixSamplesBlk(TBenchData* data, long frames, long channelsIn, long channelsOut)
+{
+    UAudioTools::MixSamplesBlk(data->fOut, data->fIn, frames * channelsOut);
+}
+
+static void ZeroFloatBlk(TBenchData* data, long frames, long channelsIn, long channelsOut)
+{
+    UAudioTools::ZeroFloatBlk(data->fOut, frames, channelsOut);
+}
+
+static void ZeroShortBlk(TBenchData* data, long frames, long channelsIn, long channelsOut)
+{
+    UAudioTools::ZeroShortBlk(data->fShortOut, frames, channelsOut);
+}
+
+static void Interleave(TBenchData* data, long frames, long channelsIn, long channelsOut)
+{
+    UAudioTools::Interleave(data->fOut, data->fInPlanes, frames, channelsOut);
+}
+
+static void Deinterleave(TBenchData* data, long frames, long channelsIn, long channelsOut)
+{
+    UAudioTools::Deinterleave(data->fOutPlanes, data->fIn, frames, channelsOut);
+}
+
+static void Short2Float(TBenchData* data, long frames, long channelsIn, long channelsOut)
+{
+    UAudioTools::Short2Float(data->fShortIn, data->fOut, frames, channelsIn, channelsOut);
+}
+
+static void Short2FloatMix(TBenchData* data, long frames, long channelsIn, long channelsOut)
+{
+    UAudioTools::Short2FloatMix(data->fShortIn, data->fOut, frames, channelsIn, channelsOut);
+}
+
+static void Float2Short(TBenchData* data, long frames, long channelsIn, long channelsOut)
+{
+    UAudioTools::Float2Short(data->fIn, data->fShortOut, frames, channelsIn, channelsOut);
+}
+
+static void Float2ShortMix(TBenchData* data, long frames, long channelsIn, long channelsOut)
+{
+    UAudioTools::Float2ShortMix(data->fIn, data->fShortOut, frames, channelsIn, channelsOut);
+}
+
+static void Float2FloatMix(TBenchData* data, long frames, long channelsIn, long channelsOut)
+{
+    UAudioTools::Float2FloatMix(data->fIn, data->fOut, frames, channelsIn, channelsOut);
+}
+
+// As used by the effect list fades, the gain alternates so that samples do not become denormals
+static void MultFrame(TBenchData* data, long frames, long channelsIn, long channelsOut)
+{
+    data->fGain = 1.0f / data->fGain;
+    for (long i = 0; i < frames; i++) {
+        UAudioTools::MultFrame(&data->fOut[i * channelsOut], data->fGain, channelsOut);
+    }
+}
+
+// Stereo kernels
+
+static void MonoToStereo(TBenchData* data, long frames, long channelsIn, long channelsOut)
+{
+    UAudioTools::MonoToStereo(data->fShortOut, data->fShortIn, frames);
+}
+
+static void MixMonoToStereoBlkShort(TBenchData* data, long frames, long channelsIn, long channelsOut)
+{
+    UAudioTools::MixMonoToStereoBlk(data->fLongOut, data->fShortIn, frames, 3, 5);
+}
+
+static void MixMonoToStereoBlkFloat(TBenchData* data, long frames, long channelsIn, long channelsOut)
+{
+    UAudioTools::MixMonoToStereoBlk(data->fOut, data->fIn, frames, 0.7f, 0.3f);
+}
+
+static void MixStereoToStereoBlkShort(TBenchData* data, long frames, long channelsIn, long channelsOut)
+{
+    UAudioTools::MixStereoToStereoBlk(data->fLongOut, data->fShortIn, frames * 2, 3, 5);
+}
+
+static void MixStereoToStereoBlkFloat(TBenchData* data, long frames, long channelsIn, long channelsOut)
+{
+    UAudioTools::MixStereoToStereoBlk(data->fOut, data->fIn, frames * 2, 0.7f, 0.3f);
+}
+
+static void Float2ShortStereo(TBenchData* data, long frames, long channelsIn, long channelsOut)
+{
+    UAudioTools::Float2ShortStereo(data->fIn, data->fShortOut, frames * 2);
+}
+
+static void Float2LongMulti(TBenchData* data, long frames, long channelsIn, long channelsOut)
+{
+    UAudioTools::Float2LongMulti(data->fIn, data->fLongOut, frames, 2, 0, 1);
+}
+
+static void Short2FloatStereo(TBenchData* data, long frames, long channelsIn, long channelsOut)
+{
+    UAudioTools::Short2FloatStereo(data->fShortIn, data->fOut, frames * 2);
+}
+
+static void Short2FloatMono(TBenchData* data, long frames, long channelsIn, long channelsOut)
+{
+    UAudioTools::Short2FloatMono(data->fShortIn, data->fOut, frames);
+}
+
+// channelsIn = channelsOut = 0 : measured at each kChannels value
+struct TKernel
+{
+    const char* fName;
+    BenchFun fFun;
+    long fChannelsIn;
+    long fChannelsOut;
+};
+
+static const TKernel kKernels[] = {
+    {"UAudioTools::MixFrameToFrameBlk", MixFrameToFrameBlk, 0, 0},
+    {"UAudioTools::MixFrameToFrameBlk/gain", MixFrameToFrameBlkGain, 0, 0},
+    {"UAudioTools::MixFrameToFrameBlk/matrix", MixFrameToFrameBlkMatrix, 0, 0},
+    {"UAudioTools::MixFrameToFrameBlk1", MixFrameToFrameBlk1, 0, 0},
+    {"UAudioTools::MixUpFrameToFrameBlk", MixUpFrameToFrameBlk, 1, 2},
+    {"UAudioTools::MixUpFrameToFrameBlk", MixUpFrameToFrameBlk, 1, 8},
+    {"UAudioTools::MixUpFrameToFrameBlk", MixUpFrameToFrameBlk, 2, 8},
+    {"UAudioTools::ReplaceFrameToFrameBlk", ReplaceFrameToFrameBlk, 0, 0},
+    {"UAudioTools::ReplaceFrameToFrameBlk1", ReplaceFrameToFrameBlk1, 0, 0},
+    {"UAudioTools::MixSamplesBlk", MixSamplesBlk, 0, 0},
+    {"UAudioTools::ZeroFloatBlk", ZeroFloatBlk, 0, 0},
+    {"UAudioTools::ZeroShortBlk", ZeroShortBlk, 0, 0},
+    {"UAudioTools::Interleave", Interleave, 0, 0},
+    {"UAudioTools::Deinterleave", Deinterleave, 0, 0},
+    {"UAudioTools::Short2Float", Short2Float, 0, 0},
+    {"UAudioTools::Short2Float", Short2Float, 1, 2},
+    {"UAudioTools::Short2Float", Short2Float, 2, 8},
+    {"UAudioTools::Short2FloatMix", Short2FloatMix, 0, 0},
+    {"UAudioTools::Short2FloatMix", Short2FloatMix, 1, 2},
+    {"UAudioTools::Short2FloatMix", Short2FloatMix, 2, 8},
+    {"UAudioTools::Float2Short", Float2Short, 0, 0},
+    {"UAudioTools::Float2Short", Float2Short, 8, 2},
+    {"UAudioTools::Float2ShortMix", Float2ShortMix, 0, 0},
+    {"UAudioTools::Float2ShortMix", Float2ShortMix, 8, 2},
+    {"UAudioTools::Float2FloatMix", Float2FloatMix, 0, 0},
+    {"UAudioTools::Float2FloatMix", Float2FloatMix, 1, 2},
+    {"UAudioTools::Float2FloatMix", Float2FloatMix, 2, 8},
+    {"UAudioTools::MultFrame", MultFrame, 0, 0},
+    {"UAudioTools::MonoToStereo", MonoToStereo, 1, 2},
+    {"UAudioTools::MixMonoToStereoBlk/short", MixMonoToStereoBlkShort, 1, 2},
+    {"UAudioTools::MixMonoToStereoBlk/float", MixMonoToStereoBlkFloat, 1, 2},
+    {"UAudioTools::MixStereoToStereoBlk/short", MixStereoToStereoBlkShort, 2, 2},
+    {"UAudioTools::MixStereoToStereoBlk/float", MixStereoToStereoBlkFloat, 2, 2},
+    {"UAudioTools::Float2ShortStereo", Float2ShortStereo, 2, 2},
+    {"UAudioTools::Float2LongMulti", Float2LongMulti, 2, 2},
+    {"UAudioTools::Short2FloatStereo", Short2FloatStereo, 2, 2},
+    {"UAudioTools::Short2FloatMono", Short2FloatMono, 1, 2}
+};
+
+static void BenchKernels(TBenchData* data)
+{
+    for (long k = 0; k < COUNT(kKernels); k++) {
+        for (long f = 0; f < COUNT(kFrames); f++) {
+            if (kKernels[k].fChannelsOut > 0) {
+                Measure(kKernels[k].fName, kKernels[k].fFun, data, kFrames[f], kKernels[k].fChannelsIn, kKernels[k].fChannelsOut);
+            } else {
+                for (long c = 0; c < COUNT(kChannels); c++) {
+                    Measure(kKernels[k].fName, kKernels[k].fFun, data, kFrames[f], kChannels[c], kChannels[c]);
+                }
+            }
+        }
+    }
+}
+
+//----------------------------
+// TBufferedAudioStream::HandleBuffer
+//----------------------------
+
+/*
+The double buffer is kept in memory: the default ReadBuffer/WriteBuffer do not access any file
+and mark the buffer as ready, so that only the HandleBuffer code is measured.
+*/
+
+class TMemoryBufferedAudioStream : public TBufferedAudioStream
+{
+
+    public:
+
+        TMemoryBufferedAudioStream(long bufferSize, long channels): TBufferedAudioStream()
+        {
+            fMemoryBuffer = new TLocalAudioBuffer<short>(bufferSize, channels);
+            Fill(fMemoryBuffer->GetFrame(0), bufferSize * channels);
+            fChannels = channels;
+            fFramesNum = LONG_MAX;
+            fReady = true;
+        }
+        virtual ~TMemoryBufferedAudioStream()
+        {
+            delete fMemoryBuffer;
+        }
+};
+
+struct THandleBufferData
+{
+    TBufferedAudioStream* fStream;
+    FLOAT_BUFFER fBuffer;
+};
+
+static void HandleBufferRead(TBenchData* data, long frames, long channelsIn, long channelsOut)
+{
+    THandleBufferData* handle = (THandleBufferData*)data->fObject;
+    handle->fStream->Read(handle->fBuffer, frames, 0, channelsOut);
+}
+
+static void HandleBufferWrite(TBenchData* data, long frames, long channelsIn, long channelsOut)
+{
+    THandleBufferData* handle = (THandleBufferData*)data->fObject;
+    handle->fStream->Write(handle->fBuffer, frames, 0, channelsOut);
+}
+
+static void MeasureHandleBuffer(const char* name, BenchFun fun, TBenchData* data, long bufferSize, long frames, long channelsIn, long channelsOut)
+{
+    THandleBufferData handle;
+    handle.fStream = new TMemoryBufferedAudioStream(bufferSize, channelsIn);
+    handle.fBuffer = new TLocalAudioBuffer<float>(frames, channelsOut);
+    Fill(handle.fBuffer->GetFrame(0), frames * channelsOut);
+    data->fObject = &handle;
+    Measure(name, fun, data, frames, channelsIn, channelsOut);
+    delete handle.fBuffer;
+    delete handle.fStream;
+}
+
+static void BenchHandleBuffer(TBenchData* data)
+{
+    for (long f = 0; f < COUNT(kFrames); f++) {
+        long frames = kFrames[f];
+        // Streaming : a stream buffer sized double buffer, the end of a buffer is reached once in a while
+        // Boundary : each call reaches the end of a buffer, and one call out of five is split across them
+        long boundarySize = 2 * (frames + frames / 4);
+        for (long c = 0; c < COUNT(kChannels); c++) {
+            long channels = kChannels[c];
+            MeasureHandleBuffer("TBufferedAudioStream::HandleBuffer/read/streaming", HandleBufferRead, data, STREAM_BUFFER_SIZE, frames, channels, channels);
+            MeasureHandleBuffer("TBufferedAudioStream::HandleBuffer/read/boundary", HandleBufferRead, data, boundarySize, frames, channels, channels);
+            MeasureHandleBuffer("TBufferedAudioStream::HandleBuffer/write/streaming", HandleBufferWrite, data, STREAM_BUFFER_SIZE, frames, channels, channels);
+            MeasureHandleBuffer("TBufferedAudioStream::HandleBuffer/write/boundary", HandleBufferWrite, data, boundarySize, frames, channels, channels);
+        }
+        // Mono file read on a stereo output
+        MeasureHandleBuffer("TBufferedAudioStream::HandleBuffer/read/streaming", HandleBufferRead, data, STREAM_BUFFER_SIZE, frames, 1, 2);
+    }
+}
+
+//------------------------------
+// TAudioEffectList::Process
+//------------------------------
+
+// The input is copied first (see ReplaceFrameToFrameBlk1) so that gains repeated on the same buffer do not produce denormals
+static void EffectListProcess(TBenchData* data, long frames, long channelsIn, long channelsOut)
+{
+    UAudioTools::ReplaceFrameToFrameBlk1(data->fOut, data->fIn, frames, channelsOut);
+    ((TAudioEffectList*)data->fObject)->Process(data->fOut, frames, channelsOut);
+}
+
+static void MeasureEffect(const char* name, TBenchData* data, TAudioEffectListPtr list, long channels)
+{
+    data->fObject = (TAudioEffectList*)list;
+    for (long f = 0; f < COUNT(kFrames); f++) {
+        Measure(name, EffectListProcess, data, kFrames[f], channels, channels);
+    }
+}
+
+/*
+Faust effects are not measured: they are compiled at runtime from a DSP given by the application.
+*/
+
+static void BenchEffects(TBenchData* data)
+{
+    static const long effectChannels[] = {1, 2, 4};   // Up to MAX_PLUG_CHANNELS
+
+    for (long c = 0; c < COUNT(effectChannels); c++) {
+        TAudioEffectListPtr list = new TAudioEffectList();
+        list->push_back(new TVolAudioEffect(0.5f));
+        MeasureEffect("TAudioEffectList::Process/TVolAudioEffect", data, list, effectChannels[c]);
+    }
+
+    TAudioEffectListPtr monoPan = new TAudioEffectList();
+    monoPan->push_back(new TMonoPanAudioEffect(0.3f));
+    MeasureEffect("TAudioEffectList::Process/TMonoPanAudioEffect", data, monoPan, 2);
+
+    TAudioEffectListPtr stereoPan = new TAudioEffectList();
+    stereoPan->push_back(new TStereoPanAudioEffect(0.3f, 0.7f));
+    MeasureEffect("TAudioEffectList::Process/TStereoPanAudioEffect", data, stereoPan, 2);
+
+    TAudioEffectListPtr pitchShift = new TAudioEffectList();
+    pitchShift->push_back(new TPitchShiftAudioEffect(1.5f));
+    MeasureEffect("TAudioEffectList::Process/TPitchShiftAudioEffect", data, pitchShift, 2);
+
+    TAudioEffectListPtr chain = new TAudioEffectList();
+    chain->push_back(new TVolAudioEffect(0.5f));
+    chain->push_back(new TStereoPanAudioEffect(0.3f, 0.7f));
+    chain->push_back(new TPitchShiftAudioEffect(1.5f));
+    MeasureEffect("TAudioEffectList::Process/chain", data, chain, 2);
+
+    // Fade in, then playing state : MultFrame per frame
+    TAudioEffectListPtr fade = new TAudioEffectList();
+    fade->push_back(new TVolAudioEffect(0.5f));
+    fade->FadeIn(INT_MAX, INT_MAX);
+    MeasureEffect("TAudioEffectList::Process/TVolAudioEffect/fade", data, fade, 2);
+}
+
+//----------------------------------
+// Resampler and time-stretch streams
+//----------------------------------
+
+/*
+An endless sine source, so that the measured streams do not process silence.
+*/
+
+class TSinusAudioStream : public TAudioStream
+{
+
+    private:
+
+        long fChannels;
+        long fCurFrame;
+
+    public:
+
+        TSinusAudioStream(long channels): fChannels(channels), fCurFrame(0)
+        {}
+        virtual ~TSinusAudioStream()
+        {}
+
+        long Read(FLOAT_BUFFER buffer, long framesNum, long framePos, long channels)
+        {
+            float* frame = buffer->GetFrame(framePos);
+            for (long i = 0; i < framesNum; i++, fCurFrame++) {
+                float sample = 0.5f * sinf(2.f * float(M_PI) * 440.f * float(fCurFrame % SAMPLE_RATE) / float(SAMPLE_RATE));
+                for (long j = 0; j < channels; j++) {
+                    frame[i * channels + j] += sample;
+                }
+            }
+            return framesNum;
+        }
+
+        void Reset()
+        {
+            fCurFrame = 0;
+        }
+        long Length()
+        {
+            return LONG_MAX;
+        }
+        long Channels()
+        {
+            return fChannels;
+        }
+        TAudioStreamPtr Copy()
+        {
+            return new TSinusAudioStream(fChannels);
+        }
+};
+
+struct TStreamData
+{
+    TAudioStreamPtr fStream;
+    FLOAT_BUFFER fBuffer;
+};
+
+static void StreamRead(TBenchData* data, long frames, long channelsIn, long channelsOut)
+{
+    TStreamData* stream = (TStreamData*)data->fObject;
+    stream->fStream->Read(stream->fBuffer, frames, 0, channelsOut);
+}
+
+static void MeasureStream(const char* name, TBenchData* data, TAudioStreamPtr stream, long channels)
+{
+    TStreamData streamData;
+    streamData.fStream = stream;
+    streamData.fBuffer = new TLocalAudioBuffer<float>(BUFFER_SIZE, channels);
+    data->fObject = &streamData;
+    TScratchPlanner::Plan(stream);
+
+    for (long f = 0; f < COUNT(kFrames); f++) {
+        stream->Reset();
+        Measure(name, StreamRead, data, kFrames[f], stream->Channels(), channels);
+    }
+    delete streamData.fBuffer;
+}
+
+static void BenchStreams(TBenchData* data)
+{
+    static const char* qualities[] = {
+        "TSampleRateAudioStream/linear",
+        "TSampleRateAudioStream/zero_order_hold",
+        "TSampleRateAudioStream/sinc_fastest",
+        "TSampleRateAudioStream/sinc_medium",
+        "TSampleRateAudioStream/sinc_best"
+    };
+
+    for (long c = 1; c <= 2; c++) {
+        for (long q = 0; q < COUNT(qualities); q++) {
+            TAudioStreamPtr stream = new TSampleRateAudioStream(new TSinusAudioStream(c), 48000.0 / 44100.0, q);
+            MeasureStream(qualities[q], data, stream, c);
+        }
+    }
+
+    double pitch = 1.0;
+    double stretch = 1.5;
+    TAudioStreamPtr timeStretch = new TRubberBandAudioStream(new TSinusAudioStream(2), &pitch, &stretch);
+    MeasureStream("TRubberBandAudioStream/time_stretch", data, timeStretch, 2);
+
+    double pitch1 = 1.5;
+    double stretch1 = 1.0;
+    TAudioStreamPtr pitchShift = new TRubberBandAudioStream(new TSinusAudioStream(2), &pitch1, &stretch1);
+    MeasureStream("TRubberBandAudioStream/pitch_shift", data, pitchShift, 2);
+}
+
+//-----
+// Main
+//-----
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1 && !(gOut = fopen(argv[1], "w"))) {
+        printf("cannot write %s\n", argv[1]);
+        return 1;
+    }
+
+    TAudioGlobals::Init(2, 2, MAX_CHANNELS, SAMPLE_RATE, BUFFER_SIZE, STREAM_BUFFER_SIZE, SAMPLE_RATE * 10, 1);
+
+    long samples = BUFFER_SIZE * MAX_CHANNELS;
+    TBenchData data;
+    data.fIn = UAudioTools::AlignedCalloc(samples);
+    data.fOut = UAudioTools::AlignedCalloc(samples);
+    data.fShortIn = new short[samples];
+    data.fShortOut = new short[samples];
+    data.fLongOut = new long[samples];
+    memset(data.fLongOut, 0, sizeof(long) * samples);
+    for (int i = 0; i < MAX_CHANNELS; i++) {
+        data.fInPlanes[i] = UAudioTools::AlignedCalloc(BUFFER_SIZE);
+        data.fOutPlanes[i] = UAudioTools::AlignedCalloc(BUFFER_SIZE);
+        Fill(data.fInPlanes[i], BUFFER_SIZE);
+    }
+    data.fGain = 2.0f;
+    data.fObject = 0;
+    Fill(data.fIn, samples);
+    Fill(data.fOut, samples);
+    Fill(data.fShortIn, samples);
+
+    fprintf(gOut, "{\n  \"version\": %ld,\n  \"sample_rate\": %d,\n  \"benchmarks\": [", LibVersion(), SAMPLE_RATE);
+
+    BenchKernels(&data);
+    BenchHandleBuffer(&data);
+    BenchEffects(&data);
+    BenchStreams(&data);
+
+    fprintf(gOut, "\n  ]\n}\n");
+
+    UAudioTools::AlignedFree(data.fIn);
+    UAudioTools::AlignedFree(data.fOut);
+    delete [] data.fShortIn;
+    delete [] data.fShortOut;
+    delete [] data.fLongOut;
+    for (int i = 0; i < MAX_CHANNELS; i++) {
+        UAudioTools::AlignedFree(data.fInPlanes[i]);
+        UAudioTools::AlignedFree(data.fOutPlanes[i]);
+    }
+
+    TAudioGlobals::Destroy();
+    if (gOut != stdout) {
+        fclose(gOut);
+    }
+    return 0;
+}
@@ -0,0 +1,220 @@
+/*
+
+Copyright (C) Grame 2002-2013
+
+This library is free software; you can redistribute it and modify it under
+the terms of the GNU Library General Public License as published by the
+Free Software Foundation version 2 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public License
+for more details.
+
+You should have received a copy of the GNU Library General Public License
+along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+Grame Research Laboratory, 9, rue du Garet 69001 Lyon - France
+research@grame.fr
+
+*/
+
+#include "LibAudioStream++.h"
+#include <sndfile.h>
+#include <stdio.h>
+#include <math.h>
+
+#ifdef WIN32
+	#include <windows.h>
+	#define CheckSleep(ms) Sleep(ms)
+#else
+	#include <unistd.h>
+	#define CheckSleep(ms) usleep(ms * 1000)
+#endif
+
+/*
+Plays main.cpp like scenarios on the null renderer, and reports the calls that may block made
+in the audio thread by each of them. The library has to be built with RT_CHECK (see the rtcheck
+target of the Makefile), otherwise no call is detected.
+*/
+
+#define FILENAME1 "rtcheck1.wav"
+#define FILENAME2 "rtcheck2.wav"
+
+#define IN_CHANNELS 2
+#define OUT_CHANNELS 2
+#define CHANNELS 8
+#define SAMPLE_RATE 44100
+#define PLAY_TIME 2000
+
+static bool MakeTestFile(const char* name, int channels, long frames, float freq)
+{
+    SF_INFO info;
+    info.samplerate = SAMPLE_RATE;
+    info.channels = channels;
+    info.format = SF_FORMAT_WAV | SF_FORMAT_PCM_16;
+
+    SNDFILE* file = sf_open(name, SFM_WRITE, &info);
+    if (!file) {
+        printf("cannot write %s\n", name);
+        return false;
+    }
+
+    float buffer[1024 * 2];
+    for (long pos = 0; pos < frames; pos += 1024) {
+        for (long i = 0; i < 1024; i++) {
+            for (int chan = 0; chan < channels; chan++) {
+                buffer[i * channels + chan] = 0.5f * sinf(2.f * float(M_PI) * freq * float(pos + i) / float(SAMPLE_RATE));
+            }
+        }
+        sf_writef_float(file, buffer, 1024);
+    }
+    sf_close(file);
+    return true;
+}
+
+AudioStream test0()
+{
+    printf("Region\n");
+    return MakeStereoSound(MakeRegionSound(FILENAME1, 20000, 200000));
+}
+
+AudioStream test1()
+{
+    printf("Region with a fade\n");
+    return MakeFadeSound(MakeRegionSound(FILENAME1, 20000, 200000), 10000, 10000);
+}
+
+AudioStream test2()
+{
+    printf("Mix of two regions with a fade\n");
+    AudioStream s1 = MakeRegionSound(FILENAME1, 0, 200000);
+    AudioStream s2 = MakeStereoSound(MakeRegionSound(FILENAME2, 0, 200000));
+    return MakeFadeSound(MakeMixSound(s2, s1), 44100, 44100);
+}
+
+AudioStream test3()
+{
+    printf("Sequence of two regions with a crossfade\n");
+    AudioStream s1 = MakeRegionSound(FILENAME1, 0, 60000);
+    AudioStream s2 = MakeStereoSound(MakeRegionSound(FILENAME2, 0, 100000));
+    return MakeSeqSound(s1, s2, 20000);
+}
+
+AudioStream test4()
+{
+    printf("Loop\n");
+    return MakeLoopSound(MakeRegionSound(FILENAME1, 0, 20000), 4);
+}
+
+AudioStream test5()
+{
+    printf("Mix of delayed regions\n");
+    AudioStream mix = MakeNullSound(100);
+    for (int i = 0; i < 8; i++) {
+        AudioStream sound = MakeSeqSound(MakeNullSound(i * 4410), MakeStereoSound(MakeRegionSound(FILENAME2, 20000, 60000)), 0);
+        mix = MakeMixSound(sound, mix);
+    }
+    return mix;
+}
+
+AudioStream test6()
+{
+    printf("Multi mix and timeline\n");
+    AudioStream sounds[4];
+    long starts[4];
+    for (int i = 0; i < 4; i++) {
+        sounds[i] = MakeRegionSound(FILENAME1, i * 10000, i * 10000 + 40000);
+        starts[i] = i * 11025;
+    }
+    AudioStream mix[2];
+    mix[0] = MakeMultiMixSound(sounds, 2);
+    mix[1] = MakeTimelineSound(sounds + 2, starts + 2, 2, 44100);
+    return MakeMultiMixSound(mix, 2);
+}
+
+AudioStream test7()
+{
+    printf("Transform with volume and pan effects\n");
+    AudioEffectList list_effect = MakeAudioEffectList();
+    list_effect = AddAudioEffect(list_effect, MakeVolAudioEffect(0.5f));
+    list_effect = AddAudioEffect(list_effect, MakeStereoPanAudioEffect(0.2f, 0.8f));
+    AudioStream sound1 = MakeRegionSound(FILENAME1, 0, 60000);
+    AudioStream sound2 = MakeRegionSound(FILENAME1, 60000, 120000);
+    return MakeSeqSound(sound1, MakeTransformSound(sound2, list_effect, 100, 100), 44100);
+}
+
+AudioStream test8()
+{
+    printf("Transform with a pitch shift effect\n");
+    AudioEffectList list_effect = MakeAudioEffectList();
+    list_effect = AddAudioEffect(list_effect, MakePitchShiftAudioEffect(0.8f));
+    return MakeTransformSound(MakeStereoSound(MakeRegionSound(FILENAME2, 0, 100000)), list_effect, 100, 100);
+}
+
+AudioStream test9()
+{
+    printf("Input\n");
+    return MakeCutSound(MakeInputSound(), 0, 88200);
+}
+
+static long ExecTest(AudioPlayerPtr player, AudioStream sound)
+{
+    if (LoadChannel(player, sound, 1, 1.0f, 1.0f, 0.0f) != NO_ERR) {
+        printf("LoadChannel error\n");
+        return 0;
+    }
+
+    // Control changes while playing, as with the main.cpp keyboard commands
+    StartChannel(player, 1);
+    CheckSleep(PLAY_TIME / 2);
+    SetVolChannel(player, 1, 0.5f);
+    StopChannel(player, 1);
+    ContChannel(player, 1);
+    CheckSleep(PLAY_TIME / 2);
+    StopChannel(player, 1);
+    CheckSleep(100);
+
+    long violations = ReportRTViolations();
+    printf("%ld calls in the audio thread\n\n", violations);
+    return violations;
+}
+
+int main(int argc, char* argv[])
+{
+    printf("-------------------------------------------\n");
+    printf("LibAudioStream audio thread real-time check\n");
+    printf("-------------------------------------------\n\n");
+
+    if (!MakeTestFile(FILENAME1, 2, SAMPLE_RATE * 10, 440.f) || !MakeTestFile(FILENAME2, 1, SAMPLE_RATE * 5, 660.f)) {
+        return 1;
+    }
+
+    AudioPlayerPtr player = OpenAudioPlayer(IN_CHANNELS, OUT_CHANNELS, CHANNELS, SAMPLE_RATE, 512, 65536, 131072, kNullRenderer, 1);
+    if (!player) {
+        printf("cannot open the null renderer\n");
+        return 1;
+    }
+
+    StartAudioPlayer(player);
+    CheckSleep(100);
+    long violations = ReportRTViolations();
+
+    violations += ExecTest(player, test0());
+    violations += ExecTest(player, test1());
+    violations += ExecTest(player, test2());
+    violations += ExecTest(player, test3());
+    violations += ExecTest(player, test4());
+    violations += ExecTest(player, test5());
+    violations += ExecTest(player, test6());
+    violations += ExecTest(player, test7());
+    violations += ExecTest(player, test8());
+    violations += ExecTest(player, test9());
+
+    StopAudioPlayer(player);
+    CloseAudioPlayer(player);
+
+    printf("Total : %ld calls in the audio thread\n", violations);
+    return (violations > 0) ? 1 : 0;
+}
@@ -23,11 +23,22 @@ research@grame.fr
 #include "TAudioEngine.h"
 #include "TAudioRendererFactory.h"
 #include "TAudioStreamFactory.h"
+#include "TAudioGlobals.h"
 #include "TVolAudioEffect.h"
 #include "TPitchShiftAudioEffect.h"
 #include "TPanAudioEffect.h"
 #include "TFaustAudioEffect.h"
 #include "TWrapperAudioEffect.h"
+#include "TSndFilePool.h"
+#include "TLoadAudioStream.h"
+#include "TFileRenderer.h"
+#include "TBatchRenderer.h"
+#include "TThreadCmdManager.h"
+#include "TNullAudioRenderer.h"
+#include "TProfileAudioStream.h"
+#include "TTraceRecorder.h"
+#include "TAudioLog.h"
+#include "TRTChecker.h"
 
 #ifdef WIN32
 	#define	AUDIOAPI __declspec(dllexport)
@@ -46,6 +57,7 @@ research@grame.fr
 	typedef AudioStream* AudioStreamPtr;
 
 	typedef TAudioRenderer* AudioRendererPtr;	
+	typedef TAudioContext* AudioContextPtr;
 	typedef TAudioClient* AudioClientPtr;
 
  	typedef TAudioEffectListPtr AudioEffectList;	// smart pointer type
@@ -56,6 +68,8 @@ research@grame.fr
 	typedef TAudioEffectInterface* AudioEffectInterfacePtr;
 	
 	typedef void (*StopCallback)(void* context);
+	typedef void (*LoadCallback)(void* context, long index, long state);
+	typedef void (*LogCallback)(void* context, const char* message);
 
 #ifdef __cplusplus
 extern "C"
@@ -63,6 +77,7 @@ extern "C"
 #endif
 
 	long AUDIOAPI LibVersion();
+	long AUDIOAPI GetRemovedSoundCount();
 		
 	// Device scanning
 	long AUDIOAPI GetDeviceCount(AudioRendererPtr renderer);
@@ -77,33 +92,46 @@ extern "C"
 	AudioStreamPtr AUDIOAPI MakeNullSoundPtr(long lengthFrame);
     AudioStreamPtr AUDIOAPI MakeReadSoundPtr(char* name);
     AudioStreamPtr AUDIOAPI MakeRegionSoundPtr(char* name, long beginFrame, long endFrame);
+    AudioStreamPtr AUDIOAPI MakeLoadSoundPtr(char* name, long beginFrame, long endFrame, LoadCallback callback, void* context);
+    void AUDIOAPI MakeLoadSoundsPtr(char** names, long count, AudioStreamPtr* sounds, LoadCallback callback, void* context);
 	AudioStreamPtr AUDIOAPI	MakeStereoSoundPtr(AudioStreamPtr sound);
     AudioStreamPtr AUDIOAPI MakeFadeSoundPtr(AudioStreamPtr sound, long fadeIn, long fadeOut);
     AudioStreamPtr AUDIOAPI MakeLoopSoundPtr(AudioStreamPtr sound, long n);
     AudioStreamPtr AUDIOAPI MakeCutSoundPtr(AudioStreamPtr sound, long beginFrame, long endFrame);
     AudioStreamPtr AUDIOAPI MakeSeqSoundPtr(AudioStreamPtr s1, AudioStreamPtr s2, long crossFade);
     AudioStreamPtr AUDIOAPI MakeMixSoundPtr(AudioStreamPtr s1, AudioStreamPtr s2);
+    AudioStreamPtr AUDIOAPI MakeMultiMixSoundPtr(AudioStreamPtr* sounds, long count);
+    AudioStreamPtr AUDIOAPI MakeTimelineSoundPtr(AudioStreamPtr* sounds, long* starts, long count, long lookahead);
     AudioStreamPtr AUDIOAPI MakeTransformSoundPtr(AudioStreamPtr sound, AudioEffectListPtr effect_list, long fadeIn, long fadeOut);
 	AudioStreamPtr AUDIOAPI MakeRubberBandSoundPtr(AudioStreamPtr sound, double* pitch_shift, double* time_strech);
+    AudioStreamPtr AUDIOAPI MakeAsyncSoundPtr(AudioStreamPtr sound, long ahead);
     AudioStreamPtr AUDIOAPI MakeWriteSoundPtr(char* name, AudioStreamPtr s, long format);
     AudioStreamPtr AUDIOAPI MakeInputSoundPtr();
     AudioStreamPtr AUDIOAPI MakeRendererSoundPtr(AudioStreamPtr s);
+    AudioStreamPtr AUDIOAPI MakeProfileSoundPtr(AudioStreamPtr s);
 
     long AUDIOAPI GetLengthSoundPtr(AudioStreamPtr s);
     long AUDIOAPI GetChannelsSoundPtr(AudioStreamPtr s);
+    long AUDIOAPI GetLoadStateSoundPtr(AudioStreamPtr s);
     long AUDIOAPI ReadSoundPtr(AudioStreamPtr stream, float* buffer, long buffer_size, long channels);
 	void AUDIOAPI ResetSoundPtr(AudioStreamPtr sound);
+    long AUDIOAPI RenderToFilePtr(AudioStreamPtr sound, char* name, long format, long blockSize, float* framesPerSec);
+    long AUDIOAPI RenderToFilesPtr(AudioStreamPtr* sounds, char** names, long count, long format, long blockSize, long threads, long* results);
+    long AUDIOAPI DumpProfileSoundPtr(AudioStreamPtr sound, char* buffer, long size);
+    void AUDIOAPI ResetProfileSoundPtr(AudioStreamPtr sound);
 
 	AudioEffectListPtr AUDIOAPI MakeAudioEffectListPtr();
     AudioEffectListPtr AUDIOAPI AddAudioEffectPtr(AudioEffectListPtr list_effect, AudioEffectPtr effect);
     AudioEffectListPtr AUDIOAPI RemoveAudioEffectPtr(AudioEffectListPtr list_effect, AudioEffectPtr effect);
 	AudioEffectListPtr AUDIOAPI ClearAudioEffectListPtr(AudioEffectListPtr list_effect);
+	AudioEffectListPtr AUDIOAPI FuseAudioEffectListPtr(AudioEffectListPtr list_effect);
 
     AudioEffectPtr AUDIOAPI MakeVolAudioEffectPtr(float vol);
 	AudioEffectPtr AUDIOAPI MakeMonoPanAudioEffectPtr(float pan);
 	AudioEffectPtr AUDIOAPI MakeStereoPanAudioEffectPtr(float panLeft, float panRight);
 	AudioEffectPtr AUDIOAPI MakePitchShiftAudioEffectPtr(float pitch);
 	AudioEffectPtr AUDIOAPI MakeFaustAudioEffectPtr(const char* name);
+	AudioEffectPtr AUDIOAPI MakeFaustAudioEffectWithOptionsPtr(const char* name, const char* options);
 	AudioEffectPtr AUDIOAPI MakeWrapperAudioEffectPtr(AudioEffectInterfacePtr effect);
 
 	long AUDIOAPI GetControlCountEffectPtr(AudioEffectPtr effect);
@@ -122,6 +150,15 @@ extern "C"
 
 	  // Open/Close
 	void AUDIOAPI SetAudioLatencies(long inputLatency, long outputLatency);
+	void AUDIOAPI SetPrefetchHorizon(long frames);
+	void AUDIOAPI SetFileHandleBudget(long count);
+	void AUDIOAPI SetProfileSampling(long n);
+	void AUDIOAPI SetLogCallback(LogCallback callback, void* context);
+	void AUDIOAPI SetLogRate(long rate);
+	AudioContextPtr AUDIOAPI MakeAudioContext(long inChan, long outChan, long channels, long sample_rate,
+											  long buffer_size, long stream_buffer_size, long rtstream_buffer_size);
+	void AUDIOAPI DeleteAudioContext(AudioContextPtr context);
+	void AUDIOAPI SetAudioContext(AudioContextPtr context);
     AudioPlayerPtr AUDIOAPI OpenAudioPlayer(long inChan, 
                                             long outChan, 
                                             long channels, 
@@ -175,6 +212,13 @@ extern "C"
 	void AUDIOAPI StartAudioRenderer(AudioRendererPtr renderer); 
     void AUDIOAPI StartAudioRenderer(AudioRendererPtr renderer); 
     void AUDIOAPI GetAudioRendererInfo(AudioRendererPtr renderer, RendererInfoPtr info); 
+	long AUDIOAPI SetAudioRendererCapture(AudioRendererPtr renderer, char* name, long format);
+	long AUDIOAPI GetAudioRendererStats(AudioRendererPtr renderer, long client, TimingStatsPtr stats);
+	void AUDIOAPI ResetAudioRendererStats(AudioRendererPtr renderer);
+	void AUDIOAPI StartTrace(long events);
+	void AUDIOAPI StopTrace();
+	long AUDIOAPI DumpTrace(char* name);
+	long AUDIOAPI ReportRTViolations();
 	
 	void AUDIOAPI AddAudioClient(AudioRendererPtr renderer, AudioClientPtr client); 
 	void AUDIOAPI RemoveAudioClient(AudioRendererPtr renderer, AudioClientPtr client); 
@@ -198,34 +242,47 @@ extern "C"
 AudioStream AUDIOAPI MakeNullSound(long lengthFrame);
 AudioStream AUDIOAPI MakeReadSound(char* name);
 AudioStream AUDIOAPI MakeRegionSound(char* name, long beginFrame, long endFrame);
+AudioStream AUDIOAPI MakeLoadSound(char* name, long beginFrame, long endFrame, LoadCallback callback, void* context);
+void AUDIOAPI MakeLoadSounds(char** names, long count, AudioStream* sounds, LoadCallback callback, void* context);
 AudioStream AUDIOAPI MakeStereoSound(AudioStream sound);
 AudioStream AUDIOAPI MakeFadeSound(AudioStream sound, long fadeIn, long fadeOut);
 AudioStream AUDIOAPI MakeLoopSound(AudioStream sound, long n);
 AudioStream AUDIOAPI MakeCutSound(AudioStream sound, long beginFrame, long endFrame);
 AudioStream AUDIOAPI MakeSeqSound(AudioStream s1, AudioStream s2, long crossFade);
 AudioStream AUDIOAPI MakeMixSound(AudioStream s1, AudioStream s2);
+AudioStream AUDIOAPI MakeMultiMixSound(AudioStream* sounds, long count);
+AudioStream AUDIOAPI MakeTimelineSound(AudioStream* sounds, long* starts, long count, long lookahead);
 AudioStream AUDIOAPI MakeTransformSound(AudioStream sound, AudioEffectList effect_list, long fadeIn, long fadeOut);
 AudioStream AUDIOAPI MakeRubberBandSound(AudioStreamPtr sound, double* pitch_shift, double* time_strech);
+AudioStream AUDIOAPI MakeAsyncSound(AudioStream sound, long ahead);
 AudioStream AUDIOAPI MakeWriteSound(char* name, AudioStream s, long format);
 AudioStream AUDIOAPI MakeInputSound();
 AudioStream AUDIOAPI MakeRendererSound(AudioStream s);
+AudioStream AUDIOAPI MakeProfileSound(AudioStream s);
 
 long AUDIOAPI GetLengthSound(AudioStream s);
 long AUDIOAPI GetChannelsSound(AudioStream s);
+long AUDIOAPI GetLoadStateSound(AudioStream s);
 long AUDIOAPI ReadSound(AudioStream stream, float* buffer, long buffer_size, long channels);
 void AUDIOAPI ResetSound(AudioStream sound);
+long AUDIOAPI RenderToFile(AudioStream sound, char* name, long format, long blockSize, float* framesPerSec);
+long AUDIOAPI RenderToFiles(AudioStream* sounds, char** names, long count, long format, long blockSize, long threads, long* results);
+long AUDIOAPI DumpProfileSound(AudioStream sound, char* buffer, long size);
+void AUDIOAPI ResetProfileSound(AudioStream sound);
 
 // Effect management (using smartptr)
 AudioEffectList AUDIOAPI MakeAudioEffectList();
 AudioEffectList AUDIOAPI AddAudioEffect(AudioEffectList list_effect, AudioEffect effect);
 AudioEffectList AUDIOAPI RemoveAudioEffect(AudioEffectList list_effect, AudioEffect effect);
 AudioEffectList AUDIOAPI ClearAudioEffectList(AudioEffectList list_effect);
+AudioEffectList AUDIOAPI FuseAudioEffectList(AudioEffectList list_effect);
 
 AudioEffect AUDIOAPI MakeVolAudioEffect(float vol);
 AudioEffect AUDIOAPI MakeMonoPanAudioEffect(float pan);
 AudioEffect AUDIOAPI MakeStereoPanAudioEffect(float panLeft, float panRight);
 AudioEffect AUDIOAPI MakePitchShiftAudioEffect(float pitch);
 AudioEffect AUDIOAPI MakeFaustAudioEffect(const char* name);
+AudioEffect AUDIOAPI MakeFaustAudioEffectWithOptions(const char* name, const char* options);
 
 long AUDIOAPI GetControlCountEffect(AudioEffect effect);
 void AUDIOAPI GetControlParamEffect(AudioEffect effect, long param, char* label, float* min, float* max, float* init);
@@ -243,6 +300,11 @@ long LibVersion()
 	return 126;
 }
 
+long AUDIOAPI GetRemovedSoundCount()
+{
+	return TAudioStreamFactory::GetRemovedNodes();
+}
+
 AudioStream AUDIOAPI MakeNullSound(long lengthFrame)
 {
 	return TAudioStreamFactory::MakeNullSound(lengthFrame);
@@ -258,6 +320,24 @@ AudioStream AUDIOAPI MakeRegionSound(char* name, long beginFrame, long endFrame)
     return TAudioStreamFactory::MakeRegionSound(name, beginFrame, endFrame);
 }
 
+AudioStream AUDIOAPI MakeLoadSound(char* name, long beginFrame, long endFrame, LoadCallback callback, void* context)
+{
+    return TAudioStreamFactory::MakeLoadSound(name, beginFrame, endFrame, callback, context);
+}
+
+void AUDIOAPI MakeLoadSounds(char** names, long count, AudioStream* sounds, LoadCallback callback, void* context)
+{
+    std::vector<string> files;
+    std::vector<TAudioStreamPtr> streams;
+    for (long i = 0; names && sounds && i < count; i++) {
+        files.push_back(names[i]);
+    }
+    TAudioStreamFactory::MakeLoadSounds(files, streams, callback, context);
+    for (unsigned int i = 0; i < streams.size(); i++) {
+        sounds[i] = streams[i];
+    }
+}
+
 AudioStream AUDIOAPI MakeStereoSound(AudioStream sound)
 {
 	return TAudioStreamFactory::MakeStereoSound(sound);
@@ -288,6 +368,26 @@ AudioStream AUDIOAPI MakeMixSound(AudioStream s1, AudioStream s2)
     return TAudioStreamFactory::MakeMixSound(static_cast<TAudioStreamPtr>(s1), static_cast<TAudioStreamPtr>(s2));
 }
 
+AudioStream AUDIOAPI MakeMultiMixSound(AudioStream* sounds, long count)
+{
+    std::vector<TAudioStreamPtr> streams;
+    for (long i = 0; sounds && i < count; i++) {
+        streams.push_back(static_cast<TAudioStreamPtr>(sounds[i]));
+    }
+    return TAudioStreamFactory::MakeMultiMixSound(streams);
+}
+
+AudioStream AUDIOAPI MakeTimelineSound(AudioStream* sounds, long* starts, long count, long lookahead)
+{
+    std::vector<TAudioStreamPtr> streams;
+    std::vector<long> frames;
+    for (long i = 0; sounds && starts && i < count; i++) {
+        streams.push_back(static_cast<TAudioStreamPtr>(sounds[i]));
+        frames.push_back(starts[i]);
+    }
+    return TAudioStreamFactory::MakeTimelineSound(streams, frames, lookahead);
+}
+
 AudioStream AUDIOAPI MakeInputSound()
 {
     return TAudioStreamFactory::MakeInputSound();
@@ -310,6 +410,11 @@ AudioStream AUDIOAPI MakePitchSchiftTimeStretchSound(AudioStream s1, double* pit
     */
 }
 
+AudioStream AUDIOAPI MakeAsyncSound(AudioStream s1, long ahead)
+{
+    return TAudioStreamFactory::MakeAsyncSound(static_cast<TAudioStreamPtr>(s1), ahead);
+}
+
 AudioStream AUDIOAPI MakeWriteSound(char* name, AudioStream s, long format)
 {
     return TAudioStreamFactory::MakeWriteSound(name, static_cast<TAudioStreamPtr>(s), format);
@@ -320,6 +425,11 @@ AudioStream AUDIOAPI MakeRendererSound(AudioStream s)
     return TAudioStreamFactory::MakeDTRenderer(static_cast<TAudioStreamPtr>(s));
 }
 
+AudioStream AUDIOAPI MakeProfileSound(AudioStream s)
+{
+    return TAudioStreamFactory::MakeProfileSound(static_cast<TAudioStreamPtr>(s));
+}
+
 long AUDIOAPI GetLengthSound(AudioStream s)
 {
     return (s) ? (static_cast<TAudioStreamPtr>(s))->Length() : 0;
@@ -330,6 +440,15 @@ long AUDIOAPI GetChannelsSound(AudioStream s)
     return (s) ? (static_cast<TAudioStreamPtr>(s))->Channels() : 0;
 }
 
+long AUDIOAPI GetLoadStateSound(AudioStream s)
+{
+    TLoadAudioStreamPtr load = dynamic_cast<TLoadAudioStreamPtr>(static_cast<TAudioStreamPtr>(s).getPointer());
+    if (!s) {
+        return -1;
+    }
+    return (load) ? load->GetState() : TLoadAudioStream::kReady;
+}
+
 long AUDIOAPI ReadSound(AudioStream sound, float* buffer, long buffer_size, long channels)
 {
     if (sound && buffer) {
@@ -346,6 +465,65 @@ void AUDIOAPI ResetSound(AudioStream sound)
 	static_cast<TAudioStreamPtr>(sound)->Reset();
 }
 
+long AUDIOAPI RenderToFile(AudioStream sound, char* name, long format, long blockSize, float* framesPerSec)
+{
+    if (sound && name) {
+        // Blocks are encoded by a dedicated thread
+        TThreadCmdManager encoder(1);
+        TFileRenderer renderer(&encoder);
+        return renderer.Render(static_cast<TAudioStreamPtr>(sound), name, format, blockSize, framesPerSec);
+    } else {
+        return -1;
+    }
+}
+
+long AUDIOAPI RenderToFiles(AudioStream* sounds, char** names, long count, long format, long blockSize, long threads, long* results)
+{
+    if (sounds && names) {
+        for (long i = 0; i < count; i++) {
+            if (!sounds[i] || !names[i]) {
+                printf("RenderToFiles : null stream or name for file %ld\n", i);
+                for (long j = 0; results && j < count; j++) {
+                    results[j] = -1;
+                }
+                return -1;
+            }
+        }
+        TThreadCmdManager workers((threads > 0) ? threads : UTools::GetCPUCount());
+        TBatchRenderer batch(format, blockSize);
+        for (long i = 0; i < count; i++) {
+            batch.AddJob(static_cast<TAudioStreamPtr>(sounds[i]), names[i]);
+        }
+        long rendered = batch.Render(&workers);
+        for (long i = 0; results && i < count; i++) {
+            results[i] = batch.GetResult(i);
+        }
+        return rendered;
+    } else {
+        return 0;
+    }
+}
+
+long AUDIOAPI DumpProfileSound(AudioStream sound, char* buffer, long size)
+{
+    if (sound) {
+        string dump = TProfiler::Dump(static_cast<TAudioStreamPtr>(sound));
+        if (buffer && size > 0) {
+            long len = UTools::Min(long(dump.size()), size - 1);
+            dump.copy(buffer, len);
+            buffer[len] = 0;
+        }
+        return long(dump.size());
+    } else {
+        return 0;
+    }
+}
+
+void AUDIOAPI ResetProfileSound(AudioStream sound)
+{
+    TProfiler::Reset(static_cast<TAudioStreamPtr>(sound));
+}
+
 AudioStreamPtr AUDIOAPI MakeSoundPtr(AudioStream sound) 
 {
 	return new LA_SMARTP<TAudioStream>(sound);
@@ -373,6 +551,25 @@ AudioStreamPtr AUDIOAPI MakeRegionSoundPtr(char* name, long beginFrame, long end
 	return (sound) ? MakeSoundPtr(sound) : 0;
 }
 
+AudioStreamPtr AUDIOAPI MakeLoadSoundPtr(char* name, long beginFrame, long endFrame, LoadCallback callback, void* context)
+{
+	AudioStream sound = TAudioStreamFactory::MakeLoadSound(name, beginFrame, endFrame, callback, context);
+	return (sound) ? MakeSoundPtr(sound) : 0;
+}
+
+void AUDIOAPI MakeLoadSoundsPtr(char** names, long count, AudioStreamPtr* sounds, LoadCallback callback, void* context)
+{
+    std::vector<string> files;
+    std::vector<TAudioStreamPtr> streams;
+    for (long i = 0; names && sounds && i < count; i++) {
+        files.push_back(names[i]);
+    }
+    TAudioStreamFactory::MakeLoadSounds(files, streams, callback, context);
+    for (unsigned int i = 0; i < streams.size(); i++) {
+        sounds[i] = MakeSoundPtr(streams[i]);
+    }
+}
+
 AudioStreamPtr AUDIOAPI MakeStereoSoundPtr(AudioStreamPtr sound)
 {
 	return (sound) ? MakeSoundPtr(TAudioStreamFactory::MakeStereoSound(static_cast<TAudioStreamPtr>(*sound))) : 0;
@@ -408,6 +605,33 @@ AudioStreamPtr AUDIOAPI MakeMixSoundPtr(AudioStreamPtr s1, AudioStreamPtr s2)
     return (s1 && s2) ? MakeSoundPtr(TAudioStreamFactory::MakeMixSound(static_cast<TAudioStreamPtr>(*s1), static_cast<TAudioStreamPtr>(*s2))) : 0;
 }
 
+AudioStreamPtr AUDIOAPI MakeMultiMixSoundPtr(AudioStreamPtr* sounds, long count)
+{
+    std::vector<TAudioStreamPtr> streams;
+    for (long i = 0; sounds && i < count; i++) {
+        if (!sounds[i]) {
+            return 0;
+        }
+        streams.push_back(static_cast<TAudioStreamPtr>(*sounds[i]));
+    }
+    return (streams.size() > 0) ? MakeSoundPtr(TAudioStreamFactory::MakeMultiMixSound(streams)) : 0;
+}
+
+AudioStreamPtr AUDIOAPI MakeTimelineSoundPtr(AudioStreamPtr* sounds, long* starts, long count, long lookahead)
+{
+    std::vector<TAudioStreamPtr> streams;
+    std::vector<long> frames;
+    for (long i = 0; sounds && starts && i < count; i++) {
+        if (!sounds[i]) {
+            return 0;
+        }
+        streams.push_back(static_cast<TAudioStreamPtr>(*sounds[i]));
+        frames.push_back(starts[i]);
+    }
+    TAudioStreamPtr sound = TAudioStreamFactory::MakeTimelineSound(streams, frames, lookahead);
+    return (sound) ? MakeSoundPtr(sound) : 0;
+}
+
 AudioStreamPtr AUDIOAPI MakeInputSoundPtr()
 {
     return MakeSoundPtr(TAudioStreamFactory::MakeInputSound());
@@ -432,6 +656,11 @@ AudioStreamPtr AUDIOAPI MakePitchSchiftTimeStretchSoundPtr(AudioStream sound, do
     */
 }
 
+AudioStreamPtr AUDIOAPI MakeAsyncSoundPtr(AudioStreamPtr sound, long ahead)
+{
+    return (sound) ? MakeSoundPtr(TAudioStreamFactory::MakeAsyncSound(static_cast<TAudioStreamPtr>(*sound), ahead)) : 0;
+}
+
 AudioStreamPtr AUDIOAPI MakeWriteSoundPtr(char* name, AudioStreamPtr sound, long format)
 {
     return (sound) ? MakeSoundPtr(TAudioStreamFactory::MakeWriteSound(name, static_cast<TAudioStreamPtr>(*sound), format)) : 0;
@@ -442,6 +671,11 @@ AudioStreamPtr AUDIOAPI MakeRendererSoundPtr(AudioStreamPtr sound)
     return (sound) ? MakeSoundPtr(TAudioStreamFactory::MakeDTRenderer(static_cast<TAudioStreamPtr>(*sound))) : 0;
 }
 
+AudioStreamPtr AUDIOAPI MakeProfileSoundPtr(AudioStreamPtr sound)
+{
+    return (sound) ? MakeSoundPtr(TAudioStreamFactory::MakeProfileSound(static_cast<TAudioStreamPtr>(*sound))) : 0;
+}
+
 long AUDIOAPI GetLengthSoundPtr(AudioStreamPtr sound)
 {
     return (sound) ? (static_cast<TAudioStreamPtr>(*sound))->Length() : 0;
@@ -452,11 +686,47 @@ long AUDIOAPI GetChannelsSoundPtr(AudioStreamPtr sound)
     return (sound) ? (static_cast<TAudioStreamPtr>(*sound))->Channels() : 0;
 }
 
+long AUDIOAPI GetLoadStateSoundPtr(AudioStreamPtr sound)
+{
+    return (sound) ? GetLoadStateSound(*sound) : -1;
+}
+
 void AUDIOAPI ResetSoundPtr(AudioStreamPtr sound)
 {
 	static_cast<TAudioStreamPtr>(*sound)->Reset();
 }
 
+long AUDIOAPI RenderToFilePtr(AudioStreamPtr sound, char* name, long format, long blockSize, float* framesPerSec)
+{
+    return (sound) ? RenderToFile(*sound, name, format, blockSize, framesPerSec) : -1;
+}
+
+long AUDIOAPI RenderToFilesPtr(AudioStreamPtr* sounds, char** names, long count, long format, long blockSize, long threads, long* results)
+{
+    if (sounds) {
+        std::vector<AudioStream> streams;
+        for (long i = 0; i < count; i++) {
+            // Null entries are reported by RenderToFiles
+            streams.push_back((sounds[i]) ? *sounds[i] : AudioStream());
+        }
+        return (count > 0) ? RenderToFiles(&streams[0], names, count, format, blockSize, threads, results) : 0;
+    } else {
+        return 0;
+    }
+}
+
+long AUDIOAPI DumpProfileSoundPtr(AudioStreamPtr sound, char* buffer, long size)
+{
+    return (sound) ? DumpProfileSound(*sound, buffer, size) : 0;
+}
+
+void AUDIOAPI ResetProfileSoundPtr(AudioStreamPtr sound)
+{
+    if (sound) {
+        ResetProfileSound(*sound);
+    }
+}
+
 long AUDIOAPI ReadSoundPtr(AudioStreamPtr sound, float* buffer, long buffer_size, long channels)
 {
     if (sound && buffer) {
@@ -477,7 +747,8 @@ AudioEffectList AUDIOAPI MakeAudioEffectList()
 AudioEffectList AUDIOAPI AddAudioEffect(AudioEffectList list_effect, AudioEffect effect)
 {
     if (list_effect && effect) {
-       static_cast<TAudioEffectListPtr>(list_effect)->push_back(static_cast<TAudioEffectInterfacePtr>(effect));
+       static_cast<TAudioEffectListPtr>(list_effect)->Unfuse();
+        static_cast<TAudioEffectListPtr>(list_effect)->push_back(static_cast<TAudioEffectInterfacePtr>(effect));
     }
     return list_effect;
 }
@@ -485,6 +756,7 @@ AudioEffectList AUDIOAPI AddAudioEffect(AudioEffectList list_effect, AudioEffect
 AudioEffectList AUDIOAPI RemoveAudioEffect(AudioEffectList list_effect, AudioEffect effect)
 {
     if (list_effect && effect) {
+        static_cast<TAudioEffectListPtr>(list_effect)->Unfuse();
         static_cast<TAudioEffectListPtr>(list_effect)->remove(static_cast<TAudioEffectInterfacePtr>(effect));
     }
     return list_effect;
@@ -493,11 +765,20 @@ AudioEffectList AUDIOAPI RemoveAudioEffect(AudioEffectList list_effect, AudioEff
 AudioEffectList AUDIOAPI ClearAudioEffectList(AudioEffectList list_effect)
 {
 	if (list_effect) {
+        static_cast<TAudioEffectListPtr>(list_effect)->Unfuse();
         static_cast<TAudioEffectListPtr>(list_effect)->clear();
     }
     return list_effect;
 }
 
+AudioEffectList AUDIOAPI FuseAudioEffectList(AudioEffectList list_effect)
+{
+	if (list_effect && !static_cast<TAudioEffectListPtr>(list_effect)->Fuse()) {
+        printf("FuseAudioEffectList : effect list cannot be fused\n");
+    }
+    return list_effect;
+}
+
 AudioEffect AUDIOAPI MakeVolAudioEffect(float vol)
 {
     return new TVolAudioEffect(vol);
@@ -533,6 +814,16 @@ AudioEffect AUDIOAPI MakeFaustAudioEffect(const char* name)
 	}
 }
 
+AudioEffect AUDIOAPI MakeFaustAudioEffectWithOptions(const char* name, const char* options)
+{
+	try {
+		return new TCodeFaustAudioEffect(name, (options) ? options : "");
+	} catch (int n) {
+		printf("TCodeFaustAudioEffect exception %d \n", n);
+		return 0;
+	}
+}
+
 long AUDIOAPI GetControlCountEffect(AudioEffect effect) 
 {
 	return static_cast<TAudioEffectInterfacePtr>(effect)->GetControlCount();
@@ -592,6 +883,7 @@ AudioEffectListPtr AUDIOAPI MakeAudioEffectListPtr()
 AudioEffectListPtr AUDIOAPI AddAudioEffectPtr(AudioEffectListPtr list_effect, AudioEffectPtr effect)
 {
     if (list_effect && effect) {
+        static_cast<TAudioEffectListPtr>(*list_effect)->Unfuse();
         static_cast<TAudioEffectListPtr>(*list_effect)->push_back(static_cast<TAudioEffectInterfacePtr>(*effect));
     }
     return list_effect;
@@ -600,6 +892,7 @@ AudioEffectListPtr AUDIOAPI AddAudioEffectPtr(AudioEffectListPtr list_effect, Au
 AudioEffectListPtr AUDIOAPI RemoveAudioEffectPtr(AudioEffectListPtr list_effect, AudioEffectPtr effect)
 {
     if (list_effect && effect) {
+        static_cast<TAudioEffectListPtr>(*list_effect)->Unfuse();
         static_cast<TAudioEffectListPtr>(*list_effect)->remove(static_cast<TAudioEffectInterfacePtr>(*effect));
     }
     return list_effect;
@@ -608,11 +901,20 @@ AudioEffectListPtr AUDIOAPI RemoveAudioEffectPtr(AudioEffectListPtr list_effect,
 AudioEffectListPtr AUDIOAPI ClearAudioEffectListPtr(AudioEffectListPtr list_effect)
 {
 	if (list_effect) {
+        static_cast<TAudioEffectListPtr>(*list_effect)->Unfuse();
         static_cast<TAudioEffectListPtr>(*list_effect)->clear();
     }
     return list_effect;
 }
 
+AudioEffectListPtr AUDIOAPI FuseAudioEffectListPtr(AudioEffectListPtr list_effect)
+{
+	if (list_effect && !static_cast<TAudioEffectListPtr>(*list_effect)->Fuse()) {
+        printf("FuseAudioEffectListPtr : effect list cannot be fused\n");
+    }
+    return list_effect;
+}
+
 AudioEffectPtr AUDIOAPI MakeVolAudioEffectPtr(float vol)
 {
     return new LA_SMARTP<TAudioEffectInterface>(new TVolAudioEffect(vol));
@@ -648,6 +950,16 @@ AudioEffectPtr AUDIOAPI MakeFaustAudioEffectPtr(const char* name)
 	}
 }
 
+AudioEffectPtr AUDIOAPI MakeFaustAudioEffectWithOptionsPtr(const char* name, const char* options)
+{
+	try {
+		return new LA_SMARTP<TAudioEffectInterface>(new TCodeFaustAudioEffect(name, (options) ? options : ""));
+	} catch (int n) {
+		printf("TCodeFaustAudioEffect exception %d \n", n);
+		return 0;
+	}
+}
+
 AudioEffectPtr AUDIOAPI MakeWrapperAudioEffectPtr(AudioEffectInterfacePtr effect)
 {
     return new LA_SMARTP<TAudioEffectInterface>(new TWrapperAudioEffect(static_cast<TAudioEffectInterface*>(effect)));
@@ -701,6 +1013,52 @@ void AUDIOAPI SetAudioLatencies(long inputLatency, long outputLatency)
 	TAudioGlobals::fOutputLatency = outputLatency;
 }
 
+void AUDIOAPI SetPrefetchHorizon(long frames)
+{
+	TAudioContext::GetCurrent()->fHorizon = frames;
+}
+
+void AUDIOAPI SetFileHandleBudget(long count)
+{
+	TSndFilePool::SetBudget(count);
+}
+
+void AUDIOAPI SetProfileSampling(long n)
+{
+	TProfileCounter::fSampling = UTools::Max(n, 1L);
+}
+
+void AUDIOAPI SetLogCallback(LogCallback callback, void* context)
+{
+	TAudioLog::SetCallback(callback, context);
+}
+
+void AUDIOAPI SetLogRate(long rate)
+{
+	TAudioLog::SetRate(UTools::Max(rate, 1L));
+}
+
+AudioContextPtr AUDIOAPI MakeAudioContext(long inChan, long outChan, long channels, long sample_rate,
+										  long buffer_size, long stream_buffer_size, long rtstream_buffer_size)
+{
+	return new TAudioContext(inChan, outChan, channels, sample_rate, buffer_size, stream_buffer_size, rtstream_buffer_size);
+}
+
+void AUDIOAPI DeleteAudioContext(AudioContextPtr context)
+{
+	if (context && context != TAudioContext::GetDefault()) {
+		if (TAudioContext::GetCurrent() == context) {
+			TAudioContext::SetCurrent(0);
+		}
+		delete context;
+	}
+}
+
+void AUDIOAPI SetAudioContext(AudioContextPtr context)
+{
+	TAudioContext::SetCurrent(context);
+}
+
 AudioPlayerPtr AUDIOAPI OpenAudioPlayer(long inChan, 
                                         long outChan, 
                                         long channels, 
@@ -983,6 +1341,47 @@ void AUDIOAPI GetAudioRendererInfo(AudioRendererPtr renderer, RendererInfoPtr in
     static_cast<TAudioRendererPtr>(renderer)->GetInfo(static_cast<RendererInfoPtr>(info));
 }
 
+long AUDIOAPI SetAudioRendererCapture(AudioRendererPtr renderer, char* name, long format)
+{
+	TNullAudioRendererPtr null_renderer = dynamic_cast<TNullAudioRendererPtr>(static_cast<TAudioRendererPtr>(renderer));
+	if (null_renderer) {
+		null_renderer->SetCapture(name, format);
+		return NO_ERR;
+	} else {
+		return OPEN_ERR;
+	}
+}
+
+long AUDIOAPI GetAudioRendererStats(AudioRendererPtr renderer, long client, TimingStatsPtr stats)
+{
+	return static_cast<TAudioRendererPtr>(renderer)->GetStats(client, stats);
+}
+
+void AUDIOAPI ResetAudioRendererStats(AudioRendererPtr renderer)
+{
+	static_cast<TAudioRendererPtr>(renderer)->ResetStats();
+}
+
+void AUDIOAPI StartTrace(long events)
+{
+	TTraceRecorder::Start(UTools::Max(events, 1));
+}
+
+void AUDIOAPI StopTrace()
+{
+	TTraceRecorder::Stop();
+}
+
+long AUDIOAPI DumpTrace(char* name)
+{
+	return (name) ? TTraceRecorder::Dump(name) : -1;
+}
+
+long AUDIOAPI ReportRTViolations()
+{
+	return TRTChecker::Report();
+}
+
 void AUDIOAPI AddAudioClient(AudioRendererPtr renderer, AudioClientPtr client)
 {
 	static_cast<TAudioRendererPtr>(renderer)->AddClient(static_cast<TAudioClientPtr>(client));
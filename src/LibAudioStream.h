@@ -41,7 +41,7 @@ extern "C"
 #define FILE_NOT_FOUND_ERR -4
 
     enum {kPlayingChannel = 0, kIdleChannel};
-    enum {kPortAudioRenderer = 0, kJackRenderer, kCoreAudioRenderer};
+    enum {kPortAudioRenderer = 0, kJackRenderer, kCoreAudioRenderer, kNullRenderer, kFreeNullRenderer};
 
     /*!
     \brief Sound channel info.
@@ -86,9 +86,28 @@ extern "C"
         long fInputLatencyUsec;		// Input latency in microsecond
     } RendererInfo;
 
+    #define TIMING_BINS 20
+
+    /*!
+    \brief Audio callback timing statistics.
+    */
+    typedef struct TimingStats* TimingStatsPtr;
+    typedef struct TimingStats {
+        long fCallbacks;                        // Number of measured callbacks
+        long fDeadlineMisses;                   // Callbacks longer than the buffer period
+        float fMeanLoad;                        // Mean DSP load in percent of the buffer period
+        float fMaxLoad;                         // Maximum DSP load in percent of the buffer period
+        float fMaxDurationUsec;                 // Maximum callback duration in microsecond
+        float fMaxJitterUsec;                   // Maximum distance between callback intervals and the buffer period
+        long fDurationHistogram[TIMING_BINS];   // Bin i counts durations in [2^i, 2^(i+1)[ microseconds (the first and last bins are open)
+        long fLoadHistogram[TIMING_BINS];       // Bin i counts loads in [10 * i, 10 * (i+1)[ percent (the last bin is open)
+        long fJitterHistogram[TIMING_BINS];     // Bin i counts jitters in [2^i, 2^(i+1)[ microseconds (the first and last bins are open)
+    } TimingStats;
+
     // Opaque pointers
     typedef void* AudioPlayerPtr;
 	typedef void* AudioRendererPtr;
+	typedef void* AudioContextPtr;
  	typedef void* AudioStreamPtr;
 	typedef void* AudioClientPtr;
 	
@@ -97,12 +116,20 @@ extern "C"
 	typedef void* AudioEffectInterfacePtr;
 	
 	typedef void (*StopCallback)(void* context);
+	typedef void (*LoadCallback)(void* context, long index, long state);
+	typedef void (*LogCallback)(void* context, const char* message);
 
     /*!
     \brief Gives the library version number.
     \return the library version number as a 3 digits long value.
     */
 	long LibVersion();
+
+    /*!
+    \brief Gives the number of stream nodes removed by the simplification rules when building sounds.
+    \return the number of removed nodes since the library was loaded.
+    */
+	long GetRemovedSoundCount();
 	
     /**
      * @defgroup SoundFunctions Sound creation and manipulation functions
@@ -129,6 +156,25 @@ extern "C"
     \return A pointer to new stream object or NULL if the wanted region is not part of the file.
     */
     AudioStreamPtr MakeRegionSoundPtr(char* name, long beginFrame, long endFrame);
+    /*!
+    \brief Create a file region reader stream without blocking: the file is opened and its beginning read in the library threads.
+    \param name The sound file pathname.
+    \param beginFrame The start frame of the region.
+    \param endFrame The end frame of the region, or -1 for the whole file.
+    \param callback A callback called in a library thread when the stream is ready or cannot be opened, or NULL.
+    \param context A pointer on data given to the callback, with the index 0 and the state (see GetLoadStateSoundPtr).
+    \return A pointer to new stream object or NULL if the region is invalid. The stream plays silence until it is ready, and should be composed with other streams only when it is ready.
+    */
+    AudioStreamPtr MakeLoadSoundPtr(char* name, long beginFrame, long endFrame, LoadCallback callback, void* context);
+    /*!
+    \brief Create several file reader streams without blocking: the files are opened in parallel by the library threads.
+    \param names The sound file pathnames.
+    \param count The number of files.
+    \param sounds An array of count stream pointers to be filled.
+    \param callback A callback called in a library thread each time a stream is ready or cannot be opened, or NULL.
+    \param context A pointer on data given to the callback, with the index of the stream and its state.
+    */
+    void MakeLoadSoundsPtr(char** names, long count, AudioStreamPtr* sounds, LoadCallback callback, void* context);
 	/*!
     \brief Transform a stream in a stereo stream.
     \param sound The stream to be transformed.
@@ -174,6 +220,22 @@ extern "C"
     */
     AudioStreamPtr MakeMixSoundPtr(AudioStreamPtr s1, AudioStreamPtr s2);
     /*!
+    \brief Mix an array of streams, nested mixes are flattened.
+    \param sounds The array of streams.
+    \param count The number of streams in the array.
+    \return A pointer to new stream object or NULL if one of the streams is NULL.
+    */
+    AudioStreamPtr MakeMultiMixSoundPtr(AudioStreamPtr* sounds, long count);
+    /*!
+    \brief Place streams on a timeline: clips are only instantiated when the playback position comes near their start, and released when finished.
+    \param sounds The array of clips.
+    \param starts The array of clip start positions in frames.
+    \param count The number of clips in the arrays.
+    \param lookahead The distance in frames at which a clip is instantiated before its start, or 0 for the default value.
+    \return A pointer to new stream object or NULL if one of the streams is NULL.
+    */
+    AudioStreamPtr MakeTimelineSoundPtr(AudioStreamPtr* sounds, long* starts, long count, long lookahead);
+    /*!
     \brief Apply a list of effects on a stream.
     \param sound The stream to be transformed.
     \param effect_list The effect list to be used.
@@ -191,6 +253,13 @@ extern "C"
     */
     AudioStreamPtr MakePitchSchiftTimeStretchSoundPtr(AudioStreamPtr sound, double* pitch_shift, double* time_strech);
     /*!
+    \brief Render a stream ahead of playback in a low-priority thread, the audio thread only copies the already rendered frames.
+    \param sound The stream to be rendered, typically an expensive one (pitchshift, timestretch, long transform chains...).
+    \param ahead The render distance in frames, if 0 the stream buffer size is used.
+    \return A pointer to new stream object.
+    */
+    AudioStreamPtr MakeAsyncSoundPtr(AudioStreamPtr sound, long ahead);
+    /*!
     \brief Create a stream writer.
     \param name The sound file pathname.
     \param sound The stream to be saved.
@@ -209,6 +278,13 @@ extern "C"
     */
     AudioStreamPtr MakeRendererSoundPtr(AudioStreamPtr sound);
     /*!
+    \brief Instrument a stream for profiling: the Read calls of each node and the Process calls of each effect are timed
+	 (see DumpProfileSoundPtr). The stream is instrumented in place and must not be played yet.
+    \param sound The stream to be profiled.
+    \return A pointer to new stream object.
+    */
+    AudioStreamPtr MakeProfileSoundPtr(AudioStreamPtr sound);
+    /*!
     \brief Get the stream length in frames.
     \param sound The stream.
     \return The stream length in frames.
@@ -221,6 +297,12 @@ extern "C"
     */
     long GetChannelsSoundPtr(AudioStreamPtr sound);
     /*!
+    \brief Get the state of a stream built with MakeLoadSoundPtr or MakeLoadSoundsPtr.
+    \param sound The stream.
+    \return 0 while the file is being opened, 1 when the stream is ready (always for other streams), a negative value if the file cannot be opened.
+    */
+    long GetLoadStateSoundPtr(AudioStreamPtr sound);
+    /*!
     \brief Read a buffer of the stream.
     \param sound The stream.
     \param buffer A buffer to be filled with frames.
@@ -239,6 +321,42 @@ extern "C"
     \param sound The stream to be reseted.
     */
 	void ResetSoundPtr(AudioStreamPtr sound);
+    /*!
+    \brief Render a stream in a sound file as fast as possible, from its beginning: the rendering and the file encoding are done in parallel.
+    \param sound The stream to be rendered.
+    \param name The sound file pathname.
+    \param format The sound file format (as a libsndfile format, like SF_FORMAT_WAV | SF_FORMAT_PCM_16 or SF_FORMAT_FLAC | SF_FORMAT_PCM_24).
+    \param blockSize The number of frames rendered at each step, large blocks (like 65536) give the best speed.
+    \param framesPerSec A pointer to get the achieved rendering speed in frames per second, or NULL.
+    \return The number of rendered frames, or a negative value if the file cannot be written.
+    */
+    long RenderToFilePtr(AudioStreamPtr sound, char* name, long format, long blockSize, float* framesPerSec);
+    /*!
+    \brief Render independent streams in sound files in parallel, each one from its beginning. Streams must not share sub-streams (use copies).
+    \param sounds The streams to be rendered.
+    \param names The sound file pathnames.
+    \param count The number of streams.
+    \param format The sound files format (see RenderToFilePtr).
+    \param blockSize The number of frames rendered at each step.
+    \param threads The number of rendering threads, or 0 to use one thread per processor.
+    \param results An array of count values to get the number of rendered frames of each file (negative if the file cannot be written), or NULL.
+    \return The number of rendered files, or -1 (and no file rendered) if a stream or a name is null.
+    */
+    long RenderToFilesPtr(AudioStreamPtr* sounds, char** names, long count, long format, long blockSize, long threads, long* results);
+    /*!
+    \brief Dump the profile of a stream built with MakeProfileSoundPtr: one line per node with its calls, frames,
+	 total and self time and load, then its effects.
+    \param sound The profiled stream.
+    \param buffer A buffer to be filled with the dump as a C string, or NULL.
+    \param size The buffer size.
+    \return The length of the whole dump, which is truncated if the buffer is too small.
+    */
+    long DumpProfileSoundPtr(AudioStreamPtr sound, char* buffer, long size);
+    /*!
+    \brief Reset the profile of a stream built with MakeProfileSoundPtr.
+    \param sound The profiled stream.
+    */
+    void ResetProfileSoundPtr(AudioStreamPtr sound);
     
     /*@}*/
     
@@ -274,6 +392,14 @@ extern "C"
 	*/
 	AudioEffectListPtr ClearAudioEffectListPtr(AudioEffectListPtr list_effect);
 	/*!
+	\brief Compile all Faust effects of the list as a single DSP, using the sequential composition operator. 
+	Controls of the original effects are still used. The list is processed unfused again when it is modified 
+	or when one of its effects is desactivated.
+	\param list The effect list to be fused, made of at least two Faust effects built from DSP source.
+	\return A pointer to the effect list.
+	*/
+	AudioEffectListPtr FuseAudioEffectListPtr(AudioEffectListPtr list_effect);
+	/*!
 	\brief Create a volume effect.
 	\param gain The volume between 0 and 1.
     \return A pointer to new volume object.
@@ -305,6 +431,14 @@ extern "C"
 	*/
 	AudioEffectPtr MakeFaustAudioEffectPtr(const char* name);
 	/*!
+	\brief Create an effect described in the Faust DSP language, compiled with the given Faust compiler options.
+	\param name The Faust DSP file name or DSP code.
+	\param options The compilation options, like "-vec -vs 512 -dfs". Effects created with MakeFaustAudioEffect 
+	are compiled in vector mode with the vector size set to the audio buffer size.
+    \return A pointer to new effect object or NULL if the effect cannot be compiled or created.
+	*/
+	AudioEffectPtr MakeFaustAudioEffectWithOptionsPtr(const char* name, const char* options);
+	/*!
 	\brief Create an effect by "wrapping" an externally built effect.
 	\param effect The effect to be wrapped.
     \return A pointer to new effect object or NULL if the effect cannot be located or created.
@@ -388,6 +522,66 @@ extern "C"
     */
 	void SetAudioLatencies(long inputLatency, long outputLatency);
 
+	/*!
+    \brief Set the distance at which sound files are opened and their buffers allocated before being played.
+	 Files are released when finished, so that only the files played within the horizon hold resources.
+    \param frames The horizon in frames, or 0 for the default value (4 times the stream buffer size).
+	 The horizon is set for the current engine context (see SetAudioContext).
+    */
+	void SetPrefetchHorizon(long frames);
+
+	/*!
+    \brief Set the maximum number of sound files kept open. Streams reading the same file share one handle,
+	 the least recently read files are closed when the budget is exceeded and opened again when needed.
+    \param count The maximum number of open files (256 by default).
+    */
+	void SetFileHandleBudget(long count);
+
+	/*!
+    \brief Set the profiling sampling: only one call out of n is timed in profiled streams, so that profiling can be left on.
+    \param n The sampling (1 by default, to time all calls).
+    */
+	void SetProfileSampling(long n);
+
+	/*!
+    \brief Set the function receiving the library messages. Messages of the audio and command manager threads are queued
+	 without blocking, and given to the function by a dedicated thread.
+    \param callback The function, or NULL to print the messages on the standard output (the default).
+    \param context A pointer given to the function.
+    */
+	void SetLogCallback(LogCallback callback, void* context);
+	/*!
+    \brief Limit the number of library messages, additional messages are dropped and counted.
+    \param rate The maximum number of messages per second (50 by default).
+    */
+	void SetLogRate(long rate);
+
+	/*!
+    \brief Create an engine context: streams built in a context use its sample rate and buffer sizes,
+	 so that engines with different parameters can be used in the same process.
+    \param inChan The number of input channels.
+    \param outChan The number of output channels.
+    \param channels The number of stream channels.
+    \param sample_rate The sampling rate.
+    \param buffer_size The audio buffer size.
+    \param stream_buffer_size The file reader/writer buffer size (used for double buffering).
+    \param rtstream_buffer_size The input stream buffer size.
+    \return A pointer to the new context.
+    */
+	AudioContextPtr MakeAudioContext(long inChan, long outChan, long channels, long sample_rate,
+									 long buffer_size, long stream_buffer_size, long rtstream_buffer_size);
+	/*!
+    \brief Delete an engine context, once all its streams and players are deleted.
+    \param context The context to be deleted.
+    */
+	void DeleteAudioContext(AudioContextPtr context);
+	/*!
+    \brief Select the engine context of the calling thread: the streams, effects and players it builds
+	 afterwards belong to the context. The parameters of a player opened in a context must match the context ones.
+    \param context The context, or NULL for the default context (the one of the first opened player).
+    */
+	void SetAudioContext(AudioContextPtr context);
+
     /*!
     \brief Open the audio player.
     \param inChan The number of input channels. <B>Only stereo players are currently supported </B>
@@ -397,7 +591,8 @@ extern "C"
     \param buffer_size The audio player internal buffer size.
     \param stream_buffer_size The file reader/writer buffer size (used for double buffering).
     \param rtstream_buffer_size The input stream buffer size.
-    \param renderer The audio renderer used to access audio I/O : can be kPortAudioRenderer, kJackRenderer or kCoreAudioRenderer.
+    \param renderer The audio renderer used to access audio I/O : can be kPortAudioRenderer, kJackRenderer or kCoreAudioRenderer,
+	 or kNullRenderer (no audio device, paced at the sample rate) and kFreeNullRenderer (no audio device, as fast as possible).
     \param thread_num The number of additionnal low-priority threads used to precompute data : must be a least one.
     \return A pointer to new audio player object.
     */
@@ -591,7 +786,8 @@ extern "C"
 	// Renderer
 	/*!
     \brief Create a new audio renderer.
-    \param renderer The audio renderer used to access audio I/O : can be kPortAudioRenderer, kJackRenderer or kCoreAudioRenderer.
+    \param renderer The audio renderer used to access audio I/O : can be kPortAudioRenderer, kJackRenderer or kCoreAudioRenderer,
+	 or kNullRenderer (no audio device, paced at the sample rate) and kFreeNullRenderer (no audio device, as fast as possible).
 	\return A pointer to new audio renderer object.
 	*/
 	AudioRendererPtr MakeAudioRenderer(long renderer);
@@ -635,6 +831,49 @@ extern "C"
     \param info The audio renderer info to be filled.
 	*/
 	void GetAudioRendererInfo(AudioRendererPtr renderer, RendererInfoPtr info); 
+	/*!
+    \brief Capture the output of a null renderer (kNullRenderer or kFreeNullRenderer) in a sound file, from its next start.
+    \param renderer The audio renderer.
+    \param name The sound file pathname, or an empty name to stop capturing.
+    \param format The sound file format (see RenderToFilePtr).
+    \return An error code, if the renderer is not a null renderer.
+	*/
+	long SetAudioRendererCapture(AudioRendererPtr renderer, char* name, long format);
+	/*!
+    \brief Get the timing statistics of the renderer audio callbacks, measured against the buffer period.
+    \param renderer The audio renderer.
+    \param client -1 for the whole callback, or the index of a client in the renderer client list (the player mixer is client 0).
+    \param stats The statistics to be filled.
+    \return The number of clients, or -1 if the client index is wrong.
+	*/
+	long GetAudioRendererStats(AudioRendererPtr renderer, long client, TimingStatsPtr stats);
+	/*!
+    \brief Reset the timing statistics of the renderer, from its next audio callback.
+    \param renderer The audio renderer.
+	*/
+	void ResetAudioRendererStats(AudioRendererPtr renderer);
+	/*!
+    \brief Start recording the activity of the audio and command manager threads: audio callbacks, queued and executed commands, disk errors.
+	 Previous events are cleared.
+    \param events The number of events kept per thread, the oldest ones being overwritten (the size is set by the first call).
+	*/
+	void StartTrace(long events);
+	/*!
+    \brief Stop recording the threads activity.
+	*/
+	void StopTrace();
+	/*!
+    \brief Write the recorded events in a Chrome trace file (to be opened with chrome://tracing or ui.perfetto.dev), preferably after StopTrace.
+    \param name The trace file pathname.
+    \return The number of written events, or a negative value if the file cannot be written.
+	*/
+	long DumpTrace(char* name);
+	/*!
+    \brief Print the calls that may block (allocation, locks, file I/O, sleep) made in the audio thread since the previous report, with their backtraces.
+	 Calls are only detected when the library is built with RT_CHECK (Linux), to be called when channels are stopped.
+    \return The number of detected calls.
+	*/
+	long ReportRTViolations();
 	
 	/*!
     \brief Add an audio client to the renderer internal client list.
@@ -0,0 +1,216 @@
+/*
+
+Copyright (C) Grame 2002-2013
+
+This library is free software; you can redistribute it and modify it under
+the terms of the GNU Library General Public License as published by the
+Free Software Foundation version 2 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public License
+for more details.
+
+You should have received a copy of the GNU Library General Public License
+along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+Grame Research Laboratory, 9, rue du Garet 69001 Lyon - France
+research@grame.fr
+
+*/
+
+#include "TAsyncAudioStream.h"
+#include "TPrefetchHandler.h"
+#include "UAudioTools.h"
+#include "UTools.h"
+#include "msAtomic.h"
+#include <assert.h>
+
+TAsyncAudioStream::TAsyncAudioStream(TAudioStreamPtr stream, long ahead): TDecoratedAudioStream(stream)
+{
+    fChannels = stream->Channels();
+    fAhead = (ahead > 0) ? ahead : fContext->fStreamBufferSize;
+    fChunk = fContext->fBufferSize;
+
+    // Power of 2 size so that positions can freely wrap
+    fSize = 1;
+    while (fSize < (unsigned long)(fAhead + fChunk)) {
+        fSize <<= 1;
+    }
+    fRing = new TLocalAudioBuffer<float>(fSize, fChannels);
+
+    fCurFrame = 0;
+    fReadPos = 0;
+    fWritePos = 0;
+    fEnd = false;
+    fGeneration = 0;
+    fFilledGeneration = 0;
+    fFilledStart = 0;
+    fFilledSeq = 0;
+    fReadGeneration = 0;
+    fQueued = 0;
+
+    TScratchPlanner::Plan(stream);
+    TPrefetcher::Prefetch(stream, fContext->GetHorizon());
+
+    // Prime the ring directly
+    Fill();
+}
+
+TAsyncAudioStream::~TAsyncAudioStream()
+{
+    // A queued fill command holds a reference, so none is pending here
+    delete fRing;
+}
+
+// Callback called by command manager, the command holds a reference on the stream
+void TAsyncAudioStream::FillAux(TAsyncAudioStreamPtr obj, long u1, long u2, long u3, long u4)
+{
+    obj->Fill();
+    CAS(&obj->fQueued, (void*)1, (void*)0);
+    // May delete the stream in this thread
+    obj->removeReference();
+}
+
+// Called in the command manager thread, or directly when no fill is queued
+void TAsyncAudioStream::Fill()
+{
+    long generation = fGeneration;
+
+    // The new generation frames start at the current write position, Read skips the frames before
+    if (generation != fFilledGeneration) {
+        fStream->Reset();
+        msAtomicSet(&fFilledSeq, fFilledSeq + 1);
+        fEnd = false;
+        fFilledStart = fWritePos;
+        fFilledGeneration = generation;
+        msAtomicSet(&fFilledSeq, fFilledSeq + 1);
+    }
+
+    while (!fEnd && generation == fGeneration) {
+        unsigned long pos = fWritePos & (fSize - 1);
+        long frames = UTools::Min(fChunk, long(fSize - (fWritePos - fReadPos)));
+        frames = UTools::Min(frames, long(fSize - pos));
+        if (frames <= 0) {
+            break;
+        }
+        UAudioTools::ZeroFloatBlk(fRing->GetFrame(pos), frames, fChannels);
+        long res = fStream->Read(fRing, frames, pos, fChannels);
+        msAtomicSet(&fWritePos, fWritePos + res);
+        // Set after the frames are published, see Read
+        if (res < frames) {
+            fEnd = true;
+        }
+    }
+}
+
+void TAsyncAudioStream::Request()
+{
+    if (CAS(&fQueued, (void*)0, (void*)1)) {
+        addReference();
+        if (fManager) {
+            fManager->ExecCmd((CmdPtr)FillAux, (long)this, 0, 0, 0, 0);
+        } else {
+            FillAux(this, 0, 0, 0, 0);
+        }
+    }
+}
+
+// Called in the audio thread: reads the filled generation state, returns false when it is not the current generation
+bool TAsyncAudioStream::Snapshot(unsigned long* write, bool* end)
+{
+    unsigned long seq = fFilledSeq;
+    long filled = fFilledGeneration;
+    unsigned long start = fFilledStart;
+    // fEnd has to be read before fWritePos
+    *end = fEnd;
+    *write = fWritePos;
+
+    // A generation is being published, or was published while reading
+    if ((seq & 1) || seq != fFilledSeq || filled != fGeneration) {
+        return false;
+    }
+
+    // Skip the frames of the previous generations
+    if (filled != fReadGeneration) {
+        msAtomicSet(&fReadPos, start);
+        fReadGeneration = filled;
+    }
+    return true;
+}
+
+long TAsyncAudioStream::Read(FLOAT_BUFFER buffer, long framesNum, long framePos, long channels)
+{
+    assert(fRing);
+
+    long res = 0;
+
+    for (int i = 0; i < 2 && res < framesNum; i++) {
+
+        unsigned long write;
+        bool end;
+
+        // Ring is being flushed and primed again
+        if (!Snapshot(&write, &end)) {
+            Request();
+            if (!Snapshot(&write, &end)) {
+                fContext->AddDiskError();
+                res = framesNum;
+                break;
+            }
+        }
+
+        unsigned long pos = fReadPos & (fSize - 1);
+        long frames = UTools::Min(framesNum - res, long(write - fReadPos));
+        long frames1 = UTools::Min(frames, long(fSize - pos));
+
+        UAudioTools::Float2FloatMix(fRing->GetFrame(pos), buffer->GetFrame(framePos + res), frames1, fChannels, channels);
+        UAudioTools::Float2FloatMix(fRing->GetFrame(0), buffer->GetFrame(framePos + res + frames1), frames - frames1, fChannels, channels);
+        msAtomicSet(&fReadPos, fReadPos + frames);
+        res += frames;
+
+        if (end) {
+            break;
+        } else if (res < framesNum) {
+            // With a direct command manager, the ring is filled synchronously
+            Request();
+            if (i == 1) {
+                // Underrun: keep the stream running with silence
+                fContext->AddDiskError();
+                res = framesNum;
+            }
+        }
+    }
+
+    fCurFrame += res;
+
+    if (fSize - (fWritePos - fReadPos) >= fSize / 2) {
+        Request();
+    }
+
+    return res;
+}
+
+void TAsyncAudioStream::Reset()
+{
+    // The ring already starts at the beginning of the decorated stream
+    if (fCurFrame == 0) {
+        return;
+    }
+
+    long generation = fGeneration;
+    CAS(&fGeneration, (void*)generation, (void*)(generation + 1));
+    fCurFrame = 0;
+    Request();
+}
+
+TAudioStreamPtr TAsyncAudioStream::CutBegin(long frames)
+{
+    return new TAsyncAudioStream(fStream->CutBegin(frames), fAhead);
+}
+
+TAudioStreamPtr TAsyncAudioStream::Copy()
+{
+    return new TAsyncAudioStream(fStream->Copy(), fAhead);
+}
@@ -0,0 +1,108 @@
+/*
+
+Copyright (C) Grame 2002-2013
+
+This library is free software; you can redistribute it and modify it under
+the terms of the GNU Library General Public License as published by the
+Free Software Foundation version 2 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public License
+for more details.
+
+You should have received a copy of the GNU Library General Public License
+along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+Grame Research Laboratory, 9, rue du Garet 69001 Lyon - France
+research@grame.fr
+
+*/
+
+#ifndef __TAsyncAudioStream__
+#define __TAsyncAudioStream__
+
+#include "TAudioStream.h"
+#include "TCmdHandler.h"
+#include "TScratchArena.h"
+
+//-------------------------
+// Class TAsyncAudioStream
+//-------------------------
+/*!
+\brief A TAsyncAudioStream renders the decorated stream ahead of playback in a low-priority thread.
+*/
+
+/*
+The decorated stream is read by the command manager threads into a single producer/single consumer
+ring buffer, the audio thread only copies frames out of the ring.
+
+At most one fill command is queued at a time, so the decorated stream is never read by two threads.
+A Reset increments a generation counter: the next fill command resets the decorated stream,
+publishes the new generation with the write position its frames start at, then primes the ring again.
+The generation, its start position, the end flag and the write position are read by the audio thread
+as one consistent snapshot (fFilledSeq is odd while the fill thread publishes a generation), so a Reset
+racing with a Read never mixes frames of two generations. The audio thread skips the frames
+of the previous generations by moving its own read position, the fill thread never moves it.
+Until the current generation is published, Read produces silence.
+
+A queued fill command holds a reference on the stream, so the destructor never waits: it may run
+in the fill thread when the command drops the last reference.
+
+With a direct command manager (MakeRendererSound), the fill is done synchronously in Read.
+
+The decorated tree is read in the fill thread, so it gets its own scratch arena.
+*/
+
+class TAsyncAudioStream : public TDecoratedAudioStream, public TCmdHandler, public TScratchBoundary
+{
+
+    private:
+
+        FLOAT_BUFFER fRing;                         // Ring at the decorated stream native channel count
+        long fChannels;
+        long fAhead;                                // Requested render distance in frames
+        unsigned long fSize;                        // Ring size in frames (power of 2)
+        long fChunk;                                // Frames read from the decorated stream at each step
+        long fCurFrame;                             // Frames consumed since the last Reset
+
+        volatile unsigned long fReadPos;            // Written by the audio thread only
+        volatile unsigned long fWritePos;           // Written by the fill thread only
+        volatile bool fEnd;                         // The decorated stream is finished
+        volatile long fGeneration;                  // Incremented by Reset
+        volatile long fFilledGeneration;            // Generation the ring content belongs to
+        volatile unsigned long fFilledStart;        // Write position the filled generation frames start at
+        volatile unsigned long fFilledSeq;          // Odd while a generation is being published
+        long fReadGeneration;                       // Generation of the frames at fReadPos, audio thread only
+        volatile long fQueued;                      // 1 when a fill command is queued or running
+
+        static void FillAux(TAsyncAudioStream* obj, long u1, long u2, long u3, long u4);
+
+        void Fill();
+        void Request();
+        bool Snapshot(unsigned long* write, bool* end);
+
+    public:
+
+        TAsyncAudioStream(TAudioStreamPtr stream, long ahead);
+        virtual ~TAsyncAudioStream();
+
+        virtual long Write(FLOAT_BUFFER buffer, long framesNum, long framePos, long channels)
+        {
+            return 0;
+        }
+        virtual long Read(FLOAT_BUFFER buffer, long framesNum, long framePos, long channels);
+
+        virtual void Reset();
+        virtual TAudioStreamPtr CutBegin(long frames);
+        virtual long Channels()
+        {
+            return fChannels;
+        }
+        virtual TAudioStreamPtr Copy();
+};
+
+typedef TAsyncAudioStream * TAsyncAudioStreamPtr;
+
+#endif
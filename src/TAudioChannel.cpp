@@ -29,8 +29,9 @@ research@grame.fr
 #endif
 
 #include "TAudioChannel.h"
-#include "TAudioGlobals.h"
+#include "TAudioContext.h"
 #include "UAudioTools.h"
+#include "UTools.h"
 #include "TNullAudioStream.h"
 
 TAudioChannel::TAudioChannel()
@@ -41,7 +42,8 @@ TAudioChannel::TAudioChannel()
     SetPan(DEFAULT_PAN_LEFT, DEFAULT_PAN_RIGHT);
 	fLeftOut = 0;
     fRightOut = 1;
-    fMixBuffer = new TLocalAudioBuffer<float>(TAudioGlobals::fBufferSize, TAudioGlobals::fOutput);
+    TAudioContextPtr context = TAudioContext::GetCurrent();
+    fMixBuffer = new TLocalAudioBuffer<float>(context->fBufferSize, context->fOutput);
 }
 
 TAudioChannel::~TAudioChannel()
@@ -118,20 +120,29 @@ void TAudioChannel::GetInfo(ChannelInfo* info)
 // Internal API
 /*--------------------------------------------------------------------------*/
 
+// The stream is rendered at its native channel count, and upmixed once to the output channels when applying Vol and Pan.
+// Channel effects are written for the output layout, so the stream is rendered with the output channels when there are some.
+
 bool TAudioChannel::Mix(FLOAT_BUFFER dst, long framesNum, long channels)
 {
+    long streamChannels = fFadeStream.Channels();
+    long mixChannels = (fEffectList.IsEmpty() && streamChannels > 0) ? UTools::Min(streamChannels, channels) : channels;
+	TSharedAudioBuffer<float> mix(fMixBuffer->GetFrame(0), fMixBuffer->GetSize(), mixChannels);
+ 
     // Init buffer
-    UAudioTools::ZeroFloatBlk(fMixBuffer->GetFrame(0), TAudioGlobals::fBufferSize, TAudioGlobals::fOutput);
-	long res = fFadeStream.Read(fMixBuffer, framesNum, 0, channels);
+    UAudioTools::ZeroFloatBlk(mix.GetFrame(0), framesNum, mixChannels);
+	long res = fFadeStream.Read(&mix, framesNum, 0, mixChannels);
 
 	// Effects
-	fEffectList.Process(fMixBuffer->GetFrame(0), framesNum, channels);
+	fEffectList.Process(mix.GetFrame(0), framesNum, mixChannels);
 	
 	// Vol and Pan 
-	if (fFadeStream.Channels() == 1) {
-		UAudioTools::MixFrameToFrameBlk(dst->GetFrame(0), fMixBuffer->GetFrame(0), framesNum, channels, fLLVol, fLRVol);
+	if (mixChannels < channels) {
+		UAudioTools::MixUpFrameToFrameBlk(dst->GetFrame(0), mix.GetFrame(0), framesNum, mixChannels, channels, fLLVol, fLRVol, fRLVol, fRRVol);
+	} else if (streamChannels == 1) {
+		UAudioTools::MixFrameToFrameBlk(dst->GetFrame(0), mix.GetFrame(0), framesNum, channels, fLLVol, fLRVol);
 	} else {
-		UAudioTools::MixFrameToFrameBlk(dst->GetFrame(0), fMixBuffer->GetFrame(0), framesNum, channels, fLLVol, fLRVol, fRLVol, fRRVol);
+		UAudioTools::MixFrameToFrameBlk(dst->GetFrame(0), mix.GetFrame(0), framesNum, channels, fLLVol, fLRVol, fRLVol, fRRVol);
 	}
 	
 	if (res < framesNum) { 	
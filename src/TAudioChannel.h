@@ -251,6 +251,12 @@ class TAudioChannel
         {
             return fEffectList.GetEffectList();
         }
+        
+        // Called by the control thread
+        void CollectEffectLists()
+        {
+            fEffectList.Collect();
+        }
 };
 
 typedef TAudioChannel * TAudioChannelPtr;
@@ -35,6 +35,7 @@ typedef unsigned char Boolean;
 
 
 #define MAX_PLUG_CHANNELS 4
+#define PLUG_BUFFER_ALIGNMENT 64 	// in bytes, for SIMD code in effects
 
 // For MidiDiMan Delta 1010
 #define DELTA_OUTVOICES 	8
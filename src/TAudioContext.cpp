@@ -0,0 +1,65 @@
+/*
+
+Copyright (C) Grame 2002-2013
+
+This library is free software; you can redistribute it and modify it under
+the terms of the GNU Library General Public License as published by the
+Free Software Foundation version 2 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public License
+for more details.
+
+You should have received a copy of the GNU Library General Public License
+along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+Grame Research Laboratory, 9, rue du Garet 69001 Lyon - France
+research@grame.fr
+
+*/
+
+#include "TAudioContext.h"
+#include "TTraceRecorder.h"
+
+TAudioContext TAudioContext::fDefault;
+CONTEXT_THREAD TAudioContextPtr TAudioContext::fCurrent = 0;
+
+TAudioContext::TAudioContext(): fHorizon(0), fInBuffer(0), fOutBuffer(0)
+{
+    Set(0, 0, 0, 0, 0, 0, 0);
+}
+
+TAudioContext::TAudioContext(long inChan, long outChan, long channels, long sample_rate,
+                             long buffer_size, long stream_buffer_size, long rtstream_buffer_size)
+    : fHorizon(0), fInBuffer(0), fOutBuffer(0)
+{
+    Set(inChan, outChan, channels, sample_rate, buffer_size, stream_buffer_size, rtstream_buffer_size);
+}
+
+void TAudioContext::Set(long inChan, long outChan, long channels, long sample_rate,
+                        long buffer_size, long stream_buffer_size, long rtstream_buffer_size)
+{
+    fInput = inChan;
+    fOutput = outChan;
+    fChannels = channels;
+    fSampleRate = sample_rate;
+    fBufferSize = buffer_size;
+    fStreamBufferSize = stream_buffer_size;
+    fRTStreamBufferSize = rtstream_buffer_size;
+    fDiskError = 0;
+}
+
+void TAudioContext::AddDiskError()
+{
+    fDiskError++;
+    TTraceRecorder::Instant("Disk error", this);
+}
+
+TAudioContextPtr TAudioContext::SetCurrent(TAudioContextPtr context)
+{
+    TAudioContextPtr previous = fCurrent;
+    fCurrent = (context == &fDefault) ? 0 : context;
+    return previous;
+}
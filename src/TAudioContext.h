@@ -0,0 +1,135 @@
+/*
+
+Copyright (C) Grame 2002-2013
+
+This library is free software; you can redistribute it and modify it under
+the terms of the GNU Library General Public License as published by the
+Free Software Foundation version 2 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public License
+for more details.
+
+You should have received a copy of the GNU Library General Public License
+along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+Grame Research Laboratory, 9, rue du Garet 69001 Lyon - France
+research@grame.fr
+
+*/
+
+#ifndef __TAudioContext__
+#define __TAudioContext__
+
+#include "AudioExports.h"
+
+#ifdef WIN32
+	#define CONTEXT_THREAD __declspec(thread)
+#else
+	#define CONTEXT_THREAD __thread
+#endif
+
+//---------------------
+// Class TAudioContext
+//---------------------
+/*!
+\brief The parameters of an engine: channels, sample rate and buffer sizes.
+*/
+
+/*
+Streams capture the current context of the thread that builds them and use its parameters
+(and count their disk errors in it) instead of process wide globals: engines with different
+sample rates and buffer sizes can be used in the same process, each control thread selecting
+its engine with SetCurrent.
+
+The input and output buffers of the audio callback are set by the mixer of the engine in its context,
+so that input streams read the input of their own engine.
+
+Threads that did not select a context use the default one, initialized by TAudioGlobals::Init.
+Streams built in command manager threads on behalf of a stream (timeline, loader) select the
+context of that stream.
+*/
+
+class AUDIO_EXPORTS TAudioContext
+{
+
+    private:
+
+        static TAudioContext fDefault;
+        static CONTEXT_THREAD TAudioContext* fCurrent;
+
+    public:
+
+        long fInput;                    // Number of input channels
+        long fOutput;                   // Number of output channels
+        long fChannels;                 // Number of sound channels
+        long fSampleRate;               // Sampling Rate
+        long fBufferSize;               // I/O Buffer size
+        long fStreamBufferSize;         // Stream Buffer size
+        long fRTStreamBufferSize;       // Real-Time Stream Buffer size
+        long fHorizon;                  // Distance in frames at which file streams are prefetched (0 for default)
+        long fDiskError;                // Counter of disk streaming errors
+        float* fInBuffer;               // Input buffer of the current audio callback of the engine
+        float* fOutBuffer;              // Output buffer of the current audio callback of the engine
+
+        TAudioContext();
+        TAudioContext(long inChan, long outChan, long channels, long sample_rate,
+                      long buffer_size, long stream_buffer_size, long rtstream_buffer_size);
+        virtual ~TAudioContext()
+        {}
+
+        void Set(long inChan, long outChan, long channels, long sample_rate,
+                 long buffer_size, long stream_buffer_size, long rtstream_buffer_size);
+
+        // Count a disk streaming error, and trace it
+        void AddDiskError();
+
+        long GetHorizon()
+        {
+            return (fHorizon > 0) ? fHorizon : fStreamBufferSize * 4;
+        }
+
+        static TAudioContext* GetDefault()
+        {
+            return &fDefault;
+        }
+        static TAudioContext* GetCurrent()
+        {
+            return (fCurrent) ? fCurrent : &fDefault;
+        }
+
+        // Select the context of the calling thread (NULL for the default one), returns the previous one
+        static TAudioContext* SetCurrent(TAudioContext* context);
+};
+
+typedef TAudioContext * TAudioContextPtr;
+
+//--------------------------
+// Class TAudioContextScope
+//--------------------------
+/*!
+\brief Selects a context for the calling thread during its lifetime.
+*/
+
+class TAudioContextScope
+{
+
+    private:
+
+        TAudioContextPtr fPrevious;
+
+    public:
+
+        TAudioContextScope(TAudioContextPtr context)
+        {
+            fPrevious = TAudioContext::SetCurrent(context);
+        }
+        virtual ~TAudioContextScope()
+        {
+            TAudioContext::SetCurrent(fPrevious);
+        }
+};
+
+#endif
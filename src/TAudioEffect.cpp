@@ -22,6 +22,8 @@ research@grame.fr
 
 #include "TAudioEffect.h"
 #include "UAudioTools.h"
+#include "UTools.h"
+#include "TFaustAudioEffect.h"
 
 void TAudioEffectList::Init(float fade_in_val, float fade_in_time, float fade_out_val, float fade_out_time)
 {
@@ -85,15 +87,32 @@ void TAudioEffectList::Process(float* buffer, long framesNum, long channels)
 		// Deinterleave...
 		UAudioTools::Deinterleave(input, buffer, framesNum, channels);
 		
+		SwitchFused();
+		
 		// Process effects
-		for (list<TAudioEffectInterfacePtr>::iterator iter = begin(); iter != end(); iter++) {
-			TAudioEffectInterfacePtr process = *iter;
-			process->ProcessAux(input, tmp_output, framesNum, channels);
-			output = tmp_output;
-			// Swap buffers
-			float** tmp = input;
-			input = tmp_output;
-			tmp_output = tmp;
+		if (IsFused()) {
+			fFused->Process(input, output, framesNum, channels);
+		} else {
+			long index = 0;
+			for (list<TAudioEffectInterfacePtr>::iterator iter = begin(); iter != end(); iter++, index++) {
+				TAudioEffectInterfacePtr process = *iter;
+				TProfileCounter* profile = (index < long(fProfiles.size())) ? (TProfileCounter*)fProfiles[index] : 0;
+				if (profile && profile->Sample()) {
+					double start = UTools::GetTime();
+					process->ProcessAux(input, tmp_output, framesNum, channels);
+					profile->Add(UTools::GetTime() - start);
+				} else {
+					process->ProcessAux(input, tmp_output, framesNum, channels);
+				}
+				if (profile) {
+					profile->fFrames += framesNum;
+				}
+				output = tmp_output;
+				// Swap buffers
+				float** tmp = input;
+				input = tmp_output;
+				tmp_output = tmp;
+			}
 		}
 		
 		// Interleave...
@@ -101,23 +120,149 @@ void TAudioEffectList::Process(float* buffer, long framesNum, long channels)
 	}
 }
 
+// The fused effect is used only when the list did not change and all effects are active
+
+bool TAudioEffectList::IsFused()
+{
+	if (!fFused || long(size()) != fFusedCount) {
+		return false;
+	}
+	for (list<TAudioEffectInterfacePtr>::iterator iter = begin(); iter != end(); iter++) {
+		if (!(*iter)->GetState()) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static TFusedCmd* Exchange(TFusedCmd* volatile* slot, TFusedCmd* cmd)
+{
+	TFusedCmd* old;
+	do {
+		old = *slot;
+	} while (!CAS(slot, old, cmd));
+	return old;
+}
+
+static void ReleaseFusedCmd(TFusedCmd* cmd)
+{
+	if (cmd->fFused) {
+		cmd->fFused->removeReference();
+	}
+	delete cmd;
+}
+
+// Take the pending fused effect, the previous one is retired
+
+void TAudioEffectList::SwitchFused()
+{
+	if (fPendingFused) {
+		TFusedCmd* cmd = Exchange(&fPendingFused, 0);
+		TAudioEffectInterface* old = fFused;
+		fFused = cmd->fFused;
+		fFusedCount = cmd->fFusedCount;
+		cmd->fFused = old;
+		lfpush(&fRetiredFused, &cmd->fLink);
+	}
+}
+
+// Called by the control thread : a fused effect posted before the previous one was taken replaces it
+
+void TAudioEffectList::PostFused(TAudioEffectInterface* fused, long count)
+{
+	CollectFused();
+	
+	TFusedCmd* cmd = new TFusedCmd;
+	cmd->fFused = fused;
+	if (fused) {
+		fused->addReference();
+	}
+	cmd->fFusedCount = count;
+	
+	TFusedCmd* old = Exchange(&fPendingFused, cmd);
+	if (old) {
+		ReleaseFusedCmd(old);
+	}
+}
+
+void TAudioEffectList::CollectFused()
+{
+	TFusedCmd* cmd;
+	while ((cmd = (TFusedCmd*)lfpop(&fRetiredFused))) {
+		ReleaseFusedCmd(cmd);
+	}
+}
+
+bool TAudioEffectList::Fuse()
+{
+	TFusedFaustAudioEffectPtr fused = TFusedFaustAudioEffect::Make(*this);
+	if (fused) {
+		PostFused(fused, size());
+		fFuseRequested = true;
+		return true;
+	} else {
+		return false;
+	}
+}
+
+void TAudioEffectList::Unfuse()
+{
+	if (fFuseRequested) {
+		PostFused(0, 0);
+		fFuseRequested = false;
+	} else {
+		CollectFused();
+	}
+}
+
+void TAudioEffectList::Profile()
+{
+	while (fProfiles.size() < size()) {
+		fProfiles.push_back(new TProfileCounter());
+	}
+}
+
 void TAudioEffectList::Reset()
 {
     for (list<TAudioEffectInterfacePtr>::iterator iter = begin(); iter != end(); iter++) {
         TAudioEffectInterfacePtr process = *iter;
         process->Reset();
     }
+    if (fFused) {
+        fFused->Reset();
+    }
+}
+
+// Maximum number of channels used by the effects, 0 for an empty list
+
+long TAudioEffectList::Channels()
+{
+    long channels = 0;
+    for (list<TAudioEffectInterfacePtr>::iterator iter = begin(); iter != end(); iter++) {
+        TAudioEffectInterfacePtr process = *iter;
+        channels = UTools::Max(channels, process->Channels());
+    }
+    return channels;
 }
 
 TAudioEffectList::~TAudioEffectList()
 {
 	int i;
 	
+	TFusedCmd* cmd = Exchange(&fPendingFused, 0);
+	if (cmd) {
+		ReleaseFusedCmd(cmd);
+	}
+	if (fFused) {
+		fFused->removeReference();
+	}
+	CollectFused();
+	
 	for (i = 0; i < MAX_PLUG_CHANNELS; i++) {
-		free(fTemp1[i]);
+		UAudioTools::AlignedFree(fTemp1[i]);
 	}
 	for (i = 0; i < MAX_PLUG_CHANNELS; i++) {
-		free(fTemp2[i]);
+		UAudioTools::AlignedFree(fTemp2[i]);
 	}
 }
 
@@ -127,31 +272,55 @@ TAudioEffectListPtr TAudioEffectList::Copy()
 
     for (list<TAudioEffectInterfacePtr>::iterator iter = begin(); iter != end(); iter++) {
         TAudioEffectInterfacePtr process = *iter;
-        copy->push_front(process->Copy());
+        copy->push_back(process->Copy());
+    }
+    
+    // Compiled factory is shared, see TFaustFactoryTable
+    if (fFuseRequested) {
+        copy->Fuse();
     }
 
     return copy;
 }
 
-void TAudioEffectListManager::Process(float* buffer, long framesNum, long channels)
+// Take the pending list, only when no crossfade is running
+
+void TAudioEffectListManager::SwitchEffectList()
 {
-	if (fMutex.TryLock() == 0) {
-	
-		if (fSwitchEffect) {
-			if (fCurEffectList->GetStatus() == TAudioEffectList::kIdle) { // End of fCurEffectList FadeOut
-				fCurEffectList = fNextEffectList;
-				fSwitchEffect = false;
-			} else { // CrossFade both effects
-				memcpy(fTempBuffer, buffer, sizeof(float) * framesNum * channels);
-				fCurEffectList->Process(buffer, framesNum, channels);
-				fNextEffectList->Process(fTempBuffer, framesNum, channels);
-				UAudioTools::MixFrameToFrameBlk1(buffer, fTempBuffer, framesNum, channels);
-			}
+	if (fNextEffectList) {
+		if (fCurEffectList->GetStatus() == TAudioEffectList::kIdle) { // End of fCurEffectList FadeOut
+			Retire(fSwitchCmd, fCurEffectList);
+			fCurEffectList = fNextEffectList;
+			fNextEffectList = 0;
+			fSwitchCmd = 0;
+		}
+	} else if (fPendingCmd) {
+		TEffectListCmd* cmd = Exchange(&fPendingCmd, 0);
+		TAudioEffectList* effect_list = cmd->fList;
+		cmd->fList = 0;
+		if (cmd->fFadeIn == -1 && cmd->fFadeOut == -1) {  // Used to indicate immediate switch
+			effect_list->FadeIn(100, 100);
+			Retire(cmd, fCurEffectList);
+			fCurEffectList = effect_list;
 		} else {
-			fCurEffectList->Process(buffer, framesNum, channels);
+			fNextEffectList = effect_list;
+			fCurEffectList->FadeOut();
+			fNextEffectList->FadeIn(cmd->fFadeIn, cmd->fFadeOut);
+			fSwitchCmd = cmd;
 		}
-		
-		fMutex.Unlock();
 	}
 }
 
+void TAudioEffectListManager::Process(float* buffer, long framesNum, long channels)
+{
+	SwitchEffectList();
+	
+	if (fNextEffectList) { // CrossFade both effects
+		memcpy(fTempBuffer, buffer, sizeof(float) * framesNum * channels);
+		fCurEffectList->Process(buffer, framesNum, channels);
+		fNextEffectList->Process(fTempBuffer, framesNum, channels);
+		UAudioTools::MixFrameToFrameBlk1(buffer, fTempBuffer, framesNum, channels);
+	} else {
+		fCurEffectList->Process(buffer, framesNum, channels);
+	}
+}
@@ -24,10 +24,12 @@ research@grame.fr
 #define __TAudioEffect__
 
 #include "TAudioEffectInterface.h"
-#include "TAudioGlobals.h"
+#include "TAudioContext.h"
 #include "TAudioConstants.h"
+#include "UAudioTools.h"
 #include "Envelope.h"
-#include "TMutex.h"
+#include "TProfileAudioStream.h"
+#include "lflifo.h"
 #include <list>
 
 using namespace std;
@@ -40,6 +42,21 @@ class TAudioEffectList;
 
 typedef LA_SMARTP<TAudioEffectList> TAudioEffectListPtr;
 
+//-----------------
+// Struct TFusedCmd
+//-----------------
+/*!
+\brief A fused effect change, posted by the control thread and consumed by the audio thread.
+Once consumed, the same cell is used to hand the replaced fused effect back to the control thread for desallocation.
+*/
+
+typedef struct TFusedCmd
+{
+	lifocell fLink;					// Must be first, used to retire the cell
+	TAudioEffectInterface* fFused;	// Owns a reference, NULL when unfused
+	long fFusedCount;
+} TFusedCmd;
+
 // Using smartable1 cause crash when desallocating the object: desactivated for now
 // class TAudioEffectList : public list<TAudioEffectInterfacePtr>, public la_smartable1
 
@@ -47,6 +64,11 @@ typedef LA_SMARTP<TAudioEffectList> TAudioEffectListPtr;
 \brief  Effect list management for subclasses of TAudioEffectInterface.
 */
 
+/*
+The fused effect is only changed by the audio thread: Fuse and Unfuse post it in a pending slot, Process takes it 
+and retires the previous one, which is desallocated at the next Fuse or Unfuse call (or by the destructor).
+*/
+
 class TAudioEffectList : public list<TAudioEffectInterfacePtr>, public la_smartable
 {
 
@@ -59,20 +81,32 @@ class TAudioEffectList : public list<TAudioEffectInterfacePtr>, public la_smarta
         Envelope fFadeOut;   	// FadeOut object
 		long fFadeInFrames;		// Number of frames for FadeIn
         long fFadeOutFrames;	// Number of frames for FadeOut
+		TAudioEffectInterface* fFused;		// Faust effects of the list compiled as a single effect, audio thread (owns a reference)
+		long fFusedCount;		// Number of effects in the list when fused
+		TFusedCmd* volatile fPendingFused;	// Posted by the control thread
+		lifo fRetiredFused;		// Consumed cells holding replaced fused effects
+		bool fFuseRequested;	// Control thread view
+		vector<TProfileCounterPtr> fProfiles;	// Per effect counters, when profiled
 		
 		void Init(float v1, float f1, float v2, float f2);
+		bool IsFused();
+		void SwitchFused();		// Called in RT
+		void PostFused(TAudioEffectInterface* fused, long count);
+		void CollectFused();
 		
     public:
 		enum {kIdle = 0, kFadeIn, kPlaying, kFadeOut};
 
-        TAudioEffectList():fFadeInFrames(0),fFadeOutFrames(0)
+        TAudioEffectList():fFadeInFrames(0),fFadeOutFrames(0),fFused(0),fFusedCount(0),fPendingFused(0),fFuseRequested(false)
         {
 			int i;
+			lfinit(&fRetiredFused);
+			long bufferSize = TAudioContext::GetCurrent()->fBufferSize;
 			for (i = 0; i < MAX_PLUG_CHANNELS; i++) {
-				fTemp1[i] = (float*)calloc(TAudioGlobals::fBufferSize, sizeof(float));
+				fTemp1[i] = UAudioTools::AlignedCalloc(bufferSize);
 			}
 			for (i = 0; i < MAX_PLUG_CHANNELS; i++) {
-				fTemp2[i] = (float*)calloc(TAudioGlobals::fBufferSize, sizeof(float));
+				fTemp2[i] = UAudioTools::AlignedCalloc(bufferSize);
 			}
 			fStatus = kIdle;
 		}
@@ -81,6 +115,21 @@ class TAudioEffectList : public list<TAudioEffectInterfacePtr>, public la_smarta
         virtual void Process(float* buffer, long framesNum, long channels);
         TAudioEffectListPtr Copy();
         void Reset();
+        long Channels();
+        
+        bool Fuse();
+        void Unfuse();
+
+        // Allocate a counter per effect (a fused list is profiled as a whole by its stream)
+        void Profile();
+        long GetProfileCount()
+        {
+            return long(fProfiles.size());
+        }
+        TProfileCounterPtr GetProfile(long index)
+        {
+            return fProfiles[index];
+        }
 		
 		void FadeIn(long fadeIn, long fadeOut);
 		void FadeOut();
@@ -90,12 +139,34 @@ class TAudioEffectList : public list<TAudioEffectInterfacePtr>, public la_smarta
 		}
 };
 
+//-----------------------
+// Struct TEffectListCmd
+//-----------------------
+/*!
+\brief A effect list switch request, posted by the control thread and consumed by the audio thread. 
+Once consumed, the same cell is used to hand the replaced list back to the control thread for desallocation.
+*/
+
+typedef struct TEffectListCmd
+{
+	lifocell fLink;					// Must be first, used to retire the cell
+	TAudioEffectList* fList;		// Owns a reference
+	long fFadeIn;
+	long fFadeOut;
+} TEffectListCmd;
+
 //-------------------------------
 // Class TAudioEffectListManager
 //-------------------------------
 
 /*!
 \brief  Effect list management: handle crossfade between effects.
+New lists are posted in a single pending slot with an atomic swap, the audio thread takes them when 
+no crossfade is running. Replaced lists are retired in a lock-free stack and desallocated by the control thread,
+at the next call of the owner (channel or mixer) on the control thread. The audio thread never waits and never skips processing.
+
+GetEffectList returns the last list given to SetEffectList, which is held by the control thread (fPublishedList) 
+and thus never retired under the caller.
 */
 
 class TAudioEffectListManager {
@@ -103,44 +174,114 @@ class TAudioEffectListManager {
 	  private: 
 	  
 		float* fTempBuffer; 					// Used for crossfade
-		TAudioEffectListPtr	fCurEffectList;		// Current Effect list
-		TAudioEffectListPtr	fNextEffectList;	// Next Effect list
-		bool fSwitchEffect;
-		TMutex fMutex;
+		TAudioEffectList* fCurEffectList;		// Current Effect list (owns a reference)
+		TAudioEffectList* fNextEffectList;		// Next Effect list (owns a reference)
+		TAudioEffectList* fPublishedList;		// Last list set, control thread only (owns a reference)
+		TEffectListCmd* fSwitchCmd;				// Cell of the running switch
+		TEffectListCmd* volatile fPendingCmd;	// Posted by the control thread
+		lifo fRetiredCmd;						// Consumed cells holding replaced lists
+		
+		static TEffectListCmd* Exchange(TEffectListCmd* volatile* slot, TEffectListCmd* cmd)
+		{
+			TEffectListCmd* old;
+			do {
+				old = *slot;
+			} while (!CAS(slot, old, cmd));
+			return old;
+		}
+		
+		static void ReleaseCmd(TEffectListCmd* cmd)
+		{
+			if (cmd->fList) {
+				cmd->fList->removeReference();
+			}
+			delete cmd;
+		}
+		
+		void Retire(TEffectListCmd* cmd, TAudioEffectList* list) // Called in RT
+		{
+			cmd->fList = list;
+			lfpush(&fRetiredCmd, &cmd->fLink);
+		}
+		
+		void CollectRetired()
+		{
+			TEffectListCmd* cmd;
+			while ((cmd = (TEffectListCmd*)lfpop(&fRetiredCmd))) {
+				ReleaseCmd(cmd);
+			}
+		}
+		
+		void SwitchEffectList(); // Called in RT
 	
 	public:
 	
-		TAudioEffectListManager():fCurEffectList(new TAudioEffectList()),fNextEffectList(0),fSwitchEffect(false)
+		TAudioEffectListManager():fNextEffectList(0),fSwitchCmd(0),fPendingCmd(0)
 		{
-			fTempBuffer = new float[TAudioGlobals::fBufferSize * TAudioGlobals::fOutput]; // A revoir
+			fCurEffectList = new TAudioEffectList();
+			fCurEffectList->addReference();
+			fPublishedList = fCurEffectList;
+			fPublishedList->addReference();
+			lfinit(&fRetiredCmd);
+			TAudioContextPtr context = TAudioContext::GetCurrent();
+			fTempBuffer = new float[context->fBufferSize * context->fOutput]; // A revoir
 		}
 		
 		virtual ~TAudioEffectListManager()
 		{
+			TEffectListCmd* cmd = Exchange(&fPendingCmd, 0);
+			if (cmd) {
+				ReleaseCmd(cmd);
+			}
+			if (fSwitchCmd) {
+				ReleaseCmd(fSwitchCmd);
+			}
+			if (fNextEffectList) {
+				fNextEffectList->removeReference();
+			}
+			fCurEffectList->removeReference();
+			fPublishedList->removeReference();
+			CollectRetired();
 			delete[] fTempBuffer;
 		}
 
-		// TO IMPROVE : this will fail if an effect is still in switch mode...
+		// Called by the control thread : a list posted before the previous one was taken replaces it
 		void SetEffectList(TAudioEffectListPtr effect_list, long fadeIn, long fadeOut)
 		{
-			fMutex.Lock();
+			CollectRetired();
 			
-			if (!fSwitchEffect) { 
-				fNextEffectList = effect_list;
-				fCurEffectList->FadeOut();
-				fNextEffectList->FadeIn(fadeIn, fadeOut);
-	 			fSwitchEffect = true;
-			} else if (fadeIn == -1 && fadeOut == -1) {  // Used to indicate immediate switch
-				effect_list->FadeIn(100, 100);
-				fCurEffectList = effect_list;
-			}
+			TEffectListCmd* cmd = new TEffectListCmd;
+			cmd->fList = effect_list;
+			cmd->fList->addReference();
+			cmd->fFadeIn = fadeIn;
+			cmd->fFadeOut = fadeOut;
 			
-			fMutex.Unlock();
+			effect_list->addReference();
+			fPublishedList->removeReference();
+			fPublishedList = effect_list;
+			
+			TEffectListCmd* old = Exchange(&fPendingCmd, cmd);
+			if (old) {
+				ReleaseCmd(old);
+			}
 		}
 	
-		TAudioEffectListPtr GetEffectList() // Called in RT
+		// Called by the control thread
+		TAudioEffectListPtr GetEffectList() 
+		{
+			CollectRetired();
+			return fPublishedList;
+		}
+		
+		// Called by the control thread : desallocates the lists replaced by the audio thread
+		void Collect()
+		{
+			CollectRetired();
+		}
+		
+		bool IsEmpty() // Called in RT
 		{
-			return fCurEffectList;
+			return !fNextEffectList && !fPendingCmd && fCurEffectList->size() == 0;
 		}
 		
 		void Process(float* buffer, long framesNum, long channels);
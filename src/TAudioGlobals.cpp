@@ -24,7 +24,7 @@ research@grame.fr
 #include "TAudioConstants.h"
 #include "TPanTable.h"
 #include "TRendererAudioStream.h"
-#include "TSharedBuffers.h"
+#include "TAudioLog.h"
 
 #ifndef WIN32
 	#include <sys/errno.h>
@@ -32,8 +32,6 @@ research@grame.fr
 #endif
 
 // Globals
-float* TSharedBuffers::fInBuffer = NULL;
-float* TSharedBuffers::fOutBuffer = NULL;
 
 float TPanTable::fPanTable[128];
 float TPanTable::fVolTable[128];
@@ -44,16 +42,6 @@ TAudioGlobalsPtr TAudioGlobals::fInstance = NULL;
 long TAudioGlobals::fClientCount = 0;
 SHORT_BUFFER TAudioGlobals::fInBuffer = 0;
 
-long TAudioGlobals::fInput = 0;
-long TAudioGlobals::fOutput = 0;
-long TAudioGlobals::fChannels = 0;
-
-long TAudioGlobals::fBufferSize = 0;
-long TAudioGlobals::fStreamBufferSize = 0;
-long TAudioGlobals::fRTStreamBufferSize = 0;
-
-long TAudioGlobals::fSampleRate = 0;
-long TAudioGlobals::fDiskError = 0;
 long TAudioGlobals::fFileMax = 0;
 
 long TAudioGlobals::fInputLatency = -1;
@@ -101,6 +89,7 @@ void TAudioGlobals::Init(long inChan, long outChan, long channels, long sample_r
 		TDTRendererAudioStream::Init();
 		TRTRendererAudioStream::Init(thread_num);
 		la_smartable1::Init();
+		TAudioLog::Start();
 		TPanTable::FillTable();
 		GetMaximumFiles(&fFileMax);
 		SetMaximumFiles(1024);
@@ -113,6 +102,7 @@ void TAudioGlobals::Destroy()
 		TDTRendererAudioStream::Destroy();
 		TRTRendererAudioStream::Destroy();
 		la_smartable1::Destroy();
+		TAudioLog::Stop();
 		delete fInstance;
 		fInstance = NULL;
 		SetMaximumFiles(fFileMax);
@@ -124,14 +114,8 @@ TAudioGlobals::TAudioGlobals(long inChan, long outChan, long channels, long samp
 {
     fInBuffer = new TLocalAudioBuffer<short>(rtstream_buffer_size, inChan);
     assert(fInBuffer);
-    fInput = inChan;
-    fOutput = outChan;
-    fChannels = channels;
-    fBufferSize = buffer_size;
-    fStreamBufferSize = stream_buffer_size;
-    fRTStreamBufferSize = rtstream_buffer_size;
-    fSampleRate = sample_rate;
-    fDiskError = 0;
+    TAudioContext::GetDefault()->Set(inChan, outChan, channels, sample_rate,
+                                     buffer_size, stream_buffer_size, rtstream_buffer_size);
 }
 
 TAudioGlobals::~TAudioGlobals()
@@ -141,5 +125,5 @@ TAudioGlobals::~TAudioGlobals()
 
 void TAudioGlobals::LogError()
 {
-    printf("Disk Streaming errors : %ld\n", fDiskError);
+    printf("Disk Streaming errors : %ld\n", TAudioContext::GetDefault()->fDiskError);
 }
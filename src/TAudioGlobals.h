@@ -25,6 +25,7 @@ research@grame.fr
 
 #include "AudioExports.h"
 #include "TAudioBuffer.h"
+#include "TAudioContext.h"
 
 //---------------------
 // Class TAudioGlobals
@@ -33,6 +34,10 @@ research@grame.fr
 \brief Global state.
 */
 
+/*
+The engine parameters given to Init are those of the default TAudioContext.
+*/
+
 class AUDIO_EXPORTS TAudioGlobals
 {
 
@@ -44,14 +49,6 @@ class AUDIO_EXPORTS TAudioGlobals
     public:
 
         static SHORT_BUFFER fInBuffer;          // Shared buffer for Real-Time stream
-        static long fInput;                     // Number of input channels
-        static long fOutput;                    // Number of output channels
-        static long fChannels;                  // Number of sound channels
-        static long fSampleRate;                // Sampling Rate
-        static long fBufferSize;                // I/O Buffer size
-        static long fStreamBufferSize;          // Stream Buffer size
-        static long fRTStreamBufferSize;        // Real-Time Stream Buffer size
-        static long fDiskError;                 // Counter of disk streaming errors
 		static long fFileMax;
 
 		static long fInputLatency;				// Suggested input latency (when used with PortAudio)
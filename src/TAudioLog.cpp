@@ -0,0 +1,206 @@
+/*
+
+Copyright (C) Grame 2002-2013
+
+This library is free software; you can redistribute it and modify it under
+the terms of the GNU Library General Public License as published by the
+Free Software Foundation version 2 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public License
+for more details.
+
+You should have received a copy of the GNU Library General Public License
+along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+Grame Research Laboratory, 9, rue du Garet 69001 Lyon - France
+research@grame.fr
+
+*/
+
+#include "TAudioLog.h"
+#include "UTools.h"
+#include "msAtomic.h"
+#include <stdio.h>
+#include <stdarg.h>
+
+#ifdef WIN32
+	#define LogSleep(val) Sleep(val)
+#else
+	#include <unistd.h>
+	#define LogSleep(val) usleep(val*1000)
+#endif
+
+TAudioLog::TLogRecord TAudioLog::fRecords[kRecords];
+volatile unsigned long TAudioLog::fWrite = 0;
+volatile unsigned long TAudioLog::fRead = 0;
+volatile long TAudioLog::fDropped = 0;
+volatile long TAudioLog::fWindow = 0;
+volatile long TAudioLog::fWindowCount = 0;
+long TAudioLog::fRate = 50;
+LogCallback TAudioLog::fCallback = 0;
+void* TAudioLog::fContext = 0;
+volatile bool TAudioLog::fRunning = false;
+#if defined(__APPLE__) || defined(linux)
+pthread_t TAudioLog::fThread;
+#elif WIN32
+HANDLE TAudioLog::fThread = 0;
+#endif
+
+#if defined(__APPLE__) || defined(linux)
+
+void* TAudioLog::Process(void* arg)
+{
+    while (fRunning) {
+        Drain();
+        LogSleep(10);
+    }
+    Drain();
+    return 0;
+}
+
+#elif WIN32
+
+DWORD WINAPI TAudioLog::Process(void* arg)
+{
+    while (fRunning) {
+        Drain();
+        LogSleep(10);
+    }
+    Drain();
+    return 0;
+}
+
+#endif
+
+bool TAudioLog::Allow()
+{
+    long window = long(UTools::GetTime());
+    if (window != fWindow) {
+        fWindow = window;
+        fWindowCount = 0;
+    }
+    if (msAtomicAdd(&fWindowCount, 1) > fRate) {
+        msAtomicAdd(&fDropped, 1);
+        return false;
+    } else {
+        return true;
+    }
+}
+
+void TAudioLog::Output(const char* message)
+{
+    if (fCallback) {
+        fCallback(fContext, message);
+    } else {
+        printf("%s", message);
+    }
+}
+
+// Called by the drain thread
+void TAudioLog::Drain()
+{
+    while (fRead != fWrite) {
+        TLogRecord& record = fRecords[fRead % kRecords];
+        // Claimed but not yet published
+        if (!record.fReady) {
+            break;
+        }
+        Output(record.fText);
+        record.fReady = 0;
+        unsigned long read = fRead;
+        CAS(&fRead, (void*)read, (void*)(read + 1));
+    }
+
+    long dropped = fDropped;
+    if (dropped > 0 && CAS(&fDropped, (void*)dropped, (void*)0)) {
+        char text[kTextSize];
+        snprintf(text, kTextSize, "TAudioLog : %ld messages dropped\n", dropped);
+        Output(text);
+    }
+}
+
+void TAudioLog::Log(const char* format, ...)
+{
+    va_list args;
+
+    if (!Allow()) {
+        return;
+    }
+
+    if (!fRunning) {
+        char text[kTextSize];
+        va_start(args, format);
+        vsnprintf(text, kTextSize, format, args);
+        va_end(args);
+        Output(text);
+        return;
+    }
+
+    unsigned long index;
+    do {
+        index = fWrite;
+        if (index - fRead >= kRecords) {
+            msAtomicAdd(&fDropped, 1);
+            return;
+        }
+    } while (!CAS(&fWrite, (void*)index, (void*)(index + 1)));
+
+    TLogRecord& record = fRecords[index % kRecords];
+    va_start(args, format);
+    vsnprintf(record.fText, kTextSize, format, args);
+    va_end(args);
+    CAS(&record.fReady, (void*)0, (void*)1);
+}
+
+void TAudioLog::Start()
+{
+    if (fRunning) {
+        return;
+    }
+
+    fRunning = true;
+#if defined(__APPLE__) || defined(linux)
+    if (pthread_create(&fThread, NULL, Process, 0) != 0) {
+        fRunning = false;
+    }
+#elif WIN32
+    DWORD id;
+    if (!(fThread = CreateThread(NULL, 0, Process, 0, 0, &id))) {
+        fRunning = false;
+    }
+#endif
+
+    if (!fRunning) {
+        printf("TAudioLog::Start : cannot create thread\n");
+    }
+}
+
+void TAudioLog::Stop()
+{
+    if (!fRunning) {
+        return;
+    }
+
+    // The thread drains the remaining messages
+    fRunning = false;
+#if defined(__APPLE__) || defined(linux)
+    pthread_join(fThread, NULL);
+#elif WIN32
+    WaitForSingleObject(fThread, INFINITE);
+    CloseHandle(fThread);
+#endif
+}
+
+void TAudioLog::SetCallback(LogCallback callback, void* context)
+{
+    fContext = context;
+    fCallback = callback;
+}
+
+void TAudioLog::SetRate(long rate)
+{
+    fRate = rate;
+}
@@ -0,0 +1,102 @@
+/*
+
+Copyright (C) Grame 2002-2013
+
+This library is free software; you can redistribute it and modify it under
+the terms of the GNU Library General Public License as published by the
+Free Software Foundation version 2 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public License
+for more details.
+
+You should have received a copy of the GNU Library General Public License
+along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+Grame Research Laboratory, 9, rue du Garet 69001 Lyon - France
+research@grame.fr
+
+*/
+
+#ifndef __TAudioLog__
+#define __TAudioLog__
+
+#if defined(__APPLE__) || defined(linux)
+	#include <pthread.h>
+#elif WIN32
+	#include <windows.h>
+#endif
+
+typedef void (*LogCallback)(void* context, const char* message);
+
+//-----------------
+// Class TAudioLog
+//-----------------
+/*!
+\brief Messages of the audio and command manager threads, printed by a drain thread.
+*/
+
+/*
+Log can be called from any thread, and never blocks: a record of the ring is claimed with a CAS,
+the message is formatted in it and the record is published. The drain thread gives the published
+messages to the sink (printf by default, or a callback set by the application) outside of the
+real-time threads. When the ring is full, messages are dropped and counted.
+
+Messages are limited to fRate per second (approximately, the window is not locked): a message
+in a loop of the audio callback cannot flood the sink. Dropped messages are reported by the drain thread.
+
+Before Start and after Stop, messages are given to the sink by the calling thread.
+*/
+
+class TAudioLog
+{
+
+    private:
+
+        enum { kRecords = 256, kTextSize = 256 };
+
+        struct TLogRecord
+        {
+            volatile long fReady;
+            char fText[kTextSize];
+        };
+
+        static TLogRecord fRecords[kRecords];
+        static volatile unsigned long fWrite;
+        static volatile unsigned long fRead;
+        static volatile long fDropped;
+        static volatile long fWindow;           // Current rate limiting window, in seconds
+        static volatile long fWindowCount;
+        static long fRate;
+
+        static LogCallback fCallback;
+        static void* fContext;
+
+        static volatile bool fRunning;
+    #if defined(__APPLE__) || defined(linux)
+        static pthread_t fThread;
+        static void* Process(void* arg);
+    #elif WIN32
+        static HANDLE fThread;
+        static DWORD WINAPI Process(void* arg);
+    #endif
+
+        static bool Allow();
+        static void Drain();
+        static void Output(const char* message);
+
+    public:
+
+        static void Start();
+        static void Stop();
+
+        // printf like, messages end with a new line
+        static void Log(const char* format, ...);
+
+        static void SetCallback(LogCallback callback, void* context);
+        static void SetRate(long rate);
+};
+
+#endif
@@ -27,22 +27,22 @@ research@grame.fr
 #include "TAudioMixer.h"
 #include "UAudioTools.h"
 #include "TPanTable.h"
-#include "TSharedBuffers.h"
+#include "TAudioLog.h"
 
 /*--------------------------------------------------------------------------*/
 // Internal API
 /*--------------------------------------------------------------------------*/
 
-TAudioMixer::TAudioMixer ()
+TAudioMixer::TAudioMixer (): fContext(TAudioContext::GetCurrent())
 {
     // Initialisation
     SetVol(DEFAULT_VOL);
     SetPan(DEFAULT_PAN_LEFT, DEFAULT_PAN_RIGHT);
 
-    fMixBuffer = new TLocalAudioBuffer<float>(TAudioGlobals::fBufferSize, TAudioGlobals::fOutput);
-    fSoundChannelTable = new TAudioChannelPtr[TAudioGlobals::fChannels];
+    fMixBuffer = new TLocalAudioBuffer<float>(fContext->fBufferSize, fContext->fOutput);
+    fSoundChannelTable = new TAudioChannelPtr[fContext->fChannels];
 
-    for (int j = 0; j < TAudioGlobals::fChannels; j++) {
+    for (int j = 0; j < fContext->fChannels; j++) {
         fSoundChannelTable[j] = new TAudioChannel();
         assert(fSoundChannelTable[j]);
     }
@@ -50,7 +50,7 @@ TAudioMixer::TAudioMixer ()
 
 TAudioMixer::~TAudioMixer()
 {
-    for (int j = 0; j < TAudioGlobals::fChannels; j++) {
+    for (int j = 0; j < fContext->fChannels; j++) {
         delete fSoundChannelTable[j];
     }
     delete[] fSoundChannelTable;
@@ -59,14 +59,18 @@ TAudioMixer::~TAudioMixer()
 
 bool TAudioMixer::AudioCallback(float* inputBuffer, float* outputBuffer, long frames)
 {
+    // Buffers read by the input streams of the engine
+    fContext->fInBuffer = inputBuffer;
+    fContext->fOutBuffer = outputBuffer;
+
     // Init buffer
-    UAudioTools::ZeroFloatBlk(fMixBuffer->GetFrame(0), TAudioGlobals::fBufferSize, TAudioGlobals::fOutput);
+    UAudioTools::ZeroFloatBlk(fMixBuffer->GetFrame(0), fContext->fBufferSize, fContext->fOutput);
 	
     // Mix all SoundChannels
 	list<TAudioChannelPtr>::iterator iter = fSoundChannelSeq.begin();
 	while (iter != fSoundChannelSeq.end()) {
 		TAudioChannelPtr channel = *iter;
-		if (!channel->Mix(fMixBuffer, TAudioGlobals::fBufferSize, TAudioGlobals::fOutput)) { // End of channel
+		if (!channel->Mix(fMixBuffer, fContext->fBufferSize, fContext->fOutput)) { // End of channel
             channel->SetState(false); // Important : used to mark the insertion state
             iter = fSoundChannelSeq.erase(iter);
 		} else {
@@ -75,13 +79,13 @@ bool TAudioMixer::AudioCallback(float* inputBuffer, float* outputBuffer, long fr
 	}
 	
 	// Master Effects
-	fEffectList.Process(fMixBuffer->GetFrame(0), TAudioGlobals::fBufferSize, TAudioGlobals::fOutput);
+	fEffectList.Process(fMixBuffer->GetFrame(0), fContext->fBufferSize, fContext->fOutput);
 	
     // Master Pan and Vol
 	UAudioTools::MixFrameToFrameBlk(outputBuffer,
 									fMixBuffer->GetFrame(0),
-									TAudioGlobals::fBufferSize,
-									TAudioGlobals::fOutput, fLLVol, fLRVol, fRLVol, fRRVol);
+									fContext->fBufferSize,
+									fContext->fOutput, fLLVol, fLRVol, fRLVol, fRRVol);
     return true;
 }
 
@@ -91,6 +95,7 @@ bool TAudioMixer::AudioCallback(float* inputBuffer, float* outputBuffer, long fr
 
 long TAudioMixer::Load(TAudioStreamPtr stream, long chan, float vol, float panLeft, float panRight)
 {
+    CollectEffectLists(chan);
     if (IsAvailable(chan)) {
         TAudioChannelPtr channel = fSoundChannelTable[chan];
         assert(channel);
@@ -100,7 +105,7 @@ long TAudioMixer::Load(TAudioStreamPtr stream, long chan, float vol, float panLe
         channel->SetPan(panLeft, panRight);
         return NO_ERR;
     } else {
-        printf("Allocate : Channel already inserted  %ld\n", chan);
+        TAudioLog::Log("Allocate : Channel already inserted  %ld\n", chan);
         return LOAD_ERR;
     }
 }
@@ -108,6 +113,7 @@ long TAudioMixer::Load(TAudioStreamPtr stream, long chan, float vol, float panLe
 void TAudioMixer::Start(long chan)
 {
     TAudioChannelPtr channel;
+    CollectEffectLists(chan);
 
     if (IsAvailable(chan) && (channel = fSoundChannelTable[chan])) {
         channel->Reset();
@@ -116,13 +122,14 @@ void TAudioMixer::Start(long chan)
 		// This is supposed to be unsafe since fSoundChannelSeq list is also read in AudioCallback thread... but no crash even occured
         fSoundChannelSeq.push_front(channel);
     } else {
-        printf("Start : Channel already playing : %ld\n", chan);
+        TAudioLog::Log("Start : Channel already playing : %ld\n", chan);
     }
 }
 
 void TAudioMixer::Play(long chan)
 {
     TAudioChannelPtr channel;
+    CollectEffectLists(chan);
 
     if (IsAvailable(chan) && (channel = fSoundChannelTable[chan])) {
         channel->SoundOn();
@@ -130,7 +137,7 @@ void TAudioMixer::Play(long chan)
 		// This is supposed to be unsafe since fSoundChannelSeq list is also read in AudioCallback thread... but no crash even occured
         fSoundChannelSeq.push_front(channel);
     } else {
-        printf("Start : Channel already playing : %ld\n", chan);
+        TAudioLog::Log("Start : Channel already playing : %ld\n", chan);
     }
 }
 
@@ -139,6 +146,7 @@ void TAudioMixer::Play(long chan)
 void TAudioMixer::Stop(long chan)
 {
     TAudioChannelPtr channel;
+    CollectEffectLists(chan);
     if (IsValid(chan) && (channel = fSoundChannelTable[chan])) {
         channel->SoundOff(true);
     }
@@ -147,6 +155,7 @@ void TAudioMixer::Stop(long chan)
 void TAudioMixer::Abort(long chan)
 {
     TAudioChannelPtr channel;
+    CollectEffectLists(chan);
     if (IsValid(chan) && (channel = fSoundChannelTable[chan])) {
         channel->SoundOff(false);
     }
@@ -185,6 +194,7 @@ StopCallback TAudioMixer::GetStopCallback(long chan)
 void TAudioMixer::GetInfo(long chan, ChannelInfo* info)
 {
     TAudioChannelPtr channel;
+    CollectEffectLists(chan);
     if (IsValid(chan) && (channel = fSoundChannelTable[chan])) {
         channel->GetInfo(info);
     }
@@ -25,7 +25,7 @@ research@grame.fr
 
 #include "TAudioClient.h"
 #include "TAudioChannel.h"
-#include "TAudioGlobals.h"
+#include "TAudioContext.h"
 #include <list>
 
 //-------------------
@@ -40,6 +40,7 @@ class TAudioMixer : public TAudioClient
 
     private:
 
+		TAudioContextPtr fContext;					// Context of the engine
 		TAudioEffectListManager	fEffectList;		// Master effect list
 		list<TAudioChannelPtr>	fSoundChannelSeq;	// List of running sound channels
         TAudioChannelPtr*		fSoundChannelTable;	// Table of sound channels
@@ -54,14 +55,23 @@ class TAudioMixer : public TAudioClient
   
         bool IsAvailable(long chan)
         {
-            return ((chan >= 0) && (chan < TAudioGlobals::fChannels) && !fSoundChannelTable[chan]->GetState());
+            return ((chan >= 0) && (chan < fContext->fChannels) && !fSoundChannelTable[chan]->GetState());
         }
         bool IsValid(long chan)
         {
-            return ((chan >= 0) && (chan < TAudioGlobals::fChannels));
+            return ((chan >= 0) && (chan < fContext->fChannels));
         }
 
         bool AudioCallback(float* inputBuffer, float* outputBuffer, long frames);
+        
+        // Desallocates the effect lists replaced by the audio thread, called by the control thread
+        void CollectEffectLists(long chan)
+        {
+            fEffectList.Collect();
+            if (IsValid(chan) && fSoundChannelTable[chan]) {
+                fSoundChannelTable[chan]->CollectEffectLists();
+            }
+        }
 
     public:
 
@@ -22,7 +22,10 @@ research@grame.fr
 
 #include "TAudioRenderer.h"
 #include "UAudioTools.h"
-#include "TSharedBuffers.h"
+#include "TTraceRecorder.h"
+#include "TRTChecker.h"
+#include "UTools.h"
+#include "msAtomic.h"
 
 long TAudioRenderer::OpenDefault(long inChan, long outChan, long bufferSize, long sampleRate)
 {
@@ -44,19 +47,77 @@ long TAudioRenderer::Open(long inputDevice, long outputDevice, long inChan, long
 
 void TAudioRenderer::Run(float* inputBuffer, float* outputBuffer, long frames)
 {
+    RTCheckEnter();
+    double start = UTools::GetTime();
+    double end;
+    double period = (fSampleRate > 0) ? double(frames) / double(fSampleRate) : 0;
+    list<TRTAudioClient>::iterator iter;
+
+    if (fResetStats) {
+        fStats.Reset();
+        for (iter = fClientList.begin(); iter != fClientList.end(); iter++) {
+            (*iter).fStats.Reset();
+        }
+        fLastCallback = 0;
+        fResetStats = false;
+    }
+    if (fLastCallback > 0) {
+        fStats.AddInterval(start - fLastCallback, period);
+    }
+    fLastCallback = start;
+    TTraceRecorder::SetThreadName("Audio callback");
+
     UAudioTools::ZeroFloatBlk(outputBuffer, frames, fOutput);
-    TSharedBuffers::SetInBuffer(inputBuffer);
-    TSharedBuffers::SetOutBuffer(outputBuffer);
 
 	// Client callback are supposed to *mix* their result in outputBuffer 
-	list<TRTAudioClient>::iterator iter = fClientList.begin();
+	iter = fClientList.begin();
 	while (iter != fClientList.end()) {
 		TAudioClientPtr client = (*iter).fRTClient;
 		if (client) {
+            double clientStart = UTools::GetTime();
             client->AudioCallback(inputBuffer, outputBuffer, frames);
+            end = UTools::GetTime();
+            (*iter).fStats.AddCallback(end - clientStart, period);
+            TTraceRecorder::Complete("Audio client", clientStart, end, client);
 			iter++;
 		} else {  // Client was removed
 			iter = fClientList.erase(iter);
 		}
 	}
+
+    // Copy the client timings for GetStats
+    long count = 0;
+    msAtomicSet(&fClientStatsSeq, fClientStatsSeq + 1);
+    for (iter = fClientList.begin(); iter != fClientList.end() && count < MAX_STATS_CLIENTS; iter++) {
+        if ((*iter).fRTClient) {
+            (*iter).fStats.Get(&fClientStats[count++]);
+        }
+    }
+    fClientStatsCount = count;
+    msAtomicSet(&fClientStatsSeq, fClientStatsSeq + 1);
+
+    end = UTools::GetTime();
+    fStats.AddCallback(end - start, period);
+    TTraceRecorder::Complete("Audio callback", start, end, 0);
+    RTCheckLeave();
+}
+
+// The client list is not walked here: the audio thread may erase from it
+long TAudioRenderer::GetStats(long client, TimingStatsPtr stats)
+{
+    unsigned long seq;
+    long count;
+
+    if (client < 0) {
+        fStats.Get(stats);
+    }
+    // Copy again if the audio thread copied the timings meanwhile
+    do {
+        seq = fClientStatsSeq;
+        count = fClientStatsCount;
+        if (client >= 0 && client < count) {
+            *stats = fClientStats[client];
+        }
+    } while ((seq & 1) || seq != fClientStatsSeq);
+    return (client < count) ? count : -1;
 }
@@ -25,6 +25,7 @@ research@grame.fr
 
 #include "TAudioClient.h"
 #include "AudioExports.h"
+#include "TTimingStats.h"
 #include <list>
 
 using namespace std;
@@ -35,6 +36,8 @@ using namespace std;
 #define LOAD_ERR            -3
 #define FILE_NOT_FOUND_ERR  -4
 
+#define MAX_STATS_CLIENTS   16
+
 typedef struct RendererInfo * RendererInfoPtr;
 /*!
 \brief To get renderer state.
@@ -75,6 +78,7 @@ struct TRTAudioClient : public TAudioClient
 {
 
 	TAudioClient* fRTClient;
+	TTimingStats fStats;		// Timing of the client callback
 
 	TRTAudioClient(TAudioClient* client):fRTClient(client)
 	{}
@@ -106,11 +110,21 @@ class AUDIO_EXPORTS TAudioRenderer
         long fOutput;
         long fBufferSize;
 
+        TTimingStats fStats;            // Timing of the whole callback, audio thread only
+        double fLastCallback;           // Start time of the previous callback
+        volatile bool fResetStats;      // Reset requested by the control thread
+
+        // Client timings copied by the audio thread after each callback: the client list is erased in the audio thread
+        TimingStats fClientStats[MAX_STATS_CLIENTS];
+        long fClientStatsCount;
+        volatile unsigned long fClientStatsSeq;     // Odd while the audio thread copies the timings
+
+
         void Run(float* inputBuffer, float* outputBuffer, long frames);
 
     public:
 
-        TAudioRenderer():fSampleRate(0)
+        TAudioRenderer():fSampleRate(0), fLastCallback(0), fResetStats(false), fClientStatsCount(0), fClientStatsSeq(0)
         {}
         virtual ~TAudioRenderer()
         {}
@@ -143,6 +157,15 @@ class AUDIO_EXPORTS TAudioRenderer
 		virtual long GetDefaultInputDevice() = 0;
 		virtual long GetDefaultOutputDevice() = 0;
         
+        // Timing of the whole callback (client < 0) or of a client callback, returns the number of clients (or -1 for a wrong client)
+        // Only the first MAX_STATS_CLIENTS clients are measured
+        long GetStats(long client, TimingStatsPtr stats);
+        // Reset is done by the next callback
+        void ResetStats()
+        {
+            fResetStats = true;
+        }
+
         long GetInputs() { return fInput; }
         long GetOutputs() { return fOutput; }
 
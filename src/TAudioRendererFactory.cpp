@@ -38,6 +38,8 @@ research@grame.fr
 #include "TCoreAudioRenderer.h"
 #endif
 
+#include "TNullAudioRenderer.h"
+
 TAudioRendererPtr TAudioRendererFactory::MakeAudioRenderer(int renderer)
 {
 	try {
@@ -78,6 +80,12 @@ TAudioRendererPtr TAudioRendererFactory::MakeAudioRenderer(int renderer)
 			#endif
 				return NULL;
 			#endif
+
+			case kNullRenderer:
+				return new TNullAudioRenderer(true);
+
+			case kFreeNullRenderer:
+				return new TNullAudioRenderer(false);
 				
 			default:
 				return NULL;
@@ -26,8 +26,10 @@ research@grame.fr
 #include "TAudioConstants.h"
 #include "UAudioTools.h"
 #include "TAudioBuffer.h"
+#include "TAudioContext.h"
 #include "la_smartpointer.h"
 #include <stdio.h>
+#include <vector>
 
 //--------------------
 // Class TAudioStream
@@ -44,13 +46,22 @@ typedef LA_SMARTP<TAudioStream>  TAudioStreamPtr;
 class TAudioStream : public la_smartable
 {
 
+    protected:
+
+        TAudioContextPtr fContext;  // Context of the thread that built the stream
+
     public:
 
-        TAudioStream()
+        TAudioStream(): fContext(TAudioContext::GetCurrent())
         {}
         virtual ~TAudioStream()
         {}
 
+        TAudioContextPtr GetContext()
+        {
+            return fContext;
+        }
+
         virtual long Write(FLOAT_BUFFER buffer, long framesNum, long framePos, long channels)
         {
             return 0;
@@ -101,6 +112,8 @@ class TAudioStream : public la_smartable
 class TUnaryAudioStream
 {
 
+    friend class TProfiler;
+
     protected:
 
         TAudioStreamPtr fStream; // Decorated stream
@@ -118,6 +131,43 @@ class TUnaryAudioStream
 
 typedef TUnaryAudioStream * TUnaryAudioStreamPtr;
 
+//-------------------------
+// Class TNaryAudioStream
+//-------------------------
+/*!
+\brief The base class for streams with a variable number of branches.
+*/
+
+class TNaryAudioStream
+{
+
+    protected:
+
+        std::vector<TAudioStreamPtr> fStreams;
+
+    public:
+
+		virtual ~TNaryAudioStream()
+        {}
+
+        long GetBranchCount()
+        {
+            return long(fStreams.size());
+        }
+        TAudioStreamPtr GetBranch(long i)
+        {
+            return fStreams[i];
+        }
+
+        // Replace a branch (control thread), streams keeping other references to their branches update them
+        virtual void SetBranch(long i, TAudioStreamPtr stream)
+        {
+            fStreams[i] = stream;
+        }
+};
+
+typedef TNaryAudioStream * TNaryAudioStreamPtr;
+
 
 //-----------------------------
 // Class TDecoratedAudioStream
@@ -26,6 +26,8 @@ research@grame.fr
 #include "TCutEndAudioStream.h"
 #include "TSeqAudioStream.h"
 #include "TMixAudioStream.h"
+#include "TMultiMixAudioStream.h"
+#include "TTimelineAudioStream.h"
 #include "TNullAudioStream.h"
 #include "TReadFileAudioStream.h"
 #include "TInputAudioStream.h"
@@ -35,15 +37,39 @@ research@grame.fr
 #ifdef SOUND_TOUCH
 #include "TSoundTouchAudioStream.h"
 #endif
+#include "TAsyncAudioStream.h"
 #include "TWriteFileAudioStream.h"
 #include "TRendererAudioStream.h"
 #include "TChannelizerAudioStream.h"
 #include "TSampleRateAudioStream.h"
-#include "TAudioGlobals.h"
+#include "TProfileAudioStream.h"
 #include "UAudioTools.h"
+#include "msAtomic.h"
 #include <assert.h>
 #include <stdio.h>
 
+volatile long TAudioStreamFactory::fRemovedNodes = 0;
+
+void TAudioStreamFactory::AddRemovedNodes(long nodes)
+{
+    msAtomicAdd(&fRemovedNodes, nodes);
+}
+
+/*--------------------------------------------------------------------------*/
+// Simplification rules
+/*--------------------------------------------------------------------------*/
+
+/*
+The factory does not build expressions literally: identity nodes are dropped, and silent or cut
+sub-expressions are folded, so that the rendered tree has as few nodes as possible.
+Only rewrites that keep the exact same output are done.
+*/
+
+static TNullAudioStreamPtr AsNull(TAudioStreamPtr sound)
+{
+    return dynamic_cast<TNullAudioStreamPtr>((TAudioStream*)sound);
+}
+
 /*--------------------------------------------------------------------------*/
 // External API
 /*--------------------------------------------------------------------------*/
@@ -57,12 +83,11 @@ TAudioStreamPtr TAudioStreamFactory::MakeReadSound(string name)
 {
     try {
         TReadFileAudioStreamPtr sound = new TReadFileAudioStream(name, 0);
-        // Force stereo mode here...
-        TAudioStreamPtr stereo_sound = MakeStereoSound(sound);
-        if (sound->SampleRate() != TAudioGlobals::fSampleRate) {
-            return new TSampleRateAudioStream(stereo_sound, double(TAudioGlobals::fSampleRate) / double(sound->SampleRate()), 2);
+        // Native channel count is kept, upmix is done in TAudioChannel::Mix
+        if (sound->SampleRate() != sound->GetContext()->fSampleRate) {
+            return new TSampleRateAudioStream(sound, double(sound->GetContext()->fSampleRate) / double(sound->SampleRate()), 2);
         } else {
-            return stereo_sound;
+            return sound;
         }
     } catch (int n) {
         printf("MakeReadSound exception %d \n", n);
@@ -74,13 +99,19 @@ TAudioStreamPtr TAudioStreamFactory::MakeRegionSound(string name, long beginFram
 {
 	if (beginFrame >= 0 && beginFrame <= endFrame) {
         try {
-            TReadFileAudioStreamPtr sound = new TReadFileAudioStream(name, beginFrame);
-            // Force stereo mode here...
-            TAudioStreamPtr stereo_sound = MakeStereoSound(sound);
- 	        if (sound->SampleRate() != TAudioGlobals::fSampleRate) {
-                return new TSampleRateAudioStream(new TCutEndAudioStream(stereo_sound, UTools::Min(endFrame - beginFrame, sound->Length())), double(TAudioGlobals::fSampleRate) / double(sound->SampleRate()), 2);
+            TReadFileAudioStreamPtr file = new TReadFileAudioStream(name, beginFrame);
+            TAudioStreamPtr sound = file;
+            // Region up to the end of file: no cut needed
+            if (endFrame - beginFrame < file->Length()) {
+                sound = new TCutEndAudioStream(file, endFrame - beginFrame);
             } else {
-                return new TCutEndAudioStream(stereo_sound, UTools::Min(endFrame - beginFrame, sound->Length()));
+                AddRemovedNodes(1);
+            }
+            // Native channel count is kept, upmix is done in TAudioChannel::Mix
+ 	        if (file->SampleRate() != file->GetContext()->fSampleRate) {
+                return new TSampleRateAudioStream(sound, double(file->GetContext()->fSampleRate) / double(file->SampleRate()), 2);
+            } else {
+                return sound;
             }
         } catch (int n) {
             printf("MakeRegionSound exception %d \n", n);
@@ -91,21 +122,79 @@ TAudioStreamPtr TAudioStreamFactory::MakeRegionSound(string name, long beginFram
     }
 }
 
+// endFrame < 0 : whole file
+TAudioStreamPtr TAudioStreamFactory::MakeLoadSound(string name, long beginFrame, long endFrame, LoadCallback callback, void* context)
+{
+    if (beginFrame >= 0 && (endFrame < 0 || beginFrame <= endFrame)) {
+        TLoadAudioStreamPtr sound = new TLoadAudioStream(name, beginFrame, endFrame);
+        TAudioStreamPtr res = sound;
+        TLoadAudioStream::Load(std::vector<TLoadAudioStream*>(1, sound), callback, context);
+        return res;
+    } else {
+        return 0;
+    }
+}
+
+// The files are opened in parallel by the command manager threads
+void TAudioStreamFactory::MakeLoadSounds(const std::vector<string>& names, std::vector<TAudioStreamPtr>& sounds, LoadCallback callback, void* context)
+{
+    std::vector<TLoadAudioStream*> streams;
+    for (unsigned int i = 0; i < names.size(); i++) {
+        TLoadAudioStreamPtr sound = new TLoadAudioStream(names[i], 0, -1);
+        sounds.push_back(sound);
+        streams.push_back(sound);
+    }
+    TLoadAudioStream::Load(streams, callback, context);
+}
+
 TAudioStreamPtr TAudioStreamFactory::MakeStereoSound(TAudioStreamPtr sound)
 {
 	return (sound && sound->Channels() == 1) ? new TChannelizerAudioStream(sound, 2) : sound;
 }
 
+/*
+Loop(s, 1) ==> s
+Loop(Null(l), n) ==> Null(l * n)
+*/
+
 TAudioStreamPtr TAudioStreamFactory::MakeLoopSound(TAudioStreamPtr sound, long n)
 {
-    return (sound) ? new TLoopAudioStream(sound, n) : 0;
+    if (!sound) {
+        return 0;
+    } else if (n == 1) {
+        AddRemovedNodes(1);
+        return sound;
+    } else if (TNullAudioStreamPtr null = AsNull(sound)) {
+        if (n > 1) {
+            AddRemovedNodes(1);
+            return new TNullAudioStream(null->Length() * n);
+        }
+    }
+    return new TLoopAudioStream(sound, n);
 }
 
+/*
+Fade(Null(l), in, out) ==> Null(l)
+*/
+
 TAudioStreamPtr TAudioStreamFactory::MakeFadeSound(TAudioStreamPtr sound, long fadeIn, long fadeOut)
 {
-    return (sound) ? new TFadeAudioStream(sound, fadeIn, fadeOut) : 0;
+    if (!sound) {
+        return 0;
+    } else if (AsNull(sound)) {
+        AddRemovedNodes(1);
+        return sound;
+    } else {
+        return new TFadeAudioStream(sound, fadeIn, fadeOut);
+    }
 }
 
+/*
+Cut(Cut(s, b1, e1), b2, e2) ==> Cut(s, b1 + b2, Min(e1, b1 + e2)) : a single cut end node
+Cut(Null(l), b, e) ==> Null(Min(l - b, e - b))
+Cut(File, b, e) ==> File starting at b if e is after the end of file
+*/
+
 TAudioStreamPtr TAudioStreamFactory::MakeCutSound(TAudioStreamPtr sound, long beginFrame, long endFrame)
 {
     if (beginFrame >= 0 && beginFrame < endFrame && sound) {
@@ -114,21 +203,174 @@ TAudioStreamPtr TAudioStreamFactory::MakeCutSound(TAudioStreamPtr sound, long be
 		} else {
 			TAudioStreamPtr begin = sound->CutBegin(beginFrame);
 			assert(begin);
-            return new TCutEndAudioStream(begin, UTools::Min(endFrame - beginFrame, begin->Length()));
+            long length = UTools::Min(endFrame - beginFrame, begin->Length());
+            if (TCutEndAudioStreamPtr cut = dynamic_cast<TCutEndAudioStreamPtr>((TAudioStream*)begin)) {
+                AddRemovedNodes(1);
+                begin = cut->GetBranch1();
+            }
+            if (AsNull(begin)) {
+                AddRemovedNodes(1);
+                return new TNullAudioStream(length);
+            } else if (dynamic_cast<TReadFileAudioStreamPtr>((TAudioStream*)begin) && length == begin->Length()) {
+                AddRemovedNodes(1);
+                return begin;
+            } else {
+                return new TCutEndAudioStream(begin, length);
+            }
         }
     } else {
         return 0;
     }
 }
 
+/*
+Seq(Null(l1), Null(l2)) ==> Null(l1 + l2)
+Seq(Null(l1), Seq(Null(l2), s)) ==> Seq(Null(l1 + l2), s)
+Seq(s, Null(0)) ==> s
+Seq(Null(0), s) ==> s
+(without cross fade)
+*/
+
 TAudioStreamPtr TAudioStreamFactory::MakeSeqSound(TAudioStreamPtr s1, TAudioStreamPtr s2, long crossFade)
 {
-    return (s1 && s2) ? new TSeqAudioStream(s1, s2, crossFade) : 0;
+    if (!s1 || !s2) {
+        return 0;
+    }
+
+    if (crossFade == 0) {
+        TNullAudioStreamPtr null1 = AsNull(s1);
+        TNullAudioStreamPtr null2 = AsNull(s2);
+        if (null1 && null2) {
+            AddRemovedNodes(2);
+            return new TNullAudioStream(null1->Length() + null2->Length());
+        } else if (null2 && null2->Length() == 0) {
+            AddRemovedNodes(2);
+            return s1;
+        } else if (null1 && null1->Length() == 0) {
+            AddRemovedNodes(2);
+            return s2;
+        } else if (null1) {
+            TSeqAudioStreamPtr seq = dynamic_cast<TSeqAudioStreamPtr>((TAudioStream*)s2);
+            if (seq && seq->GetCrossFade() == 0 && AsNull(seq->GetBranch1())) {
+                AddRemovedNodes(2);
+                return MakeSeqSound(new TNullAudioStream(null1->Length() + seq->GetBranch1()->Length()), seq->GetBranch2(), 0);
+            }
+        }
+    }
+
+    return new TSeqAudioStream(s1, s2, crossFade);
 }
 
+// Collect the leaves of nested mixes
+static void FlattenMix(TAudioStreamPtr sound, std::vector<TAudioStreamPtr>& streams)
+{
+    if (TMixAudioStreamPtr mix = dynamic_cast<TMixAudioStreamPtr>((TAudioStream*)sound)) {
+        TAudioStreamFactory::AddRemovedNodes(1);
+        FlattenMix(mix->GetBranch1(), streams);
+        FlattenMix(mix->GetBranch2(), streams);
+    } else if (TMultiMixAudioStreamPtr mix = dynamic_cast<TMultiMixAudioStreamPtr>((TAudioStream*)sound)) {
+        TAudioStreamFactory::AddRemovedNodes(1);
+        for (long i = 0; i < mix->GetBranchCount(); i++) {
+            streams.push_back(mix->GetBranch(i));
+        }
+    } else {
+        streams.push_back(sound);
+    }
+}
+
+// Silent leaves not longer than the mix are useless
+static void DropNullMix(std::vector<TAudioStreamPtr>& streams)
+{
+    long length = 0;
+    bool sound = false;
+
+    for (unsigned int i = 0; i < streams.size(); i++) {
+        if (!AsNull(streams[i])) {
+            length = UTools::Max(length, streams[i]->Length());
+            sound = true;
+        }
+    }
+
+    // Keep at least one leaf
+    if (!sound) {
+        return;
+    }
+
+    std::vector<TAudioStreamPtr> res;
+    for (unsigned int i = 0; i < streams.size(); i++) {
+        if (AsNull(streams[i]) && streams[i]->Length() <= length) {
+            TAudioStreamFactory::AddRemovedNodes(1);
+        } else {
+            res.push_back(streams[i]);
+        }
+    }
+    streams = res;
+}
+
+static TAudioStreamPtr MakeMix(const std::vector<TAudioStreamPtr>& streams)
+{
+    switch (streams.size()) {
+        case 0:
+            return 0;
+        case 1:
+            TAudioStreamFactory::AddRemovedNodes(1);
+            return streams[0];
+        case 2:
+            return new TMixAudioStream(streams[0], streams[1]);
+        default:
+            return new TMultiMixAudioStream(streams);
+    }
+}
+
+/*
+Mix (s1, Mix (s2, s3)) ==> MultiMix (s1, s2, s3)
+Mix (s, Null(l)) ==> s if l <= Length(s)
+*/
+
 TAudioStreamPtr TAudioStreamFactory::MakeMixSound(TAudioStreamPtr s1, TAudioStreamPtr s2)
 {
-    return (s1 && s2) ? new TMixAudioStream(s1, s2) : 0;
+    if (s1 && s2) {
+        std::vector<TAudioStreamPtr> streams;
+        FlattenMix(s1, streams);
+        FlattenMix(s2, streams);
+        DropNullMix(streams);
+        return MakeMix(streams);
+    } else {
+        return 0;
+    }
+}
+
+TAudioStreamPtr TAudioStreamFactory::MakeMultiMixSound(const std::vector<TAudioStreamPtr>& sounds)
+{
+    std::vector<TAudioStreamPtr> streams;
+
+    for (unsigned int i = 0; i < sounds.size(); i++) {
+        if (!sounds[i]) {
+            return 0;
+        }
+        FlattenMix(sounds[i], streams);
+    }
+
+    DropNullMix(streams);
+    return MakeMix(streams);
+}
+
+TAudioStreamPtr TAudioStreamFactory::MakeTimelineSound(const std::vector<TAudioStreamPtr>& sounds, const std::vector<long>& starts, long lookahead)
+{
+    std::vector<TTimelineClip> clips;
+
+    if (sounds.size() != starts.size()) {
+        return 0;
+    }
+
+    for (unsigned int i = 0; i < sounds.size(); i++) {
+        if (!sounds[i] || starts[i] < 0) {
+            return 0;
+        }
+        clips.push_back(TTimelineClip(starts[i], sounds[i]));
+    }
+
+    return new TTimelineAudioStream(new TTimelineIndex(clips), 0, lookahead);
 }
 
 TAudioStreamPtr TAudioStreamFactory::MakeInputSound()
@@ -153,6 +395,11 @@ TAudioStreamPtr TAudioStreamFactory::MakeSoundTouchSound(TAudioStreamPtr s1,  do
 }
 #endif
 
+TAudioStreamPtr TAudioStreamFactory::MakeAsyncSound(TAudioStreamPtr s1, long ahead)
+{
+    return (s1) ? new TAsyncAudioStream(s1, ahead) : 0;
+}
+
 TAudioStreamPtr TAudioStreamFactory::MakeWriteSound(string name, TAudioStreamPtr sound, long format)
 {
     return (sound) ? new TWriteFileAudioStream(name, sound, format) : 0;
@@ -168,3 +415,9 @@ TAudioStreamPtr TAudioStreamFactory::MakeDTRenderer(TAudioStreamPtr sound)
     return (sound) ? new TDTRendererAudioStream(sound) : 0;
 }
 
+// The tree is instrumented in place: it must not be played yet
+TAudioStreamPtr TAudioStreamFactory::MakeProfileSound(TAudioStreamPtr sound)
+{
+    return (sound) ? TProfiler::Profile(sound) : 0;
+}
+
@@ -26,6 +26,7 @@ research@grame.fr
 #include "AudioExports.h"
 #include "TAudioStream.h"
 #include "TAudioEffect.h"
+#include "TLoadAudioStream.h"
 #include <string>
 
 using namespace std;
@@ -58,6 +59,10 @@ typedef TAudioStreamPtr BinayOp(TAudioStreamPtr s1, TAudioStreamPtr s2);
 class AUDIO_EXPORTS TAudioStreamFactory
 {
 
+    private:
+
+        static volatile long fRemovedNodes;  // Nodes saved by the simplification rules, updated by several threads
+
     public:
 
         TAudioStreamFactory()
@@ -69,20 +74,32 @@ class AUDIO_EXPORTS TAudioStreamFactory
         static TAudioStreamPtr MakeNullSound(long lengthFrame);
         static TAudioStreamPtr MakeReadSound(string name);
         static TAudioStreamPtr MakeRegionSound(string name, long beginFrame, long endFrame);
+        static TAudioStreamPtr MakeLoadSound(string name, long beginFrame, long endFrame, LoadCallback callback, void* context);
+        static void MakeLoadSounds(const std::vector<string>& names, std::vector<TAudioStreamPtr>& sounds, LoadCallback callback, void* context);
 		static TAudioStreamPtr MakeStereoSound(TAudioStreamPtr sound);
         static TAudioStreamPtr MakeLoopSound(TAudioStreamPtr sound, long n);
         static TAudioStreamPtr MakeFadeSound(TAudioStreamPtr sound, long fadeIn, long fadeOut);
         static TAudioStreamPtr MakeCutSound(TAudioStreamPtr s1, long beginFrame, long endFrame);
         static TAudioStreamPtr MakeSeqSound(TAudioStreamPtr s1, TAudioStreamPtr s2, long crossFade);
         static TAudioStreamPtr MakeMixSound(TAudioStreamPtr s1, TAudioStreamPtr s2);
+        static TAudioStreamPtr MakeMultiMixSound(const std::vector<TAudioStreamPtr>& sounds);
+        static TAudioStreamPtr MakeTimelineSound(const std::vector<TAudioStreamPtr>& sounds, const std::vector<long>& starts, long lookahead);
         static TAudioStreamPtr MakeTransformSound(TAudioStreamPtr s1, TAudioEffectListPtr effect, long fadeIn, long fadeOut);
 		static TAudioStreamPtr MakeRubberBandSound(TAudioStreamPtr s1, double* pitch_shift, double* time_strech);
     #ifdef SOUND_TOUCH
 		static TAudioStreamPtr MakeSoundTouchSound(TAudioStreamPtr s1, double* pitch_shift, double* time_strech);
     #endif
+        static TAudioStreamPtr MakeAsyncSound(TAudioStreamPtr s1, long ahead);
         static TAudioStreamPtr MakeWriteSound(string name, TAudioStreamPtr s, long format);
         static TAudioStreamPtr MakeRTRenderer(TAudioStreamPtr s);
         static TAudioStreamPtr MakeDTRenderer(TAudioStreamPtr s);
+        static TAudioStreamPtr MakeProfileSound(TAudioStreamPtr s);
+
+        static void AddRemovedNodes(long nodes);
+        static long GetRemovedNodes()
+        {
+            return fRemovedNodes;
+        }
 };
 
 typedef TAudioStreamFactory * TAudioStreamFactoryPtr;
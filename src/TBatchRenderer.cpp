@@ -0,0 +1,92 @@
+/*
+
+Copyright (C) Grame 2002-2013
+
+This library is free software; you can redistribute it and modify it under
+the terms of the GNU Library General Public License as published by the
+Free Software Foundation version 2 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public License
+for more details.
+
+You should have received a copy of the GNU Library General Public License
+along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+Grame Research Laboratory, 9, rue du Garet 69001 Lyon - France
+research@grame.fr
+
+*/
+
+#include "TBatchRenderer.h"
+#include "TFileRenderer.h"
+#include "UTools.h"
+#include "msAtomic.h"
+
+#ifdef WIN32
+	#include <windows.h>
+	#define BatchSleep(val) Sleep(val)
+#else
+	#include <unistd.h>
+	#define BatchSleep(val) usleep(val*1000)
+#endif
+
+TBatchRenderer::TBatchRenderer(long format, long blockSize): fFormat(format), fBlockSize(blockSize), fNext(0), fRunning(0)
+{}
+
+void TBatchRenderer::AddJob(TAudioStreamPtr stream, string name)
+{
+    TRenderJob job;
+    job.fStream = stream;
+    job.fName = name;
+    job.fResult = -1;
+    fJobs.push_back(job);
+}
+
+// Callback called by command manager
+void TBatchRenderer::RunAux(TBatchRendererPtr obj, long u1, long u2, long u3, long u4)
+{
+    obj->Run();
+    msAtomicAdd(&obj->fRunning, -1);
+}
+
+void TBatchRenderer::Run()
+{
+    // Blocks are encoded by the rendering thread
+    TDirectCmdManager encoder;
+    long count = long(fJobs.size());
+    long job;
+
+    while ((job = msAtomicAdd(&fNext, 1) - 1) < count) {
+        TFileRenderer renderer(&encoder);
+        fJobs[job].fResult = renderer.Render(fJobs[job].fStream, fJobs[job].fName, fFormat, fBlockSize, 0);
+    }
+}
+
+long TBatchRenderer::Render(TCmdManagerPtr workers)
+{
+    long count = long(fJobs.size());
+
+    if (workers) {
+        fRunning = UTools::Min(count, workers->GetThreadCount());
+        for (long i = fRunning; i > 0; i--) {
+            workers->ExecParallelCmd((CmdPtr)RunAux, (long)this, 0, 0, 0, 0);
+        }
+        // Wait for all commands, the batch is then no more used
+        while (fRunning > 0) {
+            BatchSleep(1);
+        }
+    } else {
+        Run();
+    }
+
+    long rendered = 0;
+    for (long i = 0; i < count; i++) {
+        if (fJobs[i].fResult >= 0) {
+            rendered++;
+        }
+    }
+    return rendered;
+}
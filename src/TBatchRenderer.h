@@ -0,0 +1,91 @@
+/*
+
+Copyright (C) Grame 2002-2013
+
+This library is free software; you can redistribute it and modify it under
+the terms of the GNU Library General Public License as published by the
+Free Software Foundation version 2 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public License
+for more details.
+
+You should have received a copy of the GNU Library General Public License
+along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+Grame Research Laboratory, 9, rue du Garet 69001 Lyon - France
+research@grame.fr
+
+*/
+
+#ifndef __TBatchRenderer__
+#define __TBatchRenderer__
+
+#include "TAudioStream.h"
+#include "TCmdManager.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//----------------------
+// Class TBatchRenderer
+//----------------------
+/*!
+\brief Renders a list of independent streams in sound files, in parallel.
+*/
+
+/*
+One command per thread of the worker command manager is queued, each command renders the next
+job until the list is empty. A job is rendered by its own TFileRenderer, with its own renderer
+(scratch arena, direct command manager) and synchronous encoding: jobs only share the file handle
+pool, so that the rendering speed grows with the number of threads.
+
+Jobs must not share stream objects (use Copy to render the same sound in several jobs).
+*/
+
+class TBatchRenderer
+{
+
+    private:
+
+        struct TRenderJob
+        {
+            TAudioStreamPtr fStream;
+            string fName;
+            long fResult;
+        };
+
+        vector<TRenderJob> fJobs;
+        long fFormat;
+        long fBlockSize;
+        volatile long fNext;
+        volatile long fRunning;     // Commands not finished
+
+        static void RunAux(TBatchRenderer* obj, long u1, long u2, long u3, long u4);
+
+        void Run();
+
+    public:
+
+        TBatchRenderer(long format, long blockSize);
+        virtual ~TBatchRenderer()
+        {}
+
+        void AddJob(TAudioStreamPtr stream, string name);
+
+        // Render all jobs with the threads of the manager, returns the number of rendered files
+        long Render(TCmdManagerPtr workers);
+
+        // Number of rendered frames, or a negative value if the file cannot be written
+        long GetResult(long job)
+        {
+            return fJobs[job].fResult;
+        }
+};
+
+typedef TBatchRenderer * TBatchRendererPtr;
+
+#endif
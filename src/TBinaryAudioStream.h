@@ -35,6 +35,8 @@ research@grame.fr
 class TBinaryAudioStream : public TDecoratedAudioStream
 {
 
+    friend class TProfiler;
+
     protected:
 
         TAudioStreamPtr fStream1, fStream2;
@@ -21,7 +21,6 @@ research@grame.fr
 */
 
 #include "TBufferedAudioStream.h"
-#include "TAudioGlobals.h"
 #include "UAudioTools.h"
 #include "UTools.h"
 #include  <string.h>
@@ -68,12 +67,14 @@ long TBufferedAudioStream::HandleBuffer(FLOAT_BUFFER buffer, long framesNum, lon
     if (EndFirst(fCurFrame, framesNum, fMemoryBuffer->GetSize() / 2)) { // End of first buffer
 
         if (!fReady) {
-            TAudioGlobals::fDiskError++;
+            fContext->AddDiskError();
         }
 	
         assert((fCurFrame + framesNum) <= fMemoryBuffer->GetSize());
 
-        if (read) {
+        if (!buffer) {
+            // Skipped frames
+        } else if (read) {
             // Read the frames from the disk buffer to the argument buffer
             UAudioTools::Short2FloatMix(fMemoryBuffer->GetFrame(fCurFrame), buffer->GetFrame(framePos), framesNum, fChannels, channels);
         } else {
@@ -92,7 +93,7 @@ long TBufferedAudioStream::HandleBuffer(FLOAT_BUFFER buffer, long framesNum, lon
     } else if (EndSecond(fCurFrame, framesNum, fMemoryBuffer->GetSize() / 2)) { // End of second buffer
 
 		if (!fReady) {
-            TAudioGlobals::fDiskError++;
+            fContext->AddDiskError();
         }
 
         long frames1 = fMemoryBuffer->GetSize() - fCurFrame;    // Number of frames to be read or written at the end of the buffer
@@ -100,7 +101,9 @@ long TBufferedAudioStream::HandleBuffer(FLOAT_BUFFER buffer, long framesNum, lon
 
         assert((fCurFrame + frames1) <= fMemoryBuffer->GetSize());
 
-        if (read) {
+        if (!buffer) {
+            // Skipped frames
+        } else if (read) {
             UAudioTools::Short2FloatMix(fMemoryBuffer->GetFrame(fCurFrame), buffer->GetFrame(framePos), frames1, fChannels, channels);
             UAudioTools::Short2FloatMix(fMemoryBuffer->GetFrame(0), buffer->GetFrame(frames1 + framePos), frames2, fChannels, channels);
         } else {
@@ -121,7 +124,9 @@ long TBufferedAudioStream::HandleBuffer(FLOAT_BUFFER buffer, long framesNum, lon
 
         assert((fCurFrame + framesNum) <= fMemoryBuffer->GetSize());
 
-        if (read) {
+        if (!buffer) {
+            // Skipped frames
+        } else if (read) {
             UAudioTools::Short2FloatMix(fMemoryBuffer->GetFrame(fCurFrame), buffer->GetFrame(framePos), framesNum, fChannels, channels);
         } else {
             UAudioTools::Float2Short(buffer->GetFrame(framePos), fMemoryBuffer->GetFrame(fCurFrame), framesNum, channels, fChannels);
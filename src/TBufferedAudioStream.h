@@ -102,6 +102,12 @@ class TBufferedAudioStream : public TAudioStream
         virtual void WriteBuffer(SHORT_BUFFER buffer, long framesNum, long framePos);
 
         long HandleBuffer(FLOAT_BUFFER buffer, long framesNum, long framePos, long channels, bool read_or_write);
+
+        // Move forward in the read buffers without copying the frames
+        long Skip(long framesNum)
+        {
+            return HandleBuffer(0, framesNum, 0, 0, true);
+        }
   
     public:
 
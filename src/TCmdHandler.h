@@ -54,6 +54,25 @@ class TCmdHandler
         {
             fManager = manager;
         }
+
+        // Set the command manager of a stream tree, without allocating (can be called in the audio thread)
+        static void SetTreeManager(TAudioStream* stream, TCmdManagerPtr manager)
+        {
+            if (TBinaryAudioStreamPtr binary = dynamic_cast<TBinaryAudioStreamPtr>(stream)) {
+                SetTreeManager(binary->GetBranch1(), manager);
+                SetTreeManager(binary->GetBranch2(), manager);
+            } else if (TUnaryAudioStreamPtr unary = dynamic_cast<TUnaryAudioStreamPtr>(stream)) {
+                SetTreeManager(unary->GetBranch1(), manager);
+            } else if (TNaryAudioStreamPtr nary = dynamic_cast<TNaryAudioStreamPtr>(stream)) {
+                for (long i = 0; i < nary->GetBranchCount(); i++) {
+                    SetTreeManager(nary->GetBranch(i), manager);
+                }
+            }
+
+            if (TCmdHandler* handler = dynamic_cast<TCmdHandler*>(stream)) {
+                handler->SetManager(manager);
+            }
+        }
 };
 
 typedef TCmdHandler * TCmdHandlerPtr;
@@ -100,6 +119,11 @@ class TCmdHandlerList : public list<TCmdHandlerPtr>
                 // Goes inside the unary stream
             } else if (TUnaryAudioStreamPtr unary = dynamic_cast<TUnaryAudioStreamPtr>((TAudioStream*)stream)) {
                 MakeList(unary->GetBranch1());
+                // Goes inside all branches
+            } else if (TNaryAudioStreamPtr nary = dynamic_cast<TNaryAudioStreamPtr>((TAudioStream*)stream)) {
+                for (long i = 0; i < nary->GetBranchCount(); i++) {
+                    MakeList(nary->GetBranch(i));
+                }
             }
 	
             if (TCmdHandlerPtr handler = dynamic_cast<TCmdHandlerPtr>((TAudioStream*)stream))
@@ -61,10 +61,16 @@ class TCmdManager
             //delete fInstance;
         }
     
+        // Commands with the same a1 (the object they work on) are run in order, one at a time
         void ExecCmd(CmdPtr fun, long a1, long a2, long a3, long a4, long a5)
         {
             ExecCmdAux(fun, a1, a2, a3, a4, a5);
         }
+        // Commands run in parallel whatever their arguments (workers sharing the same object)
+        void ExecParallelCmd(CmdPtr fun, long a1, long a2, long a3, long a4, long a5)
+        {
+            ExecParallelCmdAux(fun, a1, a2, a3, a4, a5);
+        }
         static void Run()
         {
             if (fInstance)
@@ -73,10 +79,19 @@ class TCmdManager
 
         virtual void ExecCmdAux (CmdPtr fun, long a1, long a2, long a3, long a4, long a5)
 		{}
+        virtual void ExecParallelCmdAux(CmdPtr fun, long a1, long a2, long a3, long a4, long a5)
+        {
+            ExecCmdAux(fun, a1, a2, a3, a4, a5);
+        }
         virtual void RunAux()
         {}
         virtual void FlushCmds()
         {}
+        // Number of threads running the commands
+        virtual long GetThreadCount()
+        {
+            return 1;
+        }
 };
 
 typedef TCmdManager * TCmdManagerPtr;
@@ -22,7 +22,6 @@ research@grame.fr
 
 #include "TFadeAudioStream.h"
 #include "TRendererAudioStream.h"
-#include "TAudioGlobals.h"
 #include "UTools.h"
 
 TFadeAudioStream::TFadeAudioStream(): TDecoratedAudioStream(0)
@@ -32,7 +31,8 @@ TFadeAudioStream::TFadeAudioStream(): TDecoratedAudioStream(0)
     fFadeOutFrames = 0;
     fCurFrame = 0;
     fFramesNum = 0;
-    fMixBuffer = new TLocalAudioBuffer<float>(TAudioGlobals::fBufferSize, TAudioGlobals::fOutput);
+    // Used by TAudioChannel outside of any planned tree
+    ReserveScratch();
 }
 
 TFadeAudioStream::TFadeAudioStream(TAudioStreamPtr stream, long fadeIn, long fadeOut): TDecoratedAudioStream(stream)
@@ -42,8 +42,8 @@ TFadeAudioStream::TFadeAudioStream(TAudioStreamPtr stream, long fadeIn, long fad
     fFadeOutFrames = fadeOut;
     fCurFrame = 0;
 	fFramesNum = UTools::Max(0, fStream->Length() - fFadeOutFrames); // Number of frames - FadeOut 
-    fMixBuffer = new TLocalAudioBuffer<float>(TAudioGlobals::fBufferSize, TAudioGlobals::fOutput);
     Init(0.0f, float(fadeIn), 1.0f, float(fadeOut));
+    ReserveScratch();
 }
 
 long TFadeAudioStream::Read(FLOAT_BUFFER buffer, long framesNum, long framePos, long channels)
@@ -83,16 +83,19 @@ long TFadeAudioStream::ReadAux(FLOAT_BUFFER buffer, long framesNum, long framePo
 
 long TFadeAudioStream::FadeIn(FLOAT_BUFFER buffer, long framesNum, long framePos, long channels)
 {
-    UAudioTools::ZeroFloatBlk(fMixBuffer->GetFrame(0), framesNum, channels);
-    long res = fStream->Read(fMixBuffer, framesNum, framePos, channels);
+    // View on the scratch buffer with the requested channel count
+    TSharedAudioBuffer<float> mix(GetScratch(), fContext->fBufferSize, channels);
+    
+    UAudioTools::ZeroFloatBlk(mix.GetFrame(0), framesNum, channels);
+    long res = fStream->Read(&mix, framesNum, 0, channels);
     fCurFrame += res;
 
-    for (int i = framePos; i < framePos + framesNum; i++) {
-        UAudioTools::MultFrame(fMixBuffer->GetFrame(i), fFadeIn.tick(), channels);
+    for (int i = 0; i < framesNum; i++) {
+        UAudioTools::MultFrame(mix.GetFrame(i), fFadeIn.tick(), channels);
     }
 
     UAudioTools::MixFrameToFrameBlk(buffer->GetFrame(framePos),
-                                    fMixBuffer->GetFrame(framePos),
+                                    mix.GetFrame(0),
                                     framesNum, channels);
 
     if (res < framesNum) {
@@ -106,16 +109,19 @@ long TFadeAudioStream::FadeIn(FLOAT_BUFFER buffer, long framesNum, long framePos
 
 long TFadeAudioStream::FadeOut(FLOAT_BUFFER buffer, long framesNum, long framePos, long channels)
 {
-    UAudioTools::ZeroFloatBlk(fMixBuffer->GetFrame(0), framesNum, channels);
-    long res = fStream->Read(fMixBuffer, framesNum, framePos, channels);
+    // View on the scratch buffer with the requested channel count
+    TSharedAudioBuffer<float> mix(GetScratch(), fContext->fBufferSize, channels);
+    
+    UAudioTools::ZeroFloatBlk(mix.GetFrame(0), framesNum, channels);
+    long res = fStream->Read(&mix, framesNum, 0, channels);
     fCurFrame += res;
 
-    for (int i = framePos; i < framePos + framesNum; i++) {
-        UAudioTools::MultFrame(fMixBuffer->GetFrame(i), fFadeOut.tick(), channels);
+    for (int i = 0; i < framesNum; i++) {
+        UAudioTools::MultFrame(mix.GetFrame(i), fFadeOut.tick(), channels);
     }
 
     UAudioTools::MixFrameToFrameBlk(buffer->GetFrame(framePos),
-                                    fMixBuffer->GetFrame(framePos),
+                                    mix.GetFrame(0),
                                     framesNum, channels);
 
     if ((res < framesNum) || (fFadeOut.lastOut() <= 0.0f)) {
@@ -125,6 +131,12 @@ long TFadeAudioStream::FadeOut(FLOAT_BUFFER buffer, long framesNum, long framePo
     return res;
 }
 
+// Mixing buffer
+long TFadeAudioStream::ScratchSize()
+{
+    return fContext->fBufferSize * ((fStream) ? UTools::Max(fContext->fOutput, fStream->Channels()) : fContext->fOutput);
+}
+
 void TFadeAudioStream::Init(float fade_in_val, float fade_in_time, float fade_out_val, float fade_out_time)
 {
     fFadeIn.setValue(fade_in_val);
@@ -164,6 +176,8 @@ void TChannelFadeAudioStream::SetStream(TAudioStreamPtr stream, long fadeIn, lon
     fCurFrame = 0;
 	fFramesNum = fStream->Length() - fFadeOutFrames; // Number of frames - FadeOut
     Init(0.0f, float(fFadeInFrames), 1.0f, float(fFadeOutFrames));
+    // The new stream may have more channels
+    ReserveScratch();
 }
 
 void TChannelFadeAudioStream::FadeIn()
@@ -24,6 +24,7 @@ research@grame.fr
 #define __TFadeAudioStream__
 
 #include "TAudioStream.h"
+#include "TScratchArena.h"
 #include "Envelope.h"
 
 //------------------------
@@ -33,7 +34,7 @@ research@grame.fr
 \brief  A TFadeAudioStream applies FadeIn and FadeOut on a decorated stream.
 */
 
-class TFadeAudioStream : public TDecoratedAudioStream
+class TFadeAudioStream : public TDecoratedAudioStream, public TScratchHandler
 {
 
     protected:
@@ -45,7 +46,6 @@ class TFadeAudioStream : public TDecoratedAudioStream
         long fStatus;			// Channel state
         long fCurFrame;			// Current frame
         long fFramesNum;		// Frames number
-        FLOAT_BUFFER fMixBuffer;     // Used for mixing
 
         long ReadAux(FLOAT_BUFFER buffer, long framesNum, long framePos, long channels);
         long FadeIn(FLOAT_BUFFER buffer, long framesNum, long framePos, long channels);
@@ -60,9 +60,7 @@ class TFadeAudioStream : public TDecoratedAudioStream
         TFadeAudioStream();
         TFadeAudioStream(TAudioStreamPtr stream, long fadeIn, long fadeOut);
         virtual ~TFadeAudioStream()
-        {
-            delete fMixBuffer;
-        }
+        {}
 
         long Write(FLOAT_BUFFER buffer, long framesNum, long framePos, long channels)
         {
@@ -76,6 +74,8 @@ class TFadeAudioStream : public TDecoratedAudioStream
         {
             return new TFadeAudioStream(fStream->Copy(), fFadeInFrames, fFadeOutFrames);
         }
+
+        long ScratchSize();
 };
 
 typedef TFadeAudioStream * TFadeAudioStreamPtr;
@@ -27,27 +27,42 @@ research@grame.fr
 #include "faust/llvm-dsp.h"
 
 #include "TAudioEffectInterface.h"
-#include "TAudioGlobals.h"
+#include "TAudioContext.h"
+#include "TMutex.h"
 
 #ifdef WIN32
 
 #include <windows.h>
+#include <sys/stat.h>
 #define HANDLE HINSTANCE 
 #define LoadFaustModule(name) LoadLibrary((name));
 #define UnloadFaustModule(handle) FreeLibrary((handle));  
 #define GetFaustProc(handle, name) GetProcAddress((handle), (name));
+#define FactorySleep(ms) Sleep(ms)
+#define FactoryProcessId() long(GetCurrentProcessId())
 
 #else
 
 #include <dlfcn.h>
+#include <sys/stat.h>
 #define HANDLE void* 
 #define LoadFaustModule(name) dlopen((name), RTLD_NOW | RTLD_LOCAL);
 #define UnloadFaustModule(handle) dlclose((handle));
 #define GetFaustProc(handle, name) dlsym((handle), (name));
+#include <unistd.h>
+#define FactorySleep(ms) usleep((ms) * 1000)
+#define FactoryProcessId() long(getpid())
 
 #endif
 
 #include <vector>
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
 
 #ifndef FAUSTFLOAT
 #define FAUSTFLOAT float
@@ -269,12 +284,14 @@ class TModuleFaustAudioEffect : public TFaustAudioEffectBase
 		init fInit;
 		compute fCompute;
 		conclude fConclude;
+		long fSampleRate;   // Sample rate of the context the effect is built in, Reset is called in the audio thread
 		
     public:
 
         TModuleFaustAudioEffect(const char* name): TFaustAudioEffectBase()
         {
 			strcpy(fName, name);
+			fSampleRate = TAudioContext::GetCurrent()->fSampleRate;
 			fHandle = LoadFaustModule(name);
 			if (!fHandle) {
 				 throw -1;
@@ -288,7 +305,7 @@ class TModuleFaustAudioEffect : public TFaustAudioEffectBase
 			fCompute = (compute)GetFaustProc(fHandle, "compute");
 			fConclude = (conclude)GetFaustProc(fHandle, "conclude");
 			fDsp = fNew();
-			fInit(fDsp, TAudioGlobals::fSampleRate);
+			fInit(fDsp, fSampleRate);
 			if (fGetNumInputs(fDsp) != 2 || fGetNumOutputs(fDsp) != 2) { // Temporary
 				fDelete(fDsp);
 				UnloadFaustModule(fHandle);
@@ -315,7 +332,7 @@ class TModuleFaustAudioEffect : public TFaustAudioEffectBase
         }
         void Reset()
         {
-			fInit(fDsp, TAudioGlobals::fSampleRate);
+			fInit(fDsp, fSampleRate);
 		}
         long Channels()
         {
@@ -326,87 +343,444 @@ class TModuleFaustAudioEffect : public TFaustAudioEffectBase
 
 typedef TModuleFaustAudioEffect * TModuleFaustAudioEffectPtr;
 
-class TCodeFaustAudioEffect : public TFaustAudioEffectBase
+//---------------------------
+// Class TFaustFactoryTable
+//---------------------------
+/*!
+\brief Compiled Faust factories, shared by all TCodeFaustAudioEffect instances of the same DSP.
+Factories are identified by a hash of the DSP content (file content for a DSP file), of the compile parameters,
+of the Faust library version, of the import directories and of the path, size and modification time of the 
+imported files, so that a changed library is compiled again.
+Factories compiled from DSP source are also saved as bitcode in a cache directory, so that the next process 
+start reads them back instead of compiling again. The directory is given by the LIBAUDIOSTREAM_FAUST_CACHE 
+environment variable (default is a per-user "LibAudioStreamFaustCache" directory in the temporary directory), 
+an empty value disables it. The directory is created private to the user, and is not used when it is owned 
+by another user or writable by others.
+
+The table lock is not held while a factory is read or compiled: a pending entry is inserted for the key, so that 
+different DSP are compiled in parallel and threads asking for the same DSP wait for the first compilation.
+Cache files are written under a temporary name and renamed, so that readers never see a partial file.
+*/
+
+#define FAUST_TARGET "i386-apple-darwin10.6.0"
+#define FAUST_OPT_LEVEL 3
+
+class TFaustFactoryTable
 {
 
     private:
-	
-		llvm_dsp* fDsp;
-        llvm_dsp_factory* fFactory;
-        string fCode;
-		
-    public:
-
-        TCodeFaustAudioEffect(const string& code):TFaustAudioEffectBase()
+    
+        struct TFactoryEntry 
+        {
+            llvm_dsp_factory* fFactory;     // NULL while pending
+            long fRefCount;
+        };
+        
+        typedef map<string, TFactoryEntry> TFactoryMap;
+        
+        static TFactoryMap& GetMap()
+        {
+            static TFactoryMap map;
+            return map;
+        }
+        
+        static TMutex& GetMutex()
+        {
+            static TMutex mutex;
+            return mutex;
+        }
+        
+        static bool ReadFile(const string& name, string& content)
+        {
+            FILE* file = fopen(name.c_str(), "rb");
+            if (!file) {
+                return false;
+            }
+            char buffer[4096];
+            size_t res;
+            while ((res = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+                content.append(buffer, res);
+            }
+            fclose(file);
+            return true;
+        }
+        
+        // 64 bits FNV-1a
+        static void Hash(const string& data, uint64_t& hash)
+        {
+            for (size_t i = 0; i < data.size(); i++) {
+                hash ^= (unsigned char)data[i];
+                hash *= 1099511628211ULL;
+            }
+        }
+        
+        // Directories searched for the imported files, in the compiler order
+        static vector<string> GetImportDirectories(const string& code, bool is_file, int argc, const char* argv[])
+        {
+            vector<string> dirs;
+            if (is_file) {
+                size_t pos = code.find_last_of("/\\");
+                dirs.push_back((pos != string::npos) ? code.substr(0, pos) : ".");
+            }
+            for (int i = 0; i < argc - 1; i++) {
+                if (strcmp(argv[i], "-I") == 0) {
+                    dirs.push_back(argv[i + 1]);
+                }
+            }
+            const char* lib = getenv("FAUST_LIB_PATH");
+            if (lib) {
+                dirs.push_back(lib);
+            }
+        #ifndef WIN32
+            dirs.push_back("/usr/local/share/faust");
+            dirs.push_back("/usr/share/faust");
+        #endif
+            return dirs;
+        }
+        
+        // Hash the path, size and modification time of the files imported by the DSP, recursively
+        static void HashImports(const string& dsp, const vector<string>& dirs, set<string>& visited, uint64_t& hash)
+        {
+            static const char* keywords[] = {"import", "library", "component"};
+            for (int k = 0; k < 3; k++) {
+                size_t pos = 0;
+                while ((pos = dsp.find(keywords[k], pos)) != string::npos) {
+                    pos += strlen(keywords[k]);
+                    size_t begin = dsp.find_first_not_of(" \t\r\n", pos);
+                    if (begin == string::npos || dsp[begin] != '(') {
+                        continue;
+                    }
+                    begin = dsp.find_first_not_of(" \t\r\n", begin + 1);
+                    if (begin == string::npos || dsp[begin] != '"') {
+                        continue;
+                    }
+                    size_t end = dsp.find('"', begin + 1);
+                    if (end == string::npos) {
+                        break;
+                    }
+                    string name = dsp.substr(begin + 1, end - begin - 1);
+                    pos = end;
+                    // A missing file is part of the key, so that it is taken into account once created
+                    Hash(name, hash);
+                    for (unsigned int i = 0; i < dirs.size(); i++) {
+                        string path = (name.size() > 0 && name[0] == '/') ? name : dirs[i] + "/" + name;
+                        struct stat info;
+                        if (stat(path.c_str(), &info) == 0) {
+                            if (visited.insert(path).second) {
+                                char stamp[64];
+                                snprintf(stamp, sizeof(stamp), "%lld_%lld", (long long)info.st_size, (long long)info.st_mtime);
+                                Hash(path, hash);
+                                Hash(stamp, hash);
+                                string imported;
+                                if (ReadFile(path, imported)) {
+                                    HashImports(imported, dirs, visited, hash);
+                                }
+                            }
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+        
+        static string MakeKey(const string& code, int argc, const char* argv[])
+        {
+            string content;
+            bool is_file = ReadFile(code, content);
+            const string& dsp = (is_file) ? content : code;
+            uint64_t hash = 14695981039346656037ULL;
+            Hash(dsp, hash);
+            for (int i = 0; i < argc; i++) {
+                Hash(string(argv[i]) + " ", hash);
+            }
+            Hash(FAUST_TARGET, hash);
+            Hash(getCLibFaustVersion(), hash);
+            vector<string> dirs = GetImportDirectories(code, is_file, argc, argv);
+            for (unsigned int i = 0; i < dirs.size(); i++) {
+                Hash(dirs[i] + "\n", hash);
+            }
+            set<string> visited;
+            HashImports(dsp, dirs, visited, hash);
+            char key[32];
+            snprintf(key, sizeof(key), "%016llx_%d", (unsigned long long)hash, FAUST_OPT_LEVEL);
+            return key;
+        }
+        
+        // Returns the cache directory, created if needed, or an empty string when the cache is not usable
+        static string GetCacheDirectory()
+        {
+            const char* env = getenv("LIBAUDIOSTREAM_FAUST_CACHE");
+            string dir;
+        #ifdef WIN32
+            if (env) {
+                dir = env;
+            } else {
+                // Per-user application data directory
+                const char* local = getenv("LOCALAPPDATA");
+                if (!local) {
+                    return "";
+                }
+                dir = string(local) + "/LibAudioStreamFaustCache";
+            }
+            if (dir.size() > 0 && !CreateDirectory(dir.c_str(), NULL) && GetLastError() != ERROR_ALREADY_EXISTS) {
+                printf("Faust cache directory %s cannot be created, cache disabled\n", dir.c_str());
+                return "";
+            }
+        #else
+            if (env) {
+                dir = env;
+            } else {
+                // Per-user directory in the temporary directory
+                const char* tmp = getenv("TMPDIR");
+                char suffix[32];
+                snprintf(suffix, sizeof(suffix), "-%ld", long(getuid()));
+                dir = string((tmp) ? tmp : "/tmp") + "/LibAudioStreamFaustCache" + suffix;
+            }
+            if (dir.size() > 0) {
+                if (mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) {
+                    printf("Faust cache directory %s cannot be created, cache disabled\n", dir.c_str());
+                    return "";
+                }
+                // Another user could have created it first, or could replace the cache files
+                struct stat info;
+                if (lstat(dir.c_str(), &info) != 0 
+                    || !S_ISDIR(info.st_mode) 
+                    || info.st_uid != getuid() 
+                    || (info.st_mode & (S_IWGRP | S_IWOTH)) != 0) {
+                    printf("Faust cache directory %s is not private to the user, cache disabled\n", dir.c_str());
+                    return "";
+                }
+            }
+        #endif
+            return dir;
+        }
+        
+        static void WriteCacheFile(llvm_dsp_factory* factory, const string& path)
+        {
+            char suffix[32];
+            snprintf(suffix, sizeof(suffix), ".%ld.tmp", FactoryProcessId());
+            string temp = path + suffix;
+            writeDSPFactoryToBitcodeFile(factory, temp);
+        #ifdef WIN32
+            bool moved = MoveFileEx(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+        #else
+            bool moved = rename(temp.c_str(), path.c_str()) == 0;
+        #endif
+            if (!moved) {
+                remove(temp.c_str());
+            }
+        }
+        
+        static llvm_dsp_factory* Compile(const string& code, int argc, const char* argv[], bool& from_source)
         {
             char error_msg[256];
-            fCode = code;
+            llvm_dsp_factory* factory;
             
             // Try filename...
-            int argc = 1;
-            const char* argv[argc];
-            argv[0] = code.c_str();
-         
-            fFactory = createDSPFactory(argc, argv, "", "", "", "", "i386-apple-darwin10.6.0", error_msg, 3);
-            if (fFactory) {
-                goto make_instance;
+            int file_argc = argc + 1;
+            const char* file_argv[file_argc];
+            file_argv[0] = code.c_str();
+            for (int i = 0; i < argc; i++) {
+                file_argv[i + 1] = argv[i];
+            }
+            
+            from_source = true;
+            factory = createDSPFactory(file_argc, file_argv, "", "", "", "", FAUST_TARGET, error_msg, FAUST_OPT_LEVEL);
+            if (factory) {
+                return factory;
             }  else {
                 printf("createDSPFactory error from DSP file %s", error_msg);
             }
    
             // Try DSP code...
-            fFactory = createDSPFactory(0, NULL, "", "", "in", code, "i386-apple-darwin10.6.0", error_msg, 3);
-            if (fFactory) {
-                goto make_instance;
+            factory = createDSPFactory(argc, argv, "", "", "in", code, FAUST_TARGET, error_msg, FAUST_OPT_LEVEL);
+            if (factory) {
+                return factory;
             }  else {
                 printf("createDSPFactory error from DSP code %s", error_msg);
             }
             
+            from_source = false;
+            
             // Try bitcode code string...
-            fFactory = readDSPFactoryFromBitcode(code, "", 3);
-            if (fFactory) {
-                goto make_instance;
+            factory = readDSPFactoryFromBitcode(code, "", FAUST_OPT_LEVEL);
+            if (factory) {
+                return factory;
             }  else {
                 printf("readDSPFactoryFromBitcode error \n");
             }
      
             // Try bitcode code file...
-            fFactory = readDSPFactoryFromBitcodeFile(code, "", 3);
-            if (fFactory) {
-                goto make_instance;
+            factory = readDSPFactoryFromBitcodeFile(code, "", FAUST_OPT_LEVEL);
+            if (factory) {
+                return factory;
             }  else {
                 printf("readDSPFactoryFromBitcodeFile error \n");
             }
        
             // Try IR code string...
-            fFactory = readDSPFactoryFromIR(code, "", 3);
-            if (fFactory) {
-                goto make_instance;
+            factory = readDSPFactoryFromIR(code, "", FAUST_OPT_LEVEL);
+            if (factory) {
+                return factory;
             }  else {
                 printf("readDSPFactoryFromIR error \n");
             }
       
             // Try IR code file...
-            fFactory = readDSPFactoryFromIRFile(code, "", 3);
-            if (!fFactory) {
+            factory = readDSPFactoryFromIRFile(code, "", FAUST_OPT_LEVEL);
+            if (!factory) {
                 printf("readDSPFactoryFromIRFile error \n");
-                throw -1;
             } 
-                        
-        make_instance:
+            return factory;
+        }
+        
+    public:
+    
+        // True if the DSP (file name or code) is Faust source, false for bitcode or IR
+        static bool IsSource(const string& code, bool& is_file)
+        {
+            string content;
+            is_file = ReadFile(code, content);
+            const string& dsp = (is_file) ? content : code;
+            return (dsp.compare(0, 4, "BC\xC0\xDE") != 0) 
+                && (dsp.compare(0, 10, "; ModuleID") != 0)
+                && (dsp.find("process") != string::npos);
+        }
+    
+        // Returns a shared factory for the DSP (file name, DSP code, bitcode or IR), or NULL
+        static llvm_dsp_factory* Acquire(const string& code, int argc = 0, const char* argv[] = NULL)
+        {
+            string key = MakeKey(code, argc, argv);
+            
+            TMutex& mutex = GetMutex();
+            TFactoryMap& map = GetMap();
+            mutex.Lock();
+            
+            // Wait for the same DSP being compiled by another thread
+            TFactoryMap::iterator it;
+            while ((it = map.find(key)) != map.end() && !it->second.fFactory) {
+                mutex.Unlock();
+                FactorySleep(1);
+                mutex.Lock();
+            }
+            
+            if (it != map.end()) {
+                it->second.fRefCount++;
+                llvm_dsp_factory* factory = it->second.fFactory;
+                mutex.Unlock();
+                return factory;
+            }
+            
+            // Pending entry, compiled outside of the lock
+            TFactoryEntry pending = {NULL, 0};
+            map[key] = pending;
+            mutex.Unlock();
+            
+            // Try the cache directory...
+            string dir = GetCacheDirectory();
+            string path = dir + "/" + key + ".bc";
+            llvm_dsp_factory* factory = NULL;
+            string content;
+            
+            if (dir.size() > 0 && ReadFile(path, content)) {
+                factory = readDSPFactoryFromBitcode(content, "", FAUST_OPT_LEVEL);
+            }
+            
+            // Otherwise compile...
+            if (!factory) {
+                bool from_source;
+                factory = Compile(code, argc, argv, from_source);
+                if (factory && from_source && dir.size() > 0) {
+                    WriteCacheFile(factory, path);
+                }
+            }
+            
+            mutex.Lock();
+            if (factory) {
+                TFactoryEntry entry = {factory, 1};
+                map[key] = entry;
+            } else {
+                map.erase(key);
+            }
+            mutex.Unlock();
+            return factory;
+        }
         
-            assert(fFactory);
+        static void Release(llvm_dsp_factory* factory)
+        {
+            TMutex& mutex = GetMutex();
+            mutex.Lock();
+            
+            TFactoryMap& map = GetMap();
+            for (TFactoryMap::iterator it = map.begin(); it != map.end(); it++) {
+                if (it->second.fFactory == factory) {
+                    if (--it->second.fRefCount == 0) {
+                        deleteDSPFactory(factory);
+                        map.erase(it);
+                    }
+                    break;
+                }
+            }
+            
+            mutex.Unlock();
+        }
+};
+
+class TCodeFaustAudioEffect : public TFaustAudioEffectBase
+{
+
+    private:
+	
+		llvm_dsp* fDsp;
+        llvm_dsp_factory* fFactory;
+        string fCode;
+        string fOptions;
+        long fSampleRate;   // Sample rate of the context the effect is built in, Reset is called in the audio thread
+		
+    public:
+    
+        // Vector mode with the vector size set to the audio buffer size
+        static string DefaultOptions()
+        {
+            char options[64];
+            snprintf(options, sizeof(options), "-vec -vs %ld -dfs", TAudioContext::GetCurrent()->fBufferSize);
+            return options;
+        }
+
+        TCodeFaustAudioEffect(const string& code, const string& options = DefaultOptions()):TFaustAudioEffectBase()
+        {
+            fCode = code;
+            fOptions = options;
+            fSampleRate = TAudioContext::GetCurrent()->fSampleRate;
+            
+            // Split compilation options
+            vector<string> args;
+            string::size_type pos = 0;
+            while ((pos = options.find_first_not_of(" \t", pos)) != string::npos) {
+                string::size_type end = options.find_first_of(" \t", pos);
+                args.push_back(options.substr(pos, end - pos));
+                pos = end;
+            }
+            vector<const char*> argv;
+            for (unsigned int i = 0; i < args.size(); i++) {
+                argv.push_back(args[i].c_str());
+            }
+            
+            fFactory = TFaustFactoryTable::Acquire(code, argv.size(), (argv.size() > 0) ? &argv[0] : NULL);
+            if (!fFactory) {
+                throw -1;
+            }
         
 			fDsp = createDSPInstance(fFactory);
             if (!fDsp) {
-                deleteDSPFactory(fFactory);
+                TFaustFactoryTable::Release(fFactory);
                 throw -2;
             }
             
-            fDsp->init(TAudioGlobals::fSampleRate);
+            fDsp->init(fSampleRate);
 			if (fDsp->getNumInputs() != 2 || fDsp->getNumOutputs() != 2) { // Temporary
                 deleteDSPInstance(fDsp);
-                deleteDSPFactory(fFactory);
+                TFaustFactoryTable::Release(fFactory);
 				throw -3;
 			}
             
@@ -415,7 +789,7 @@ class TCodeFaustAudioEffect : public TFaustAudioEffectBase
         virtual ~TCodeFaustAudioEffect()
         {
             deleteDSPInstance(fDsp);
-            deleteDSPFactory(fFactory);
+            TFaustFactoryTable::Release(fFactory);
         }
         void Process(FAUSTFLOAT** input, FAUSTFLOAT** output, long framesNum, long channels)
         {
@@ -424,19 +798,119 @@ class TCodeFaustAudioEffect : public TFaustAudioEffectBase
 
         TAudioEffectInterface* Copy()
         {
-            return new TCodeFaustAudioEffect(fCode);
+            return new TCodeFaustAudioEffect(fCode, fOptions);
         }
         void Reset()
         {
-			fDsp->init(TAudioGlobals::fSampleRate);
+			fDsp->init(fSampleRate);
 		}
         long Channels()
         {
             return fDsp->getNumInputs();
         }
+        
+        const string& GetCode()
+        {
+            return fCode;
+        }
+        const string& GetOptions()
+        {
+            return fOptions;
+        }
 		
 };
 
 typedef TCodeFaustAudioEffect * TCodeFaustAudioEffectPtr;
 
+//------------------------------
+// Class TFusedFaustAudioEffect
+//------------------------------
+/*!
+\brief A chain of Faust effects compiled as a single DSP with the sequential composition operator.
+Each effect is put in its own group so that controls are not merged, and the controls of the original effects 
+are copied to the fused DSP before each block.
+*/
+
+class TFusedFaustAudioEffect : public TCodeFaustAudioEffect
+{
+
+    private:
+    
+        vector<TAudioEffectInterfacePtr> fEffects;
+        
+        TFusedFaustAudioEffect(const string& code, const string& options, const vector<TAudioEffectInterfacePtr>& effects)
+            :TCodeFaustAudioEffect(code, options), fEffects(effects)
+        {
+            long controls = 0;
+            for (unsigned int i = 0; i < fEffects.size(); i++) {
+                controls += fEffects[i]->GetControlCount();
+            }
+            if (controls != GetControlCount()) {
+                throw -4;
+            }
+        }
+        
+    public:
+    
+        // Returns the fused effect, or NULL if the chain cannot be fused
+        static TFusedFaustAudioEffect* Make(const list<TAudioEffectInterfacePtr>& effects)
+        {
+            vector<TAudioEffectInterfacePtr> chain;
+            string code = "process = ";
+            string options;
+            int index = 0;
+            
+            for (list<TAudioEffectInterfacePtr>::const_iterator iter = effects.begin(); iter != effects.end(); iter++, index++) {
+                TCodeFaustAudioEffectPtr effect = dynamic_cast<TCodeFaustAudioEffectPtr>((TAudioEffectInterface*)*iter);
+                bool is_file;
+                if (!effect || !TFaustFactoryTable::IsSource(effect->GetCode(), is_file)) {
+                    return NULL;
+                }
+                char group[32];
+                snprintf(group, sizeof(group), "%s hgroup(\"%d\", ", (index > 0) ? " :" : "", index);
+                code += group;
+                code += (is_file) ? "component(\"" + effect->GetCode() + "\")" : "environment {" + effect->GetCode() + "}.process";
+                code += ")";
+                chain.push_back(*iter);
+                if (index == 0) {
+                    options = effect->GetOptions();
+                }
+            }
+            code += ";";
+            
+            if (chain.size() < 2) {
+                return NULL;
+            }
+        
+            try {
+                return new TFusedFaustAudioEffect(code, options, chain);
+            } catch (int n) {
+                printf("TFusedFaustAudioEffect exception %d \n", n);
+                return NULL;
+            }
+        }
+        
+        virtual ~TFusedFaustAudioEffect()
+        {}
+        
+        void Process(FAUSTFLOAT** input, FAUSTFLOAT** output, long framesNum, long channels)
+        {
+            long param = 0;
+            for (unsigned int i = 0; i < fEffects.size(); i++) {
+                long count = fEffects[i]->GetControlCount();
+                for (long j = 0; j < count; j++, param++) {
+                    SetControlValue(param, fEffects[i]->GetControlValue(j));
+                }
+            }
+            TCodeFaustAudioEffect::Process(input, output, framesNum, channels);
+        }
+        
+        long GetEffectCount()
+        {
+            return fEffects.size();
+        }
+};
+
+typedef TFusedFaustAudioEffect * TFusedFaustAudioEffectPtr;
+
 #endif
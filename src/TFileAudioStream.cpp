@@ -22,6 +22,7 @@ research@grame.fr
 
 #include "TFileAudioStream.h"
 #include "TAudioGlobals.h"
+#include "TAudioLog.h"
 #include "UAudioTools.h"
 #include "UTools.h"
 #include <stdio.h>
@@ -31,6 +32,7 @@ research@grame.fr
 void TFileAudioStream::ReadBufferAux(TFileAudioStreamPtr obj, SHORT_BUFFER buffer, long framesNum, long framePos)
 {
     obj->TBufferedAudioStream::ReadBuffer(buffer, framesNum, framePos);
+    obj->removeReference();
 }
 
 // Handle the disk read function with the command manager: either direct or low-priority thread based
@@ -38,9 +40,11 @@ void TFileAudioStream::ReadBuffer(SHORT_BUFFER buffer, long framesNum, long fram
 {
     fReady = false;
     if (fManager == 0) {
-        printf("Error : stream rendered without command manager\n");
+        TAudioLog::Log("Error : stream rendered without command manager\n");
     }
     assert(fManager);
+    // The command holds a reference, the stream may be deleted by it
+    addReference();
     fManager->ExecCmd((CmdPtr)ReadBufferAux, (long)this, (long)buffer, framesNum, framePos, 0);
 }
 
@@ -48,6 +52,7 @@ void TFileAudioStream::ReadBuffer(SHORT_BUFFER buffer, long framesNum, long fram
 void TFileAudioStream::WriteBufferAux(TFileAudioStreamPtr obj, SHORT_BUFFER buffer, long framesNum, long framePos)
 {
     obj->TBufferedAudioStream::WriteBuffer(buffer, framesNum, framePos);
+    obj->removeReference();
 }
 
 // Handle the disk write function with the command manager: either direct or low-priority thread based
@@ -55,9 +60,10 @@ void TFileAudioStream::WriteBuffer(SHORT_BUFFER buffer, long framesNum, long fra
 {
     fReady = false;
     if (fManager == 0) {
-        printf("Error : stream rendered without command manager\n");
+        TAudioLog::Log("Error : stream rendered without command manager\n");
     }
     assert(fManager);
+    addReference();
     fManager->ExecCmd((CmdPtr)WriteBufferAux, (long)this, (long)buffer, framesNum, framePos, 0);
 }
 
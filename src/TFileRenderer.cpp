@@ -0,0 +1,144 @@
+/*
+
+Copyright (C) Grame 2002-2013
+
+This library is free software; you can redistribute it and modify it under
+the terms of the GNU Library General Public License as published by the
+Free Software Foundation version 2 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public License
+for more details.
+
+You should have received a copy of the GNU Library General Public License
+along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+Grame Research Laboratory, 9, rue du Garet 69001 Lyon - France
+research@grame.fr
+
+*/
+
+#include "TFileRenderer.h"
+#include "TRendererAudioStream.h"
+#include "UAudioTools.h"
+#include "UTools.h"
+#include "StringTools.h"
+#include "TAudioLog.h"
+#include "msAtomic.h"
+#include <stdio.h>
+#include <assert.h>
+
+#ifdef WIN32
+	#include <windows.h>
+	#define RenderSleep(val) Sleep(val)
+#else
+	#include <unistd.h>
+	#define RenderSleep(val) usleep(val*1000)
+#endif
+
+TFileRenderer::TFileRenderer(TCmdManagerPtr encoder): fEncoder(encoder), fFile(0), fEncoded(0), fError(0)
+{
+    for (long i = 0; i < kBlocks; i++) {
+        fBlocks[i] = 0;
+    }
+}
+
+TFileRenderer::~TFileRenderer()
+{
+    for (long i = 0; i < kBlocks; i++) {
+        delete fBlocks[i];
+    }
+}
+
+// Callback called by command manager
+void TFileRenderer::EncodeAux(TFileRendererPtr obj, long index, long framesNum, long u3, long u4)
+{
+    obj->Encode(index, framesNum);
+}
+
+void TFileRenderer::Encode(long index, long framesNum)
+{
+    if (sf_writef_float(fFile, fBlocks[index]->GetFrame(0), framesNum) != framesNum) {
+        TAudioLog::Log("TFileRenderer::Encode : sf_writef_float error = %s\n", sf_strerror(fFile));
+        fError = 1;
+    }
+    msAtomicSet(&fEncoded, fEncoded + 1);
+}
+
+long TFileRenderer::Render(TAudioStreamPtr stream, string name, long format, long blockSize, float* framesPerSec)
+{
+    if (!stream || blockSize <= 0) {
+        return -1;
+    }
+
+    TAudioContextPtr context = stream->GetContext();
+    long channels = stream->Channels();
+    SF_INFO info;
+    info.samplerate = context->fSampleRate;
+    info.channels = channels;
+    info.format = format;
+    char utf8name[512] = {0};
+
+    assert(name.size() < 512);
+    Convert2UTF8(name.c_str(), utf8name, 512);
+    fFile = sf_open(utf8name, SFM_WRITE, &info);
+
+    if (!fFile) {
+        printf("TFileRenderer::Render : cannot open %s\n", name.c_str());
+        return -1;
+    }
+
+    for (long i = 0; i < kBlocks; i++) {
+        fBlocks[i] = new TLocalAudioBuffer<float>(blockSize, channels);
+    }
+
+    // Files are read synchronously by the rendering thread
+    TAudioStreamPtr renderer = new TDTRendererAudioStream(stream, &fReader);
+    renderer->Reset();
+
+    double start = UTools::GetTime();
+    unsigned long rendered = 0;
+    long total = 0;
+    long res;
+
+    do {
+        // Wait for the oldest block to be written
+        while (rendered - fEncoded >= kBlocks) {
+            RenderSleep(1);
+        }
+        long index = long(rendered % kBlocks);
+        UAudioTools::ZeroFloatBlk(fBlocks[index]->GetFrame(0), blockSize, channels);
+        // Streams are read by fBufferSize chunks at most (scratch and disk buffers sizes)
+        long framesNum, chunk;
+        res = 0;
+        do {
+            framesNum = UTools::Min(context->fBufferSize, blockSize - res);
+            chunk = renderer->Read(fBlocks[index], framesNum, res, channels);
+            res += chunk;
+        } while (chunk == framesNum && res < blockSize);
+        if (res > 0) {
+            total += res;
+            rendered++;
+            fEncoder->ExecCmd((CmdPtr)EncodeAux, (long)this, index, res, 0, 0);
+        }
+    } while (res == blockSize && !fError);
+
+    // Wait for the encoder
+    while (fEncoded != rendered) {
+        RenderSleep(1);
+    }
+
+    // The stream no more uses the command manager of this renderer
+    TCmdHandler::SetTreeManager(stream, TDTRendererAudioStream::GetCmdManager());
+
+    double duration = UTools::GetTime() - start;
+    if (framesPerSec) {
+        *framesPerSec = (duration > 0) ? float(double(total) / duration) : 0.f;
+    }
+
+    sf_close(fFile);
+    fFile = 0;
+    return (fError) ? -1 : total;
+}
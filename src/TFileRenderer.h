@@ -0,0 +1,80 @@
+/*
+
+Copyright (C) Grame 2002-2013
+
+This library is free software; you can redistribute it and modify it under
+the terms of the GNU Library General Public License as published by the
+Free Software Foundation version 2 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public License
+for more details.
+
+You should have received a copy of the GNU Library General Public License
+along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+Grame Research Laboratory, 9, rue du Garet 69001 Lyon - France
+research@grame.fr
+
+*/
+
+#ifndef __TFileRenderer__
+#define __TFileRenderer__
+
+#include "TAudioStream.h"
+#include "TCmdManager.h"
+#include <sndfile.h>
+#include <string>
+
+using namespace std;
+
+//---------------------
+// Class TFileRenderer
+//---------------------
+/*!
+\brief Renders a stream in a sound file as fast as possible.
+*/
+
+/*
+The stream is pulled by the calling thread into large blocks (by fBufferSize chunks, the size stream
+scratch buffers are planned for), using its own direct command manager so that files are read synchronously.
+Rendered blocks go through a ring of kBlocks blocks to the encoder command manager thread which writes
+them (sf_writef_float, the format conversion and compression are done by libsndfile): rendering the
+next blocks and encoding the previous ones run in parallel.
+
+Blocks are given to the encoder with one command each, in order: the single encoder thread writes
+them in order, and publishes the number of encoded blocks so that the renderer can reuse them.
+*/
+
+class TFileRenderer
+{
+
+    private:
+
+        enum { kBlocks = 4 };
+
+        TCmdManagerPtr fEncoder;                // Single thread command manager
+        TDirectCmdManager fReader;              // Command manager of the rendered stream, owned by the renderer
+        SNDFILE* fFile;
+        FLOAT_BUFFER fBlocks[kBlocks];
+        volatile unsigned long fEncoded;        // Written by the encoder thread only
+        volatile long fError;
+
+        static void EncodeAux(TFileRenderer* obj, long index, long framesNum, long u3, long u4);
+
+        void Encode(long index, long framesNum);
+
+    public:
+
+        TFileRenderer(TCmdManagerPtr encoder);
+        virtual ~TFileRenderer();
+
+        // Returns the number of rendered frames, or a negative value if the file cannot be written
+        long Render(TAudioStreamPtr stream, string name, long format, long blockSize, float* framesPerSec);
+};
+
+typedef TFileRenderer * TFileRendererPtr;
+
+#endif
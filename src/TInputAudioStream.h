@@ -24,7 +24,6 @@ research@grame.fr
 #define __TInputAudioStream__
 
 #include "TAudioStream.h"
-#include "TSharedBuffers.h"
 
 //-------------------------
 // Class TInputAudioStream
@@ -45,9 +44,9 @@ class TInputAudioStream : public TAudioStream
 
         long Read(FLOAT_BUFFER buffer, long framesNum, long framePos, long channels)
         {
-            assert(TSharedBuffers::GetInBuffer());
+            assert(fContext->fInBuffer);
             UAudioTools::MixFrameToFrameBlk1(buffer->GetFrame(framePos),
-                                             TSharedBuffers::GetInBuffer(),
+                                             fContext->fInBuffer,
                                              framesNum,
                                              channels);
             return framesNum;
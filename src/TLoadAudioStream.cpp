@@ -0,0 +1,226 @@
+/*
+
+Copyright (C) Grame 2002-2013
+
+This library is free software; you can redistribute it and modify it under
+the terms of the GNU Library General Public License as published by the
+Free Software Foundation version 2 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public License
+for more details.
+
+You should have received a copy of the GNU Library General Public License
+along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+Grame Research Laboratory, 9, rue du Garet 69001 Lyon - France
+research@grame.fr
+
+*/
+
+#include "TLoadAudioStream.h"
+#include "TAudioStreamFactory.h"
+#include "TRendererAudioStream.h"
+#include "TScratchArena.h"
+#include "UTools.h"
+#include "msAtomic.h"
+#include <limits.h>
+
+#ifdef WIN32
+	#include <windows.h>
+	#define LoadSleep(val) Sleep(val)
+#else
+	#include <unistd.h>
+	#define LoadSleep(val) usleep(val*1000)
+#endif
+
+TLoadBatch::TLoadBatch(const vector<TLoadAudioStream*>& streams, LoadCallback callback, void* context)
+{
+    fCount = long(streams.size());
+    fJobs = new TLoadJob[fCount];
+    fNext = 0;
+    fRefs = fCount;
+    fCallback = callback;
+    fContext = context;
+
+    for (long i = 0; i < fCount; i++) {
+        fJobs[i].fStream = streams[i];
+        fJobs[i].fState = kQueued;
+        streams[i]->fBatch = this;
+        streams[i]->fIndex = i;
+    }
+}
+
+TLoadBatch::~TLoadBatch()
+{
+    delete [] fJobs;
+}
+
+// Callback called by command manager
+void TLoadBatch::RunAux(TLoadBatchPtr obj, long u1, long u2, long u3, long u4)
+{
+    obj->Run();
+    if (msAtomicAdd(&obj->fRefs, -1) == 0) {
+        delete obj;
+    }
+}
+
+void TLoadBatch::Run()
+{
+    long index;
+
+    while ((index = msAtomicAdd(&fNext, 1) - 1) < fCount) {
+        TLoadJob& job = fJobs[index];
+        if (CAS(&job.fState, (void*)kQueued, (void*)kLoading)) {
+            job.fStream->Load();
+            long state = job.fStream->fState;
+            // From now on the stream may be deleted
+            CAS(&job.fState, (void*)kLoading, (void*)kDone);
+            if (fCallback) {
+                fCallback(fContext, index, state);
+            }
+        }
+    }
+}
+
+void TLoadBatch::Start(TCmdManagerPtr manager)
+{
+    if (manager) {
+        long commands = UTools::Min(fCount, manager->GetThreadCount());
+        fRefs = fCount + commands;
+        for (long i = 0; i < commands; i++) {
+            manager->ExecParallelCmd((CmdPtr)RunAux, (long)this, 0, 0, 0, 0);
+        }
+    } else {
+        Run();
+    }
+}
+
+void TLoadBatch::Cancel(long index)
+{
+    // Wait for the stream to be opened if it is being opened
+    if (!CAS(&fJobs[index].fState, (void*)kQueued, (void*)kCancelled)) {
+        while (fJobs[index].fState == kLoading) {
+            LoadSleep(1);
+        }
+    }
+
+    if (msAtomicAdd(&fRefs, -1) == 0) {
+        delete this;
+    }
+}
+
+TLoadAudioStream::TLoadAudioStream(string name, long beginFrame, long endFrame)
+    : fName(name), fBeginFrame(beginFrame), fEndFrame(endFrame)
+{
+    fLoaded = 0;
+    fState = kLoading;
+    fAttached = false;
+    fBatch = 0;
+    fIndex = 0;
+}
+
+TLoadAudioStream::~TLoadAudioStream()
+{
+    if (fBatch) {
+        fBatch->Cancel(fIndex);
+    }
+    if (fLoaded) {
+        fLoaded->removeReference();
+    }
+}
+
+void TLoadAudioStream::Load(const vector<TLoadAudioStream*>& streams, LoadCallback callback, void* context)
+{
+    if (streams.size() > 0) {
+        TLoadBatchPtr batch = new TLoadBatch(streams, callback, context);
+        batch->Start(TRTRendererAudioStream::GetCmdManager());
+    }
+}
+
+// Called by the batch, in a command manager thread
+void TLoadAudioStream::Load()
+{
+    // The file stream is built in the context of the loader
+    TAudioContextScope scope(fContext);
+    TAudioStreamPtr stream = (fBeginFrame == 0 && fEndFrame < 0)
+        ? TAudioStreamFactory::MakeReadSound(fName)
+        : TAudioStreamFactory::MakeRegionSound(fName, fBeginFrame, (fEndFrame < 0) ? LONG_MAX : fEndFrame);
+
+    if (stream) {
+        // No manager yet: the beginning of the file is acquired here
+        TScratchPlanner::Plan(stream);
+        TPrefetcher::Prefetch(stream, fContext->GetHorizon());
+        stream->addReference();
+        fLoaded = stream;
+        CAS(&fState, (void*)kLoading, (void*)kReady);
+    } else {
+        CAS(&fState, (void*)kLoading, (void*)-1);
+    }
+}
+
+void TLoadAudioStream::Attach()
+{
+    if (!fAttached) {
+        TCmdHandler::SetTreeManager(fLoaded, fManager);
+        fAttached = true;
+    }
+}
+
+long TLoadAudioStream::Read(FLOAT_BUFFER buffer, long framesNum, long framePos, long channels)
+{
+    if (fState == kReady) {
+        Attach();
+        return fLoaded->Read(buffer, framesNum, framePos, channels);
+    } else {
+        // Silence until the file is ready, a file that cannot be opened is finished
+        return (fState == kLoading) ? framesNum : 0;
+    }
+}
+
+void TLoadAudioStream::Reset()
+{
+    if (fState == kReady) {
+        Attach();
+        fLoaded->Reset();
+    }
+}
+
+TAudioStreamPtr TLoadAudioStream::CutBegin(long frames)
+{
+    if (fState == kReady) {
+        return fLoaded->CutBegin(frames);
+    } else {
+        TLoadAudioStreamPtr stream = new TLoadAudioStream(fName, fBeginFrame + frames, fEndFrame);
+        Load(vector<TLoadAudioStream*>(1, stream), 0, 0);
+        return stream;
+    }
+}
+
+TAudioStreamPtr TLoadAudioStream::Copy()
+{
+    if (fState == kReady) {
+        return fLoaded->Copy();
+    } else {
+        TLoadAudioStreamPtr stream = new TLoadAudioStream(fName, fBeginFrame, fEndFrame);
+        Load(vector<TLoadAudioStream*>(1, stream), 0, 0);
+        return stream;
+    }
+}
+
+void TLoadAudioStream::Prefetch()
+{
+    if (fState == kReady) {
+        TCmdHandler::SetTreeManager(fLoaded, fManager);
+        TPrefetcher::Prefetch(fLoaded, fContext->GetHorizon());
+    }
+}
+
+void TLoadAudioStream::Release()
+{
+    if (fState == kReady) {
+        TPrefetcher::Release(fLoaded);
+    }
+}
@@ -0,0 +1,165 @@
+/*
+
+Copyright (C) Grame 2002-2013
+
+This library is free software; you can redistribute it and modify it under
+the terms of the GNU Library General Public License as published by the
+Free Software Foundation version 2 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public License
+for more details.
+
+You should have received a copy of the GNU Library General Public License
+along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+Grame Research Laboratory, 9, rue du Garet 69001 Lyon - France
+research@grame.fr
+
+*/
+
+#ifndef __TLoadAudioStream__
+#define __TLoadAudioStream__
+
+#include "TAudioStream.h"
+#include "TCmdHandler.h"
+#include "TPrefetchHandler.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+typedef void (*LoadCallback)(void* context, long index, long state);
+
+class TLoadAudioStream;
+
+//------------------
+// Class TLoadBatch
+//------------------
+/*!
+\brief A set of TLoadAudioStream opened in parallel by the command manager threads.
+*/
+
+/*
+One command per thread is queued (and not one per file, the command lists have a fixed size):
+each command takes the next stream to open until the batch is empty.
+
+A stream deleted before being opened is cancelled, a stream deleted while being opened waits for it.
+The batch is deleted when its commands and streams are all done with it.
+*/
+
+class TLoadBatch
+{
+
+    private:
+
+        enum { kQueued, kLoading, kDone, kCancelled };
+
+        struct TLoadJob
+        {
+            TLoadAudioStream* fStream;
+            volatile long fState;
+        };
+
+        TLoadJob* fJobs;
+        long fCount;
+        volatile long fNext;
+        volatile long fRefs;
+        LoadCallback fCallback;
+        void* fContext;
+
+        static void RunAux(TLoadBatch* obj, long u1, long u2, long u3, long u4);
+
+        void Run();
+
+    public:
+
+        TLoadBatch(const vector<TLoadAudioStream*>& streams, LoadCallback callback, void* context);
+        virtual ~TLoadBatch();
+
+        // Open the streams, in the command manager threads if any
+        void Start(TCmdManagerPtr manager);
+
+        // Called by the stream destructor
+        void Cancel(long index);
+};
+
+typedef TLoadBatch * TLoadBatchPtr;
+
+//------------------------
+// Class TLoadAudioStream
+//------------------------
+/*!
+\brief A TLoadAudioStream opens and primes a file stream in the command manager threads.
+*/
+
+/*
+The file stream (MakeReadSound or MakeRegionSound) is built and its beginning acquired
+by a TLoadBatch, then published to the audio thread. Until then, Read produces silence:
+the file starts to play when it is ready. Length and Channels are only known when the
+stream is ready, it should thus be composed with other streams after it is.
+
+The loaded tree is planned with its own scratch arena, and gets the command manager
+of the loader when it is first read.
+*/
+
+class TLoadAudioStream : public TAudioStream, public TCmdHandler, public TPrefetchHandler
+{
+
+    friend class TLoadBatch;
+
+    public:
+
+        enum { kLoading = 0, kReady = 1 };    // Negative states are errors
+
+    private:
+
+        string fName;
+        long fBeginFrame;
+        long fEndFrame;                         // -1 for the whole file
+
+        TAudioStream* volatile fLoaded;         // Referenced, published once by the batch
+        volatile long fState;
+        bool fAttached;                         // The loaded tree uses fManager, audio thread only
+
+        TLoadBatchPtr fBatch;
+        long fIndex;
+
+        void Load();
+        void Attach();
+
+    public:
+
+        TLoadAudioStream(string name, long beginFrame, long endFrame);
+        virtual ~TLoadAudioStream();
+
+        static void Load(const vector<TLoadAudioStream*>& streams, LoadCallback callback, void* context);
+
+        long GetState()
+        {
+            return fState;
+        }
+
+        virtual long Read(FLOAT_BUFFER buffer, long framesNum, long framePos, long channels);
+
+        virtual void Reset();
+        virtual TAudioStreamPtr CutBegin(long frames);
+        virtual long Length()
+        {
+            return (fState == kReady) ? fLoaded->Length() : 0;
+        }
+        virtual long Channels()
+        {
+            return (fState == kReady) ? fLoaded->Channels() : 1;
+        }
+        virtual TAudioStreamPtr Copy();
+
+        virtual void Prefetch();
+        virtual void Release();
+};
+
+typedef TLoadAudioStream * TLoadAudioStreamPtr;
+
+#endif
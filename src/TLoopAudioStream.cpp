@@ -22,19 +22,32 @@ research@grame.fr
 
 #include "TLoopAudioStream.h"
 #include "TSeqAudioStream.h"
-#include "TAudioGlobals.h"
+#include "TPrefetchHandler.h"
 
 TLoopAudioStream::TLoopAudioStream(TAudioStreamPtr stream, long loop): TDecoratedAudioStream(stream)
 {
     fLoopNum = loop;
     fCurLoop = 0;
+    fCurFrame = 0;
+    fLength = stream->Length();
+    fPrefetched = false;
 }
 
 long TLoopAudioStream::Read(FLOAT_BUFFER buffer, long framesNum, long framePos, long channels)
 {
     long res = fStream->Read(buffer, framesNum, framePos, channels);
+    fCurFrame += res;
+
+    // Parts of the decorated stream released during this loop are needed again for the next one
+    long horizon = fContext->GetHorizon();
+    if (!fPrefetched && (fCurLoop + 1 < fLoopNum) && fCurFrame + horizon >= fLength) {
+        TPrefetcher::Prefetch(fStream, horizon - UTools::Max(0, fLength - fCurFrame));
+        fPrefetched = true;
+    }
 
     if ((res < framesNum) && (++fCurLoop < fLoopNum)) { // Loop
+        fCurFrame = 0;
+        fPrefetched = false;
         fStream->Reset();
         return res + Read(buffer, framesNum - res, framePos + res, channels); // Read the end of the buffer
     } else {
@@ -58,6 +71,8 @@ void TLoopAudioStream::Reset()
 {
     assert(fStream);
     fCurLoop = 0;
+    fCurFrame = 0;
+    fPrefetched = false;
     fStream->Reset();
 }
 
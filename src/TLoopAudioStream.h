@@ -40,6 +40,9 @@ class TLoopAudioStream : public TDecoratedAudioStream
 
         long fLoopNum;
         long fCurLoop;
+        long fCurFrame;     // Position in the current loop
+        long fLength;       // Length of the decorated stream
+        bool fPrefetched;   // The next loop has been prefetched
 
     public:
 
@@ -22,6 +22,7 @@ research@grame.fr
 #include "TMixAudioStream.h"
 #include "UAudioTools.h"
 #include "TAudioGlobals.h"
+#include "TPrefetchHandler.h"
 #include <assert.h>
 
 long TMixAudioStream::Read(FLOAT_BUFFER buffer, long framesNum, long framePos, long channels)
@@ -32,11 +33,13 @@ long TMixAudioStream::Read(FLOAT_BUFFER buffer, long framesNum, long framePos, l
         long res1 = fStream1->Read(buffer, framesNum, framePos, channels);
 
         if (res1 < framesNum) {
+            TPrefetcher::Release(fStream1);
             fStream = fStream2; // Stream1 is finished, fStream variable is used as the remaining stream
             return fStream2->Read(buffer, framesNum, framePos, channels);
         } else {
             long res2 = fStream2->Read(buffer, framesNum, framePos, channels);
             if (res2 < framesNum) {
+                TPrefetcher::Release(fStream2);
                 fStream = fStream1; // Stream2 is finished, fStream variable is used as the remaining stream
             }
             return res1;
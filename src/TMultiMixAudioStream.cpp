@@ -0,0 +1,115 @@
+/*
+Copyright (C) Grame 2002-2013
+
+This library is free software; you can redistribute it and modify it under
+the terms of the GNU Library General Public License as published by the
+Free Software Foundation version 2 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public License
+for more details.
+
+You should have received a copy of the GNU Library General Public License
+along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+Grame Research Laboratory, 9, rue du Garet 69001 Lyon - France
+research@grame.fr
+
+*/
+
+
+#include "TMultiMixAudioStream.h"
+#include "TPrefetchHandler.h"
+#include "UTools.h"
+#include <assert.h>
+
+TMultiMixAudioStream::TMultiMixAudioStream(const std::vector<TAudioStreamPtr>& streams)
+{
+    fStreams = streams;
+    fLive.resize(fStreams.size());
+    for (unsigned int i = 0; i < fStreams.size(); i++) {
+        fLive[i] = fStreams[i];
+    }
+    fLiveCount = long(fStreams.size());
+}
+
+long TMultiMixAudioStream::Read(FLOAT_BUFFER buffer, long framesNum, long framePos, long channels)
+{
+    long res = 0;
+    long i = 0;
+
+    while (i < fLiveCount) {
+        long read = fLive[i]->Read(buffer, framesNum, framePos, channels);
+        res = UTools::Max(res, read);
+        if (read < framesNum) {
+            TPrefetcher::Release(fLive[i]);
+            fLive[i] = fLive[--fLiveCount]; // Finished: the last live stream takes its place
+        } else {
+            i++;
+        }
+    }
+
+    return res;
+}
+
+// The live array keeps raw pointers on the branches
+void TMultiMixAudioStream::SetBranch(long i, TAudioStreamPtr stream)
+{
+    for (long j = 0; j < fLiveCount; j++) {
+        if (fLive[j] == fStreams[i]) {
+            fLive[j] = stream;
+        }
+    }
+    TNaryAudioStream::SetBranch(i, stream);
+}
+
+void TMultiMixAudioStream::Reset()
+{
+    for (unsigned int i = 0; i < fStreams.size(); i++) {
+        fStreams[i]->Reset();
+        fLive[i] = fStreams[i];
+    }
+    fLiveCount = long(fStreams.size());
+}
+
+/*
+CutBegin (Mix (s1 ... sn), n) ==> Mix (CutBegin (s1, n) ... CutBegin (sn, n)) 
+*/
+
+TAudioStreamPtr TMultiMixAudioStream::CutBegin(long frames)
+{
+    std::vector<TAudioStreamPtr> streams;
+    for (unsigned int i = 0; i < fStreams.size(); i++) {
+        streams.push_back(fStreams[i]->CutBegin(frames));
+    }
+    return new TMultiMixAudioStream(streams);
+}
+
+long TMultiMixAudioStream::Length()
+{
+    long length = 0;
+    for (unsigned int i = 0; i < fStreams.size(); i++) {
+        length = UTools::Max(length, fStreams[i]->Length());
+    }
+    return length;
+}
+
+long TMultiMixAudioStream::Channels()
+{
+    long channels = 0;
+    for (unsigned int i = 0; i < fStreams.size(); i++) {
+        channels = UTools::Max(channels, fStreams[i]->Channels());
+    }
+    return channels;
+}
+
+TAudioStreamPtr TMultiMixAudioStream::Copy()
+{
+    std::vector<TAudioStreamPtr> streams;
+    for (unsigned int i = 0; i < fStreams.size(); i++) {
+        streams.push_back(fStreams[i]->Copy());
+    }
+    return new TMultiMixAudioStream(streams);
+}
@@ -0,0 +1,67 @@
+/*
+
+Copyright (C) Grame 2002-2013
+
+This library is free software; you can redistribute it and modify it under
+the terms of the GNU Library General Public License as published by the
+Free Software Foundation version 2 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public License
+for more details.
+
+You should have received a copy of the GNU Library General Public License
+along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+Grame Research Laboratory, 9, rue du Garet 69001 Lyon - France
+research@grame.fr
+
+*/
+
+#ifndef __TMultiMixAudioStream__
+#define __TMultiMixAudioStream__
+
+#include "TAudioStream.h"
+
+//----------------------------
+// Class TMultiMixAudioStream
+//----------------------------
+/*!
+\brief A TMultiMixAudioStream mix N streams.
+*/
+
+/*
+Children are kept in a flat array instead of a chain of binary mixes, a finished child is removed
+from the live array by swapping it with the last live one.
+*/
+
+class TMultiMixAudioStream : public TAudioStream, public TNaryAudioStream
+{
+
+    private:
+
+        std::vector<TAudioStream*> fLive;   // Not finished streams in [0, fLiveCount[
+        long fLiveCount;
+
+    public:
+
+        TMultiMixAudioStream(const std::vector<TAudioStreamPtr>& streams);
+        virtual ~TMultiMixAudioStream()
+        {}
+
+        long Read(FLOAT_BUFFER buffer, long framesNum, long framePos, long channels);
+
+        void SetBranch(long i, TAudioStreamPtr stream);
+
+        void Reset();
+        TAudioStreamPtr CutBegin(long frames);
+        long Length();
+        long Channels();
+        TAudioStreamPtr Copy();
+};
+
+typedef TMultiMixAudioStream * TMultiMixAudioStreamPtr;
+
+#endif
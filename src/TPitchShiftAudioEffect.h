@@ -24,6 +24,12 @@ research@grame.fr
 #define __TPitchShiftAudioEffect__
 
 #include "TAudioEffectInterface.h"
+#include "TAudioConstants.h"
+#include "TAudioContext.h"
+#include "TRealFFT.h"
+#include "UTools.h"
+#include <stdlib.h>
+#include <string.h>
 
 /****************************************************************************
 *
@@ -63,243 +69,201 @@ research@grame.fr
 *
 *****************************************************************************/ 
 
-#define MAX_FRAME_LENGTH 8192
+#define PITCHSHIFT_FRAME_SIZE 2048
+#define PITCHSHIFT_OVERSAMPLING 8
 
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
+//---------------------
+// Class TPhaseVocoder
+//---------------------
+/*!
+\brief Per channel state of the smbPitchShift phase vocoder. All buffers are sized to the FFT frame size,
+the FFT and window tables are shared between channels.
+*/
 
-class FFTShift
+class TPhaseVocoder
 {
 
 	private:
 	
-		float gInFIFO[MAX_FRAME_LENGTH];
-		float gOutFIFO[MAX_FRAME_LENGTH];
-		float gFFTworksp[2*MAX_FRAME_LENGTH];
-		float gLastPhase[MAX_FRAME_LENGTH/2+1];
-		float gSumPhase[MAX_FRAME_LENGTH/2+1];
-		float gOutputAccum[2*MAX_FRAME_LENGTH];
-		float gAnaFreq[MAX_FRAME_LENGTH];
-		float gAnaMagn[MAX_FRAME_LENGTH];
-		float gSynFreq[MAX_FRAME_LENGTH];
-		float gSynMagn[MAX_FRAME_LENGTH];
-		long gRover;
+		long fFrameSize;
+		long fFrameSize2;
+		long fStepSize;
+		long fLatency;
+		long fRover;
+		
+		float* fInFIFO;
+		float* fOutFIFO;
+		float* fWorkspace;      // Windowed frame (fFrameSize)
+		float* fSpectrum;       // fFrameSize2 + 1 complex bins
+		float* fLastPhase;
+		float* fSumPhase;
+		float* fOutputAccum;
+		float* fAnaFreq;
+		float* fAnaMagn;
+		float* fSynFreq;
+		float* fSynMagn;
+		
+		static float* Alloc(long size)
+		{
+			return (float*)calloc(size, sizeof(float));
+		}
 	
 	public:
 	
-		FFTShift() 
+		TPhaseVocoder(long frameSize, long osamp) 
+		{
+			fFrameSize = frameSize;
+			fFrameSize2 = frameSize / 2;
+			fStepSize = frameSize / osamp;
+			fLatency = frameSize - fStepSize;
+			fInFIFO = Alloc(fFrameSize);
+			fOutFIFO = Alloc(fStepSize);
+			fWorkspace = Alloc(fFrameSize);
+			fSpectrum = Alloc(2 * (fFrameSize2 + 1));
+			fLastPhase = Alloc(fFrameSize2 + 1);
+			fSumPhase = Alloc(fFrameSize2 + 1);
+			fOutputAccum = Alloc(fFrameSize + fStepSize);
+			fAnaFreq = Alloc(fFrameSize2 + 1);
+			fAnaMagn = Alloc(fFrameSize2 + 1);
+			fSynFreq = Alloc(fFrameSize2 + 1);
+			fSynMagn = Alloc(fFrameSize2 + 1);
+			Reset();
+		}
+		virtual ~TPhaseVocoder() 
+		{
+			free(fInFIFO);
+			free(fOutFIFO);
+			free(fWorkspace);
+			free(fSpectrum);
+			free(fLastPhase);
+			free(fSumPhase);
+			free(fOutputAccum);
+			free(fAnaFreq);
+			free(fAnaMagn);
+			free(fSynFreq);
+			free(fSynMagn);
+		}
+		
+		void Reset()
 		{
-			gRover = false;
-			memset(gInFIFO, 0, MAX_FRAME_LENGTH*sizeof(float));
-			memset(gOutFIFO, 0, MAX_FRAME_LENGTH*sizeof(float));
-			memset(gFFTworksp, 0, 2*MAX_FRAME_LENGTH*sizeof(float));
-			memset(gLastPhase, 0, (MAX_FRAME_LENGTH/2+1)*sizeof(float));
-			memset(gSumPhase, 0, (MAX_FRAME_LENGTH/2+1)*sizeof(float));
-			memset(gOutputAccum, 0, 2*MAX_FRAME_LENGTH*sizeof(float));
-			memset(gAnaFreq, 0, MAX_FRAME_LENGTH*sizeof(float));
-			memset(gAnaMagn, 0, MAX_FRAME_LENGTH*sizeof(float));
+			fRover = fLatency;
+			memset(fInFIFO, 0, fFrameSize * sizeof(float));
+			memset(fOutFIFO, 0, fStepSize * sizeof(float));
+			memset(fLastPhase, 0, (fFrameSize2 + 1) * sizeof(float));
+			memset(fSumPhase, 0, (fFrameSize2 + 1) * sizeof(float));
+			memset(fOutputAccum, 0, (fFrameSize + fStepSize) * sizeof(float));
 		}
-		~FFTShift() {}
 	
-		void smbPitchShift(float pitchShift, long numSampsToProcess, long fftFrameSize, long osamp, float sampleRate, float *indata, float *outdata)
 		/*
-			Routine smbPitchShift(). See top of file for explanation
-			Purpose: doing pitch shifting while maintaining duration using the Short
-			Time Fourier Transform.
-			Author: (c)1999-2006 Stephan M. Bernsee <smb [AT] dspdimension [DOT] com>
+			Adapted from smbPitchShift(), (c)1999-2006 Stephan M. Bernsee <smb [AT] dspdimension [DOT] com>
+			inWindow is the analysis Hann window, outWindow the synthesis window including the output scaling.
 		*/
+		void Process(float pitchShift, long numSampsToProcess, float sampleRate, TRealFFTPtr fft, 
+					const float* inWindow, const float* outWindow, float* indata, float* outdata)
 		{
-			double magn, phase, tmp, window, real, imag;
-			double freqPerBin, expct;
-			long i,k, qpd, index, inFifoLatency, stepSize, fftFrameSize2;
-
+			float magn, phase, tmp, real, imag;
+			long i, k, qpd, index;
+			
 			/* set up some handy variables */
-			fftFrameSize2 = fftFrameSize/2;
-			stepSize = fftFrameSize/osamp;
-			freqPerBin = sampleRate/(double)fftFrameSize;
-			expct = 2.*M_PI*(double)stepSize/(double)fftFrameSize;
-			inFifoLatency = fftFrameSize-stepSize;
-			if (gRover == false) gRover = inFifoLatency;
-
+			float freqPerBin = sampleRate / float(fFrameSize);
+			float binPerFreq = 1.0f / freqPerBin;
+			float expct = 2.0f * float(M_PI) * float(fStepSize) / float(fFrameSize);
+			float osamp = float(fFrameSize / fStepSize);
+			float toDeviation = osamp / (2.0f * float(M_PI));
+			float fromDeviation = 2.0f * float(M_PI) / osamp;
+	
 			/* main processing loop */
 			for (i = 0; i < numSampsToProcess; i++) {
 
 				/* As long as we have not yet collected enough data just read in */
-				gInFIFO[gRover] = indata[i];
-				outdata[i] = gOutFIFO[gRover-inFifoLatency];
-				gRover++;
+				fInFIFO[fRover] = indata[i];
+				outdata[i] = fOutFIFO[fRover - fLatency];
+				fRover++;
 
 				/* now we have enough data for processing */
-				if (gRover >= fftFrameSize) {
-					gRover = inFifoLatency;
-
-					/* do windowing and re,im interleave */
-					for (k = 0; k < fftFrameSize;k++) {
-						window = -.5*cos(2.*M_PI*(double)k/(double)fftFrameSize)+.5;
-						gFFTworksp[2*k] = gInFIFO[k] * window;
-						gFFTworksp[2*k+1] = 0.;
-					}
+				if (fRover >= fFrameSize) {
+					fRover = fLatency;
 
+					/* do windowing */
+					for (k = 0; k < fFrameSize; k++) {
+						fWorkspace[k] = fInFIFO[k] * inWindow[k];
+					}
 
 					/* ***************** ANALYSIS ******************* */
-					/* do transform */
-					smbFft(gFFTworksp, fftFrameSize, -1);
+					fft->Forward(fWorkspace, fSpectrum);
 
-					/* this is the analysis step */
-					for (k = 0; k <= fftFrameSize2; k++) {
+					for (k = 0; k <= fFrameSize2; k++) {
 
-						/* de-interlace FFT buffer */
-						real = gFFTworksp[2*k];
-						imag = gFFTworksp[2*k+1];
+						real = fSpectrum[2*k];
+						imag = fSpectrum[2*k + 1];
 
 						/* compute magnitude and phase */
-						magn = 2.*sqrt(real*real + imag*imag);
-						phase = atan2(imag,real);
-
-						/* compute phase difference */
-						tmp = phase - gLastPhase[k];
-						gLastPhase[k] = phase;
+						magn = 2.0f * sqrtf(real*real + imag*imag);
+						phase = atan2f(imag, real);
 
-						/* subtract expected phase difference */
-						tmp -= (double)k*expct;
+						/* compute phase difference, subtract expected phase difference */
+						tmp = phase - fLastPhase[k];
+						fLastPhase[k] = phase;
+						tmp -= float(k) * expct;
 
 						/* map delta phase into +/- Pi interval */
-						qpd = tmp/M_PI;
+						qpd = long(tmp / float(M_PI));
 						if (qpd >= 0) qpd += qpd&1;
 						else qpd -= qpd&1;
-						tmp -= M_PI*(double)qpd;
-
-						/* get deviation from bin frequency from the +/- Pi interval */
-						tmp = osamp*tmp/(2.*M_PI);
+						tmp -= float(M_PI) * float(qpd);
 
 						/* compute the k-th partials' true frequency */
-						tmp = (double)k*freqPerBin + tmp*freqPerBin;
-
-						/* store magnitude and true frequency in analysis arrays */
-						gAnaMagn[k] = magn;
-						gAnaFreq[k] = tmp;
-
+						fAnaMagn[k] = magn;
+						fAnaFreq[k] = (float(k) + tmp * toDeviation) * freqPerBin;
 					}
 
 					/* ***************** PROCESSING ******************* */
-					/* this does the actual pitch shifting */
-					memset(gSynMagn, 0, fftFrameSize*sizeof(float));
-					memset(gSynFreq, 0, fftFrameSize*sizeof(float));
-					for (k = 0; k <= fftFrameSize2; k++) { 
-						index = k*pitchShift;
-						if (index <= fftFrameSize2) { 
-							gSynMagn[index] += gAnaMagn[k]; 
-							gSynFreq[index] = gAnaFreq[k] * pitchShift; 
+					memset(fSynMagn, 0, (fFrameSize2 + 1) * sizeof(float));
+					memset(fSynFreq, 0, (fFrameSize2 + 1) * sizeof(float));
+					for (k = 0; k <= fFrameSize2; k++) { 
+						index = long(k * pitchShift);
+						if (index <= fFrameSize2) { 
+							fSynMagn[index] += fAnaMagn[k]; 
+							fSynFreq[index] = fAnaFreq[k] * pitchShift; 
 						} 
 					}
 					
 					/* ***************** SYNTHESIS ******************* */
-					/* this is the synthesis step */
-					for (k = 0; k <= fftFrameSize2; k++) {
-
-						/* get magnitude and true frequency from synthesis arrays */
-						magn = gSynMagn[k];
-						tmp = gSynFreq[k];
-
-						/* subtract bin mid frequency */
-						tmp -= (double)k*freqPerBin;
+					for (k = 0; k <= fFrameSize2; k++) {
 
-						/* get bin deviation from freq deviation */
-						tmp /= freqPerBin;
-
-						/* take osamp into account */
-						tmp = 2.*M_PI*tmp/osamp;
-
-						/* add the overlap phase advance back in */
-						tmp += (double)k*expct;
+						/* get bin deviation from freq deviation, add the overlap phase advance back in */
+						tmp = (fSynFreq[k] * binPerFreq - float(k)) * fromDeviation + float(k) * expct;
 
 						/* accumulate delta phase to get bin phase */
-						gSumPhase[k] += tmp;
-						phase = gSumPhase[k];
+						fSumPhase[k] += tmp;
+						phase = fSumPhase[k];
+						magn = fSynMagn[k];
 
-						/* get real and imag part and re-interleave */
-						gFFTworksp[2*k] = magn*cos(phase);
-						gFFTworksp[2*k+1] = magn*sin(phase);
+						fSpectrum[2*k] = magn * cosf(phase);
+						fSpectrum[2*k + 1] = magn * sinf(phase);
 					} 
-
-					/* zero negative frequencies */
-					for (k = fftFrameSize+2; k < 2*fftFrameSize; k++) gFFTworksp[k] = 0.;
+					
+					/* DC and Nyquist bins are counted once in the original complex synthesis */
+					fSpectrum[0] *= 2.0f;
+					fSpectrum[2*fFrameSize2] *= 2.0f;
 
 					/* do inverse transform */
-					smbFft(gFFTworksp, fftFrameSize, 1);
+					fft->Inverse(fSpectrum, fWorkspace);
 
 					/* do windowing and add to output accumulator */ 
-					for(k=0; k < fftFrameSize; k++) {
-						window = -.5*cos(2.*M_PI*(double)k/(double)fftFrameSize)+.5;
-						gOutputAccum[k] += 2.*window*gFFTworksp[2*k]/(fftFrameSize2*osamp);
+					for (k = 0; k < fFrameSize; k++) {
+						fOutputAccum[k] += outWindow[k] * fWorkspace[k];
 					}
-					for (k = 0; k < stepSize; k++) gOutFIFO[k] = gOutputAccum[k];
+					memcpy(fOutFIFO, fOutputAccum, fStepSize * sizeof(float));
 
 					/* shift accumulator */
-					memmove(gOutputAccum, gOutputAccum+stepSize, fftFrameSize*sizeof(float));
+					memmove(fOutputAccum, fOutputAccum + fStepSize, fFrameSize * sizeof(float));
 
 					/* move input FIFO */
-					for (k = 0; k < inFifoLatency; k++) gInFIFO[k] = gInFIFO[k+stepSize];
+					memmove(fInFIFO, fInFIFO + fStepSize, fLatency * sizeof(float));
 				}
 			}
 		}
-
-		static void smbFft(float *fftBuffer, long fftFrameSize, long sign)
-		/* 
-			FFT routine, (C)1996 S.M.Bernsee. Sign = -1 is FFT, 1 is iFFT (inverse)
-			Fills fftBuffer[0...2*fftFrameSize-1] with the Fourier transform of the
-			time domain data in fftBuffer[0...2*fftFrameSize-1]. The FFT array takes
-			and returns the cosine and sine parts in an interleaved manner, ie.
-			fftBuffer[0] = cosPart[0], fftBuffer[1] = sinPart[0], asf. fftFrameSize
-			must be a power of 2. It expects a complex input signal (see footnote 2),
-			ie. when working with 'common' audio signals our input signal has to be
-			passed as {in[0],0.,in[1],0.,in[2],0.,...} asf. In that case, the transform
-			of the frequencies of interest is in fftBuffer[0...fftFrameSize].
-		*/
-		{
-			float wr, wi, arg, *p1, *p2, temp;
-			float tr, ti, ur, ui, *p1r, *p1i, *p2r, *p2i;
-			long i, bitm, j, le, le2, k;
-
-			for (i = 2; i < 2*fftFrameSize-2; i += 2) {
-				for (bitm = 2, j = 0; bitm < 2*fftFrameSize; bitm <<= 1) {
-					if (i & bitm) j++;
-					j <<= 1;
-				}
-				if (i < j) {
-					p1 = fftBuffer+i; p2 = fftBuffer+j;
-					temp = *p1; *(p1++) = *p2;
-					*(p2++) = temp; temp = *p1;
-					*p1 = *p2; *p2 = temp;
-				}
-			}
-			for (k = 0, le = 2; k < (long)(log(float(fftFrameSize))/log(2.)+.5); k++) {
-				le <<= 1;
-				le2 = le>>1;
-				ur = 1.0;
-				ui = 0.0;
-				arg = M_PI / (le2>>1);
-				wr = cos(arg);
-				wi = sign*sin(arg);
-				for (j = 0; j < le2; j += 2) {
-					p1r = fftBuffer+j; p1i = p1r+1;
-					p2r = p1r+le2; p2i = p2r+1;
-					for (i = j; i < 2*fftFrameSize; i += le) {
-						tr = *p2r * ur - *p2i * ui;
-						ti = *p2r * ui + *p2i * ur;
-						*p2r = *p1r - tr; *p2i = *p1i - ti;
-						*p1r += tr; *p1i += ti;
-						p1r += le; p1i += le;
-						p2r += le; p2i += le;
-					}
-					tr = ur*wr - ui*wi;
-					ui = ur*wi + ui*wr;
-					ur = tr;
-				}
-			}
-		}
-
 };
 
 //------------------------------
@@ -315,37 +279,59 @@ class TPitchShiftAudioEffect : public TAudioEffectInterface
     private:
 
         float fPitchSift;
-		FFTShift* fLeft;
-		FFTShift* fRight;
+		long fSampleRate;		// Of the context the effect is built in
+		TRealFFT fFFT;
+		float fInWindow[PITCHSHIFT_FRAME_SIZE];
+		float fOutWindow[PITCHSHIFT_FRAME_SIZE];
+		TPhaseVocoder* fVocoder[MAX_PLUG_CHANNELS];
+		long fChannels;			// Number of allocated vocoders, following channels are copied
 
     public:
 
-        TPitchShiftAudioEffect(float pitch): TAudioEffectInterface(), fPitchSift(pitch)
+        TPitchShiftAudioEffect(float pitch, long channels = 2): TAudioEffectInterface(), fPitchSift(pitch),
+			fSampleRate(TAudioContext::GetCurrent()->fSampleRate), fFFT(PITCHSHIFT_FRAME_SIZE),
+			fChannels(UTools::Max(1, UTools::Min(channels, MAX_PLUG_CHANNELS)))
         {
-			fLeft = new FFTShift();
-			fRight = new FFTShift();
+			for (int k = 0; k < PITCHSHIFT_FRAME_SIZE; k++) {
+				float window = -.5f * float(cos(2. * M_PI * double(k) / double(PITCHSHIFT_FRAME_SIZE))) + .5f;
+				fInWindow[k] = window;
+				fOutWindow[k] = 2.0f * window / float((PITCHSHIFT_FRAME_SIZE / 2) * PITCHSHIFT_OVERSAMPLING);
+			}
+			for (int i = 0; i < fChannels; i++) {
+				fVocoder[i] = new TPhaseVocoder(PITCHSHIFT_FRAME_SIZE, PITCHSHIFT_OVERSAMPLING);
+			}
 		}
         virtual ~TPitchShiftAudioEffect()
         {
-			delete fLeft;
-			delete fRight;
+			for (int i = 0; i < fChannels; i++) {
+				delete fVocoder[i];
+			}
 		}
 
         void Process(float** input, float** output, long framesNum, long channels)
         {
-			fLeft->smbPitchShift(fPitchSift, framesNum, 2048, 8, TAudioGlobals::fSampleRate, input[0], output[0]);
-			fRight->smbPitchShift(fPitchSift, framesNum, 2048, 8, TAudioGlobals::fSampleRate, input[1], output[1]);
+			int i;
+			for (i = 0; i < channels && i < fChannels; i++) {
+				fVocoder[i]->Process(fPitchSift, framesNum, fSampleRate, &fFFT, fInWindow, fOutWindow, input[i], output[i]);
+			}
+			for (; i < channels; i++) {
+				memcpy(output[i], input[i], framesNum * sizeof(float));
+			}
         }
 
         TAudioEffectInterface* Copy()
         {
-            return new TPitchShiftAudioEffect(fPitchSift);
+            return new TPitchShiftAudioEffect(fPitchSift, fChannels);
         }
         void Reset()
-        {}
+        {
+			for (int i = 0; i < fChannels; i++) {
+				fVocoder[i]->Reset();
+			}
+		}
         long Channels()
         {
-            return 2;
+            return fChannels;
         }
 		
 		long GetControlCount()
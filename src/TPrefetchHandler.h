@@ -0,0 +1,125 @@
+/*
+
+Copyright (C) Grame 2002-2013
+
+This library is free software; you can redistribute it and modify it under
+the terms of the GNU Library General Public License as published by the
+Free Software Foundation version 2 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public License
+for more details.
+
+You should have received a copy of the GNU Library General Public License
+along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+Grame Research Laboratory, 9, rue du Garet 69001 Lyon - France
+research@grame.fr
+
+*/
+
+#ifndef __TPrefetchHandler__
+#define __TPrefetchHandler__
+
+#include "TSeqAudioStream.h"
+
+//------------------------
+// Class TPrefetchHandler
+//------------------------
+/*!
+\brief A TPrefetchHandler acquires its resources (file handle, buffers) only when it is about to be played.
+*/
+
+class TPrefetchHandler
+{
+
+    public:
+
+        virtual ~TPrefetchHandler()
+        {}
+
+        // Acquire the resources, in the command manager thread if any: can be called in the audio thread
+        virtual void Prefetch() = 0;
+        // Release the resources, in the command manager thread if any: can be called in the audio thread
+        virtual void Release() = 0;
+};
+
+typedef TPrefetchHandler * TPrefetchHandlerPtr;
+
+//-------------------
+// Class TPrefetcher
+//-------------------
+/*!
+\brief Prefetches or releases the TPrefetchHandler nodes of a stream tree.
+*/
+
+/*
+Prefetch only goes inside the part of the tree played within the horizon: the second branch of a
+sequence is prefetched by the sequence itself when its first branch comes near its end.
+The tree walk does not allocate and only uses the sequence lengths computed when the tree was built
+(no Length() walk of the sub-trees), so that it can be done in the audio thread.
+*/
+
+class TPrefetcher
+{
+
+    public:
+
+        static void Prefetch(TAudioStream* stream, long horizon)
+        {
+            if (!stream || horizon <= 0) {
+                return;
+            }
+
+            if (TPrefetchHandlerPtr handler = dynamic_cast<TPrefetchHandlerPtr>(stream)) {
+                handler->Prefetch();
+            }
+
+            // Goes inside the second stream if it starts within the horizon
+            if (TSeqAudioStreamPtr seq = dynamic_cast<TSeqAudioStreamPtr>(stream)) {
+                Prefetch(seq->GetBranch1(), horizon);
+                Prefetch(seq->GetBranch2(), horizon - seq->GetBranch2Start());
+            // Goes inside the two branches
+            } else if (TBinaryAudioStreamPtr binary = dynamic_cast<TBinaryAudioStreamPtr>(stream)) {
+                Prefetch(binary->GetBranch1(), horizon);
+                Prefetch(binary->GetBranch2(), horizon);
+            // Goes inside the unary stream
+            } else if (TUnaryAudioStreamPtr unary = dynamic_cast<TUnaryAudioStreamPtr>(stream)) {
+                Prefetch(unary->GetBranch1(), horizon);
+            // Goes inside all branches
+            } else if (TNaryAudioStreamPtr nary = dynamic_cast<TNaryAudioStreamPtr>(stream)) {
+                for (long i = 0; i < nary->GetBranchCount(); i++) {
+                    Prefetch(nary->GetBranch(i), horizon);
+                }
+            }
+        }
+
+        static void Release(TAudioStream* stream)
+        {
+            if (!stream) {
+                return;
+            }
+
+            if (TPrefetchHandlerPtr handler = dynamic_cast<TPrefetchHandlerPtr>(stream)) {
+                handler->Release();
+            }
+
+            // Goes inside the two branches
+            if (TBinaryAudioStreamPtr binary = dynamic_cast<TBinaryAudioStreamPtr>(stream)) {
+                Release(binary->GetBranch1());
+                Release(binary->GetBranch2());
+            // Goes inside the unary stream
+            } else if (TUnaryAudioStreamPtr unary = dynamic_cast<TUnaryAudioStreamPtr>(stream)) {
+                Release(unary->GetBranch1());
+            // Goes inside all branches
+            } else if (TNaryAudioStreamPtr nary = dynamic_cast<TNaryAudioStreamPtr>(stream)) {
+                for (long i = 0; i < nary->GetBranchCount(); i++) {
+                    Release(nary->GetBranch(i));
+                }
+            }
+        }
+};
+
+#endif
@@ -0,0 +1,178 @@
+/*
+
+Copyright (C) Grame 2002-2013
+
+This library is free software; you can redistribute it and modify it under
+the terms of the GNU Library General Public License as published by the
+Free Software Foundation version 2 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public License
+for more details.
+
+You should have received a copy of the GNU Library General Public License
+along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+Grame Research Laboratory, 9, rue du Garet 69001 Lyon - France
+research@grame.fr
+
+*/
+
+#include "TProfileAudioStream.h"
+#include "TBinaryAudioStream.h"
+#include "TTransformAudioStream.h"
+#include <typeinfo>
+#include <stdio.h>
+#include <ctype.h>
+
+long TProfileCounter::fSampling = 1;
+
+// Decorate a branch
+TAudioStreamPtr TProfiler::Wrap(TAudioStreamPtr stream)
+{
+    if (!stream || dynamic_cast<TProfileAudioStreamPtr>((TAudioStream*)stream)) {
+        return stream;
+    } else {
+        Instrument(stream);
+        return new TProfileAudioStream(stream, new TProfileCounter());
+    }
+}
+
+// Decorate the branches of a node
+void TProfiler::Instrument(TAudioStreamPtr stream)
+{
+    if (TBinaryAudioStreamPtr binary = dynamic_cast<TBinaryAudioStreamPtr>((TAudioStream*)stream)) {
+        TAudioStreamPtr s1 = binary->fStream1;
+        TAudioStreamPtr s2 = binary->fStream2;
+        binary->fStream1 = Wrap(s1);
+        binary->fStream2 = Wrap(s2);
+        // The current stream of a binary node is one of its branches
+        if (binary->fStream == s1) {
+            binary->fStream = binary->fStream1;
+        } else if (binary->fStream == s2) {
+            binary->fStream = binary->fStream2;
+        }
+    } else if (TUnaryAudioStreamPtr unary = dynamic_cast<TUnaryAudioStreamPtr>((TAudioStream*)stream)) {
+        unary->fStream = Wrap(unary->fStream);
+    } else if (TNaryAudioStreamPtr nary = dynamic_cast<TNaryAudioStreamPtr>((TAudioStream*)stream)) {
+        for (long i = 0; i < nary->GetBranchCount(); i++) {
+            nary->SetBranch(i, Wrap(nary->GetBranch(i)));
+        }
+    }
+
+    if (TTransformAudioStreamPtr transform = dynamic_cast<TTransformAudioStreamPtr>((TAudioStream*)stream)) {
+        transform->GetEffectList()->Profile();
+    }
+}
+
+TAudioStreamPtr TProfiler::Profile(TAudioStreamPtr stream)
+{
+    return Wrap(stream);
+}
+
+// Collect the nearest profiled nodes below a node
+void TProfiler::Branches(TAudioStreamPtr stream, vector<TProfileAudioStreamPtr>& branches)
+{
+    if (TProfileAudioStreamPtr node = dynamic_cast<TProfileAudioStreamPtr>((TAudioStream*)stream)) {
+        branches.push_back(node);
+    } else if (TBinaryAudioStreamPtr binary = dynamic_cast<TBinaryAudioStreamPtr>((TAudioStream*)stream)) {
+        Branches(binary->GetBranch1(), branches);
+        Branches(binary->GetBranch2(), branches);
+    } else if (TUnaryAudioStreamPtr unary = dynamic_cast<TUnaryAudioStreamPtr>((TAudioStream*)stream)) {
+        Branches(unary->GetBranch1(), branches);
+    } else if (TNaryAudioStreamPtr nary = dynamic_cast<TNaryAudioStreamPtr>((TAudioStream*)stream)) {
+        for (long i = 0; i < nary->GetBranchCount(); i++) {
+            Branches(nary->GetBranch(i), branches);
+        }
+    }
+}
+
+void TProfiler::Dump(TProfileAudioStreamPtr node, long depth, string& res)
+{
+    TAudioStreamPtr stream = node->GetBranch1();
+    TProfileCounterPtr counter = node->fCounter;
+    vector<TProfileAudioStreamPtr> branches;
+    double branchesTime = 0;
+    char line[512];
+
+    Branches(stream, branches);
+    for (unsigned int i = 0; i < branches.size(); i++) {
+        branchesTime += branches[i]->fCounter->fTime;
+    }
+
+    // Load in percent of the duration of the read frames
+    double seconds = double(counter->fFrames) / double(UTools::Max(stream->GetContext()->fSampleRate, 1));
+    double self = (counter->fTime > branchesTime) ? (counter->fTime - branchesTime) : 0.0;
+    snprintf(line, sizeof(line), "%*s%s calls %ld frames %ld total %.3f ms self %.3f ms load %.2f %%\n",
+             int(depth * 2), "", ClassName(typeid(*stream).name()).c_str(), counter->fCalls, counter->fFrames,
+             counter->fTime * 1000.0, self * 1000.0, (seconds > 0) ? (self * 100.0 / seconds) : 0.0);
+    res += line;
+
+    if (TTransformAudioStreamPtr transform = dynamic_cast<TTransformAudioStreamPtr>((TAudioStream*)stream)) {
+        TAudioEffectListPtr effects = transform->GetEffectList();
+        long index = 0;
+        for (list<TAudioEffectInterfacePtr>::iterator iter = effects->begin(); iter != effects->end() && index < effects->GetProfileCount(); iter++, index++) {
+            TProfileCounterPtr effect = effects->GetProfile(index);
+            snprintf(line, sizeof(line), "%*s[%s] calls %ld total %.3f ms\n",
+                     int(depth * 2 + 2), "", ClassName(typeid(*(TAudioEffectInterface*)(*iter)).name()).c_str(),
+                     effect->fCalls, effect->fTime * 1000.0);
+            res += line;
+        }
+    }
+
+    for (unsigned int i = 0; i < branches.size(); i++) {
+        Dump(branches[i], depth + 1, res);
+    }
+}
+
+string TProfiler::Dump(TAudioStreamPtr stream)
+{
+    string res;
+    if (TProfileAudioStreamPtr node = dynamic_cast<TProfileAudioStreamPtr>((TAudioStream*)stream)) {
+        Dump(node, 0, res);
+    }
+    return res;
+}
+
+void TProfiler::Reset(TAudioStreamPtr stream)
+{
+    if (!stream) {
+        return;
+    }
+    if (TProfileAudioStreamPtr node = dynamic_cast<TProfileAudioStreamPtr>((TAudioStream*)stream)) {
+        node->fCounter->Reset();
+    }
+    if (TTransformAudioStreamPtr transform = dynamic_cast<TTransformAudioStreamPtr>((TAudioStream*)stream)) {
+        TAudioEffectListPtr effects = transform->GetEffectList();
+        for (long i = 0; i < effects->GetProfileCount(); i++) {
+            effects->GetProfile(i)->Reset();
+        }
+    }
+
+    if (TBinaryAudioStreamPtr binary = dynamic_cast<TBinaryAudioStreamPtr>((TAudioStream*)stream)) {
+        Reset(binary->GetBranch1());
+        Reset(binary->GetBranch2());
+    } else if (TUnaryAudioStreamPtr unary = dynamic_cast<TUnaryAudioStreamPtr>((TAudioStream*)stream)) {
+        Reset(unary->GetBranch1());
+    } else if (TNaryAudioStreamPtr nary = dynamic_cast<TNaryAudioStreamPtr>((TAudioStream*)stream)) {
+        for (long i = 0; i < nary->GetBranchCount(); i++) {
+            Reset(nary->GetBranch(i));
+        }
+    }
+}
+
+// Type names are "class TName" with Visual C++, and "<length>TName" with gcc for classes outside namespaces
+string TProfiler::ClassName(const char* name)
+{
+    string res = name;
+    if (res.compare(0, 6, "class ") == 0) {
+        return res.substr(6);
+    }
+    string::size_type pos = 0;
+    while (pos < res.size() && isdigit(res[pos])) {
+        pos++;
+    }
+    return res.substr(pos);
+}
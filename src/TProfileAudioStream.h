@@ -0,0 +1,170 @@
+/*
+
+Copyright (C) Grame 2002-2013
+
+This library is free software; you can redistribute it and modify it under
+the terms of the GNU Library General Public License as published by the
+Free Software Foundation version 2 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public License
+for more details.
+
+You should have received a copy of the GNU Library General Public License
+along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+Grame Research Laboratory, 9, rue du Garet 69001 Lyon - France
+research@grame.fr
+
+*/
+
+#ifndef __TProfileAudioStream__
+#define __TProfileAudioStream__
+
+#include "TAudioStream.h"
+#include "UTools.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//-----------------------
+// Class TProfileCounter
+//-----------------------
+/*!
+\brief Read calls, frames and time of a profiled node, shared by the copies of the node.
+*/
+
+/*
+Only one call out of fSampling is timed, and counted fSampling times: with a high enough
+sampling, profiling can be left on. Counters are updated by the thread reading the node
+without locking, values read by the control thread are approximate.
+*/
+
+class TProfileCounter : public la_smartable
+{
+
+    public:
+
+        static long fSampling;      // Time one call out of fSampling
+
+        long fCalls;
+        long fFrames;
+        double fTime;               // In seconds
+
+        TProfileCounter()
+        {
+            Reset();
+        }
+        virtual ~TProfileCounter()
+        {}
+
+        bool Sample()
+        {
+            return (fCalls++ % fSampling) == 0;
+        }
+        void Add(double duration)
+        {
+            fTime += duration * double(fSampling);
+        }
+        void Reset()
+        {
+            fCalls = 0;
+            fFrames = 0;
+            fTime = 0;
+        }
+};
+
+typedef LA_SMARTP<TProfileCounter> TProfileCounterPtr;
+
+//---------------------------
+// Class TProfileAudioStream
+//---------------------------
+/*!
+\brief A TProfileAudioStream times the Read calls of the decorated stream.
+*/
+
+class TProfileAudioStream : public TDecoratedAudioStream
+{
+
+    friend class TProfiler;
+
+    private:
+
+        TProfileCounterPtr fCounter;
+
+    public:
+
+        TProfileAudioStream(TAudioStreamPtr stream, TProfileCounterPtr counter)
+            : TDecoratedAudioStream(stream), fCounter(counter)
+        {}
+        virtual ~TProfileAudioStream()
+        {}
+
+        long Read(FLOAT_BUFFER buffer, long framesNum, long framePos, long channels)
+        {
+            long res;
+            if (fCounter->Sample()) {
+                double start = UTools::GetTime();
+                res = fStream->Read(buffer, framesNum, framePos, channels);
+                fCounter->Add(UTools::GetTime() - start);
+            } else {
+                res = fStream->Read(buffer, framesNum, framePos, channels);
+            }
+            fCounter->fFrames += res;
+            return res;
+        }
+
+        // Copies are accumulated in the same node
+        TAudioStreamPtr CutBegin(long frames)
+        {
+            TAudioStreamPtr stream = fStream->CutBegin(frames);
+            return (stream) ? new TProfileAudioStream(stream, fCounter) : 0;
+        }
+        TAudioStreamPtr Copy()
+        {
+            TAudioStreamPtr stream = fStream->Copy();
+            return (stream) ? new TProfileAudioStream(stream, fCounter) : 0;
+        }
+};
+
+typedef TProfileAudioStream * TProfileAudioStreamPtr;
+
+//-----------------
+// Class TProfiler
+//-----------------
+/*!
+\brief Instruments the nodes of a stream tree, and dumps their profile.
+*/
+
+/*
+Each branch of the tree is decorated in place with a TProfileAudioStream, and the effect lists
+of transform nodes allocate a counter per effect: the tree must be instrumented before being played.
+Timeline clips are not branches of the tree: a timeline is profiled as a whole.
+
+The self time of a node is its time minus the time of its profiled branches.
+*/
+
+class TProfiler
+{
+
+    private:
+
+        static TAudioStreamPtr Wrap(TAudioStreamPtr stream);
+        static void Instrument(TAudioStreamPtr stream);
+        static void Branches(TAudioStreamPtr stream, vector<TProfileAudioStreamPtr>& branches);
+        static void Dump(TProfileAudioStreamPtr node, long depth, string& res);
+
+    public:
+
+        // Returns the instrumented tree
+        static TAudioStreamPtr Profile(TAudioStreamPtr stream);
+        static string Dump(TAudioStreamPtr stream);
+        static void Reset(TAudioStreamPtr stream);
+
+        static string ClassName(const char* name);
+};
+
+#endif
@@ -0,0 +1,289 @@
+/*
+
+Copyright (C) Grame 2002-2013
+
+This library is free software; you can redistribute it and modify it under
+the terms of the GNU Library General Public License as published by the
+Free Software Foundation version 2 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public License
+for more details.
+
+You should have received a copy of the GNU Library General Public License
+along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+Grame Research Laboratory, 9, rue du Garet 69001 Lyon - France
+research@grame.fr
+
+*/
+
+#include "TRTChecker.h"
+#include "UTools.h"
+#include "msAtomic.h"
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__APPLE__) || defined(linux)
+	#include <execinfo.h>
+	#include <unistd.h>
+#endif
+
+TRTChecker::TViolation TRTChecker::fViolations[kViolations];
+volatile long TRTChecker::fViolationCount = 0;
+volatile long TRTChecker::fLost = 0;
+CONTEXT_THREAD long TRTChecker::fDepth = 0;
+CONTEXT_THREAD bool TRTChecker::fInside = false;
+
+void TRTChecker::Record(const char* call)
+{
+    void* frames[kFrames];
+    int depth = 0;
+
+    fInside = true;
+#if defined(__APPLE__) || defined(linux)
+    depth = backtrace(frames, kFrames);
+#endif
+
+    long count = UTools::Min(fViolationCount, long(kViolations));
+    for (long i = 0; i < count; i++) {
+        TViolation& violation = fViolations[i];
+        if (violation.fCount > 0 && violation.fCall == call && violation.fDepth == depth
+            && memcmp(violation.fFrames, frames, depth * sizeof(void*)) == 0) {
+            msAtomicAdd(&violation.fCount, 1);
+            fInside = false;
+            return;
+        }
+    }
+
+    long index = msAtomicAdd(&fViolationCount, 1) - 1;
+    if (index < kViolations) {
+        TViolation& violation = fViolations[index];
+        violation.fCall = call;
+        violation.fDepth = depth;
+        memcpy(violation.fFrames, frames, depth * sizeof(void*));
+        CAS(&violation.fCount, (void*)0, (void*)1);
+    } else {
+        msAtomicAdd(&fLost, 1);
+    }
+    fInside = false;
+}
+
+long TRTChecker::Report()
+{
+    long count = UTools::Min(fViolationCount, long(kViolations));
+    long total = fLost;
+
+    fInside = true;
+    for (long i = 0; i < count; i++) {
+        TViolation& violation = fViolations[i];
+        if (violation.fCount == 0) {
+            continue;
+        }
+        printf("RT violation : %s called %ld times in the audio thread from\n", violation.fCall, violation.fCount);
+        fflush(stdout);
+    #if defined(__APPLE__) || defined(linux)
+        // Skip Record and the interposed function
+        if (violation.fDepth > 2) {
+            backtrace_symbols_fd(violation.fFrames + 2, violation.fDepth - 2, STDOUT_FILENO);
+        }
+    #endif
+        total += violation.fCount;
+        violation.fCount = 0;
+    }
+    if (fLost > 0) {
+        printf("RT violation : %ld calls with other backtraces\n", fLost);
+    }
+    fViolationCount = 0;
+    fLost = 0;
+    fInside = false;
+    return total;
+}
+
+#if defined(RT_CHECK) && defined(linux)
+
+/*
+Interposed functions: the allocator is called through its glibc entry points,
+the other functions through the next definition found by the dynamic linker.
+*/
+
+#include <dlfcn.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <time.h>
+
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void __libc_free(void* ptr);
+
+typedef int (*MutexFun)(pthread_mutex_t* mutex);
+typedef int (*OpenFun)(const char* path, int flags, ...);
+typedef int (*CloseFun)(int fd);
+typedef ssize_t (*ReadFun)(int fd, void* buffer, size_t size);
+typedef ssize_t (*WriteFun)(int fd, const void* buffer, size_t size);
+typedef FILE* (*FOpenFun)(const char* path, const char* mode);
+typedef int (*FCloseFun)(FILE* file);
+typedef size_t (*FReadFun)(void* buffer, size_t size, size_t count, FILE* file);
+typedef size_t (*FWriteFun)(const void* buffer, size_t size, size_t count, FILE* file);
+typedef int (*USleepFun)(useconds_t usec);
+typedef int (*NanoSleepFun)(const struct timespec* req, struct timespec* rem);
+
+static void* Next(void* volatile* fun, const char* name)
+{
+    if (!*fun) {
+        *fun = dlsym(RTLD_NEXT, name);
+    }
+    return *fun;
+}
+
+static void* gMutexLock = 0;
+static void* gMutexTryLock = 0;
+static void* gOpen = 0;
+static void* gClose = 0;
+static void* gRead = 0;
+static void* gWrite = 0;
+static void* gFOpen = 0;
+static void* gFClose = 0;
+static void* gFRead = 0;
+static void* gFWrite = 0;
+static void* gUSleep = 0;
+static void* gNanoSleep = 0;
+
+#define RTCheck(call) if (TRTChecker::IsChecked()) { TRTChecker::Record(call); }
+
+void* malloc(size_t size)
+{
+    RTCheck("malloc");
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+    RTCheck("calloc");
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    RTCheck("realloc");
+    return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr)
+{
+    if (ptr) {
+        RTCheck("free");
+    }
+    __libc_free(ptr);
+}
+
+int pthread_mutex_lock(pthread_mutex_t* mutex)
+{
+    RTCheck("pthread_mutex_lock");
+    return ((MutexFun)Next(&gMutexLock, "pthread_mutex_lock"))(mutex);
+}
+
+int pthread_mutex_trylock(pthread_mutex_t* mutex)
+{
+    RTCheck("pthread_mutex_trylock");
+    return ((MutexFun)Next(&gMutexTryLock, "pthread_mutex_trylock"))(mutex);
+}
+
+int open(const char* path, int flags, ...)
+{
+    mode_t mode = 0;
+    if (flags & O_CREAT) {
+        va_list args;
+        va_start(args, flags);
+        mode = va_arg(args, int);
+        va_end(args);
+    }
+    RTCheck("open");
+    return ((OpenFun)Next(&gOpen, "open"))(path, flags, mode);
+}
+
+int close(int fd)
+{
+    RTCheck("close");
+    return ((CloseFun)Next(&gClose, "close"))(fd);
+}
+
+ssize_t read(int fd, void* buffer, size_t size)
+{
+    RTCheck("read");
+    return ((ReadFun)Next(&gRead, "read"))(fd, buffer, size);
+}
+
+ssize_t write(int fd, const void* buffer, size_t size)
+{
+    RTCheck("write");
+    return ((WriteFun)Next(&gWrite, "write"))(fd, buffer, size);
+}
+
+FILE* fopen(const char* path, const char* mode)
+{
+    RTCheck("fopen");
+    return ((FOpenFun)Next(&gFOpen, "fopen"))(path, mode);
+}
+
+int fclose(FILE* file)
+{
+    RTCheck("fclose");
+    return ((FCloseFun)Next(&gFClose, "fclose"))(file);
+}
+
+size_t fread(void* buffer, size_t size, size_t count, FILE* file)
+{
+    RTCheck("fread");
+    return ((FReadFun)Next(&gFRead, "fread"))(buffer, size, count, file);
+}
+
+size_t fwrite(const void* buffer, size_t size, size_t count, FILE* file)
+{
+    RTCheck("fwrite");
+    return ((FWriteFun)Next(&gFWrite, "fwrite"))(buffer, size, count, file);
+}
+
+int usleep(useconds_t usec)
+{
+    RTCheck("usleep");
+    return ((USleepFun)Next(&gUSleep, "usleep"))(usec);
+}
+
+int nanosleep(const struct timespec* req, struct timespec* rem)
+{
+    RTCheck("nanosleep");
+    return ((NanoSleepFun)Next(&gNanoSleep, "nanosleep"))(req, rem);
+}
+
+}
+
+// Resolve the interposed functions and load the unwinder before the audio thread is started
+static struct TRTCheckerInit
+{
+    TRTCheckerInit()
+    {
+        void* frames[4];
+        backtrace(frames, 4);
+        Next(&gMutexLock, "pthread_mutex_lock");
+        Next(&gMutexTryLock, "pthread_mutex_trylock");
+        Next(&gOpen, "open");
+        Next(&gClose, "close");
+        Next(&gRead, "read");
+        Next(&gWrite, "write");
+        Next(&gFOpen, "fopen");
+        Next(&gFClose, "fclose");
+        Next(&gFRead, "fread");
+        Next(&gFWrite, "fwrite");
+        Next(&gUSleep, "usleep");
+        Next(&gNanoSleep, "nanosleep");
+    }
+} gRTCheckerInit;
+
+#endif
@@ -0,0 +1,96 @@
+/*
+
+Copyright (C) Grame 2002-2013
+
+This library is free software; you can redistribute it and modify it under
+the terms of the GNU Library General Public License as published by the
+Free Software Foundation version 2 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public License
+for more details.
+
+You should have received a copy of the GNU Library General Public License
+along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+Grame Research Laboratory, 9, rue du Garet 69001 Lyon - France
+research@grame.fr
+
+*/
+
+#ifndef __TRTChecker__
+#define __TRTChecker__
+
+#include "TAudioContext.h"
+
+#ifdef RT_CHECK
+	#define RTCheckEnter() TRTChecker::Enter()
+	#define RTCheckLeave() TRTChecker::Leave()
+#else
+	#define RTCheckEnter()
+	#define RTCheckLeave()
+#endif
+
+//------------------
+// Class TRTChecker
+//------------------
+/*!
+\brief Debug mode detecting the calls that may block in the audio thread.
+*/
+
+/*
+When the library is built with RT_CHECK, the renderers mark the audio thread during their callback,
+and malloc, calloc, realloc, free, pthread_mutex_lock, pthread_mutex_trylock, the file I/O functions
+and the sleep functions are interposed (Linux): a call from a marked thread is recorded with its backtrace.
+Calls with the same backtrace are counted in the same record, Report prints them.
+
+Records are claimed with a CAS and filled without allocating, the backtrace of the recording
+itself (which may allocate the first time) is not checked.
+*/
+
+class TRTChecker
+{
+
+    private:
+
+        enum { kViolations = 64, kFrames = 24 };
+
+        struct TViolation
+        {
+            const char* fCall;
+            void* fFrames[kFrames];
+            int fDepth;
+            volatile long fCount;       // 0 until the record is filled
+        };
+
+        static TViolation fViolations[kViolations];
+        static volatile long fViolationCount;
+        static volatile long fLost;     // Calls that did not find a record
+
+        static CONTEXT_THREAD long fDepth;
+        static CONTEXT_THREAD bool fInside;
+
+    public:
+
+        static void Enter()
+        {
+            fDepth++;
+        }
+        static void Leave()
+        {
+            fDepth--;
+        }
+        static bool IsChecked()
+        {
+            return fDepth > 0 && !fInside;
+        }
+
+        static void Record(const char* call);
+
+        // Print and clear the records, returns the number of recorded calls
+        static long Report();
+};
+
+#endif
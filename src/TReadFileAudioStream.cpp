@@ -21,76 +21,158 @@ research@grame.fr
 
 #include "TReadFileAudioStream.h"
 #include "TCmdManager.h"
-#include "TAudioGlobals.h"
+#include "TAudioLog.h"
 #include "UAudioTools.h"
 #include "UTools.h"
-#include "StringTools.h"
+#include "msAtomic.h"
 #include <stdio.h>
 #include <assert.h>
 
 TReadFileAudioStream::TReadFileAudioStream(string name, long beginFrame): TFileAudioStream(name)
 {
-  	memset(&fInfo, 0, sizeof(fInfo));
-	char utf8name[512] = {0};
-	
-	assert(fName.size() < 512);
-	Convert2UTF8(fName.c_str(), utf8name, 512);
-	fFile = sf_open(utf8name, SFM_READ, &fInfo);
+	// The handle is shared with the other streams reading the same file
+	fHandle = TSndFilePool::Open(fName);
 	
     // Check file
-    if (!fFile) {
+    if (!fHandle) {
         throw - 1;
     }
 
-    if (sf_seek(fFile, beginFrame, SEEK_SET) < 0) {
-        sf_close(fFile);
+    fInfo = fHandle->GetInfo();
+
+    if (beginFrame < 0 || beginFrame > long(fInfo.frames)) {
+        TSndFilePool::Close(fHandle);
         throw - 2;
     }
 
-    fFramesNum = long(fInfo.frames);
+    if (fInfo.samplerate != fContext->fSampleRate) {
+        TAudioLog::Log("Warning : file sample rate different from engine sample rate! lib sr = %ld file sr = %d\n", fContext->fSampleRate, fInfo.samplerate);
+    }
+
+    Init(beginFrame);
+}
+
+// Copy of a descriptor: the file is already known
+TReadFileAudioStream::TReadFileAudioStream(TSndFileHandlePtr handle, string name, long beginFrame): TFileAudioStream(name)
+{
+    fHandle = handle;
+    fInfo = fHandle->GetInfo();
+
+    if (beginFrame < 0 || beginFrame > long(fInfo.frames)) {
+        throw - 2;
+    }
+
+    TSndFilePool::Retain(fHandle);
+    Init(beginFrame);
+}
+
+void TReadFileAudioStream::Init(long beginFrame)
+{
+    fFile = 0;
+    fMemoryBuffer = 0;
+    fCopyBuffer = 0;
+    fFramesNum = long(fInfo.frames) - beginFrame;   // Frames to be played, so that the stream stops at the end of file
     fChannels = long(fInfo.channels);
     fBeginFrame = beginFrame;
+    fReadPos = beginFrame;
+    fState = kIdle;
+    fMissed = 0;
+}
 
-	// Needed because we later on use sf_readf_short, should be removed is sf_readf_float is used instead.
-    if (fInfo.format & SF_FORMAT_FLOAT) {
-        int arg = SF_TRUE;
-        sf_command(fFile, SFC_SET_SCALE_FLOAT_INT_READ, &arg, sizeof(arg));
-    }
+// No command is queued anymore, they hold a reference
+TReadFileAudioStream::~TReadFileAudioStream()
+{
+    delete fMemoryBuffer;
+    delete fCopyBuffer;
+    TSndFilePool::Close(fHandle);
+}
+
+TAudioStreamPtr TReadFileAudioStream::CutBegin(long frames)
+{
+    return new TReadFileAudioStream(fHandle, fName, fBeginFrame + frames);
+}
 
-    if (fInfo.samplerate != TAudioGlobals::fSampleRate) {
-        printf("Warning : file sample rate different from engine sample rate! lib sr = %ld file sr = %d\n", TAudioGlobals::fSampleRate, fInfo.samplerate);
+// Callback called by command manager
+void TReadFileAudioStream::AcquireAux(TReadFileAudioStreamPtr obj, long u1, long u2, long u3, long u4)
+{
+    obj->Acquire();
+    obj->removeReference();
+}
+
+// Callback called by command manager
+void TReadFileAudioStream::ReleaseAux(TReadFileAudioStreamPtr obj, long u1, long u2, long u3, long u4)
+{
+    obj->ReleaseResources();
+    obj->removeReference();
+}
+
+// Allocate the buffers and read the first buffer
+void TReadFileAudioStream::Acquire()
+{
+    if (!CAS(&fState, (void*)kQueued, (void*)kBusy)) {
+        return;
     }
 
+    fReadPos = fBeginFrame;
+
     // Dynamic allocation
-    fMemoryBuffer = new TLocalAudioBuffer<short>(TAudioGlobals::fStreamBufferSize, fChannels);
-    fCopyBuffer = new TLocalAudioBuffer<short>(TAudioGlobals::fStreamBufferSize, fChannels);
-  
+    fMemoryBuffer = new TLocalAudioBuffer<short>(fContext->fStreamBufferSize, fChannels);
+    fCopyBuffer = new TLocalAudioBuffer<short>(fContext->fStreamBufferSize, fChannels);
+
     // Read first buffer directly
-    TBufferedAudioStream::ReadBuffer(fMemoryBuffer, TAudioGlobals::fStreamBufferSize, 0);
-    TAudioBuffer<short>::Copy(fCopyBuffer, 0, fMemoryBuffer, 0, TAudioGlobals::fStreamBufferSize);
+    TBufferedAudioStream::ReadBuffer(fMemoryBuffer, fContext->fStreamBufferSize, 0);
+    TAudioBuffer<short>::Copy(fCopyBuffer, 0, fMemoryBuffer, 0, fContext->fStreamBufferSize);
 
     fReady = true;
+    CAS(&fState, (void*)kBusy, (void*)kOpen);
 }
 
-TReadFileAudioStream::~TReadFileAudioStream()
+// Deallocate the buffers, the file handle is kept by the pool
+// A buffer read posted before is already done, commands of a stream are run in order
+void TReadFileAudioStream::ReleaseResources()
 {
-	if (fFile) {
-        sf_close(fFile);
-        fFile = 0;
+    if (!CAS(&fState, (void*)kReleasing, (void*)kBusy)) {
+        return;
     }
 
     delete fMemoryBuffer;
     delete fCopyBuffer;
+    fMemoryBuffer = 0;
+    fCopyBuffer = 0;
+
+    CAS(&fState, (void*)kBusy, (void*)kIdle);
 }
 
-TAudioStreamPtr TReadFileAudioStream::CutBegin(long frames)
+void TReadFileAudioStream::Prefetch()
 {
-    return new TReadFileAudioStream(fName, fBeginFrame + frames);
+    // A single Acquire command is queued
+    if (CAS(&fState, (void*)kIdle, (void*)kQueued)) {
+        if (fManager) {
+            addReference();
+            fManager->ExecCmd((CmdPtr)AcquireAux, (long)this, 0, 0, 0, 0);
+        } else {
+            Acquire();
+        }
+    }
+}
+
+void TReadFileAudioStream::Release()
+{
+    // The buffers are no more read from now on
+    if (CAS(&fState, (void*)kOpen, (void*)kReleasing)) {
+        if (fManager) {
+            addReference();
+            fManager->ExecCmd((CmdPtr)ReleaseAux, (long)this, 0, 0, 0, 0);
+        } else {
+            ReleaseResources();
+        }
+    }
 }
 
 void TReadFileAudioStream::ReadEndBufferAux(TReadFileAudioStreamPtr obj, long framesNum, long framePos)
 {
     obj->ReadEndBuffer(framesNum, framePos);
+    obj->removeReference();
 }
 
 // Use the end of the copy buffer
@@ -99,24 +181,57 @@ void TReadFileAudioStream::ReadEndBuffer(long framesNum, long framePos)
     TAudioBuffer<short>::Copy(fMemoryBuffer, framePos, fCopyBuffer, framePos, framesNum);
 }
 
+long TReadFileAudioStream::Read(FLOAT_BUFFER buffer, long framesNum, long framePos, long channels)
+{
+    if (fState != kOpen) {
+        long frames = UTools::Min(framesNum, fFramesNum - (fTotalFrames + fCurFrame + fMissed));
+        // Finished stream, possibly already released
+        if (frames <= 0) {
+            return 0;
+        }
+        // Not prefetched in time: ask for the resources, silence until they are ready
+        fContext->AddDiskError();
+        Prefetch();
+        if (fState != kOpen) {
+            fMissed += frames;
+            return frames;
+        }
+    }
+
+    // Skip the frames played as silence, by fBufferSize chunks as the buffers are read
+    while (fMissed > 0) {
+        long frames = Skip(UTools::Min(fMissed, fContext->fBufferSize));
+        fMissed = (frames > 0) ? fMissed - frames : 0;
+    }
+
+    return TBufferedAudioStream::Read(buffer, framesNum, framePos, channels);
+}
+
 void TReadFileAudioStream::Reset()
 {
-    if (sf_seek(fFile, fBeginFrame + TAudioGlobals::fStreamBufferSize, SEEK_SET) < 0) {
-        printf("TReadFileAudioStream::Reset : sf_seek error = %s\n", sf_strerror(fFile));
+    fMissed = 0;
+
+    // The first buffer will be read when the stream is acquired
+    if (fState != kOpen) {
+        TBufferedAudioStream::Reset();
+        return;
     }
 
+    fReadPos = fBeginFrame + fContext->fStreamBufferSize;
+
     // Use only the beginning of the copy buffer, copy the end in the low-priority thread
-    int copySize = TAudioGlobals::fBufferSize * 4;
+    int copySize = fContext->fBufferSize * 4;
 
-    if (copySize < TAudioGlobals::fStreamBufferSize) {
+    if (copySize < fContext->fStreamBufferSize) {
         TAudioBuffer<short>::Copy(fMemoryBuffer, 0, fCopyBuffer, 0, copySize);
         if (fManager == 0) {
-            printf("Error : stream rendered without command manager\n");
+            TAudioLog::Log("Error : stream rendered without command manager\n");
         }
         assert(fManager);
-        fManager->ExecCmd((CmdPtr)ReadEndBufferAux, (long)this, TAudioGlobals::fStreamBufferSize - copySize, copySize, 0, 0);
+        addReference();
+        fManager->ExecCmd((CmdPtr)ReadEndBufferAux, (long)this, fContext->fStreamBufferSize - copySize, copySize, 0, 0);
     } else {
-        TAudioBuffer<short>::Copy(fMemoryBuffer, 0, fCopyBuffer, 0, TAudioGlobals::fStreamBufferSize);
+        TAudioBuffer<short>::Copy(fMemoryBuffer, 0, fCopyBuffer, 0, fContext->fStreamBufferSize);
     }
 
     TBufferedAudioStream::Reset();
@@ -125,8 +240,7 @@ void TReadFileAudioStream::Reset()
 // Called by TCmdManager
 long TReadFileAudioStream::Read(SHORT_BUFFER buffer, long framesNum, long framePos)
 {
-    assert(fFile);
-    return long(sf_readf_short(fFile, buffer->GetFrame(framePos), framesNum)); // In frames
+    long res = fHandle->Read(buffer->GetFrame(framePos), fReadPos, framesNum); // In frames
+    fReadPos += res;
+    return res;
 }
-
-
@@ -24,6 +24,8 @@ research@grame.fr
 #define __TReadFileAudioStream__
 
 #include "TFileAudioStream.h"
+#include "TPrefetchHandler.h"
+#include "TSndFilePool.h"
 #include "TAudioConstants.h"
 
 //----------------------------
@@ -33,17 +35,48 @@ research@grame.fr
 \brief A TReadFileAudioStream is a LibSndFile based disk reader.
 */
 
-class TReadFileAudioStream : public TFileAudioStream
+/*
+A TReadFileAudioStream is only a light descriptor (file handle, begin frame) until it is prefetched:
+the two fStreamBufferSize buffers are acquired when the playback position comes within
+TAudioContext::fHorizon frames (see TPrefetcher), and released when the stream is finished.
+The file handle is shared with all streams reading the same file, and only really open when
+the TSndFilePool budget allows it: reads are positioned.
+
+Acquire and Release run in the command manager thread, fState is changed with CAS so that a single
+thread acquires or releases at a time: Prefetch and Release move the state to kQueued or kReleasing
+in the calling thread before posting the command, so the audio thread never reads buffers being released.
+The commands of a stream are run in order (see TThreadCmdManager): a Release posted after a buffer
+read is run after it. Each queued command holds a reference on the stream, so that the last one
+deletes it: the destructor never waits for commands, it may run in a command manager thread. A stream read before it has been prefetched asks for its resources and plays
+silence until they are ready, which is counted as a disk error: the audio thread never waits for them.
+The silent frames are then skipped in the file, so that the stream keeps its length for its parents.
+*/
+
+class TReadFileAudioStream : public TFileAudioStream, public TPrefetchHandler
 {
 
     private:
 
+        enum { kIdle, kQueued, kBusy, kOpen, kReleasing };
+
         SHORT_BUFFER fCopyBuffer;
+        TSndFileHandlePtr fHandle;
         long fBeginFrame;
+        long fReadPos;      // Next file frame to be read
         SF_INFO fInfo;
+        volatile long fState;
+        long fMissed;               // Frames played as silence before the resources were ready, skipped in the file
+
+        TReadFileAudioStream(TSndFileHandlePtr handle, string name, long beginFrame);
 
         virtual long Read(SHORT_BUFFER buffer, long framesNum, long framePos);
         static void ReadEndBufferAux(TReadFileAudioStream* obj, long framesNum, long framePos);
+        static void AcquireAux(TReadFileAudioStream* obj, long u1, long u2, long u3, long u4);
+        static void ReleaseAux(TReadFileAudioStream* obj, long u1, long u2, long u3, long u4);
+
+        void Init(long beginFrame);
+        void Acquire();
+        void ReleaseResources();
 
     public:
 
@@ -53,16 +86,21 @@ class TReadFileAudioStream : public TFileAudioStream
         // Ajouter constructor avec buffer pour partager le stream
         void ReadEndBuffer(long framesNum, long framePos);
 
+        virtual long Read(FLOAT_BUFFER buffer, long framesNum, long framePos, long channels);
+
         virtual void Reset();
 		virtual TAudioStreamPtr CutBegin(long frames);
         virtual long Length()
         {
-   			return fFramesNum - fBeginFrame;
+   			return fFramesNum;
         }
         virtual TAudioStreamPtr Copy()
         {
-            return new TReadFileAudioStream(fName, fBeginFrame);
+            return new TReadFileAudioStream(fHandle, fName, fBeginFrame);
         }
+
+        virtual void Prefetch();
+        virtual void Release();
         
         int SampleRate() { return fInfo.samplerate; }
 };
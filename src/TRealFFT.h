@@ -0,0 +1,192 @@
+/*
+
+Copyright (C) Grame 2002-2013
+
+This library is free software; you can redistribute it and modify it under
+the terms of the GNU Library General Public License as published by the
+Free Software Foundation version 2 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public License
+for more details.
+
+You should have received a copy of the GNU Library General Public License
+along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+Grame Research Laboratory, 9, rue du Garet 69001 Lyon - France
+research@grame.fr
+
+*/
+
+#ifndef __TRealFFT__
+#define __TRealFFT__
+
+#include <math.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+//-----------------
+// Class TRealFFT
+//-----------------
+/*!
+\brief FFT of a real signal of size N (power of 2), computed as a complex FFT of size N/2 followed by a split step.
+Bit reversal and twiddle tables are computed once in the constructor.
+Spectrums are N/2 + 1 complex bins, stored as interleaved (re, im) pairs.
+*/
+
+class TRealFFT
+{
+
+    private:
+
+        long fSize;         // Real FFT size N
+        long fHalf;         // Complex FFT size M = N/2
+        long* fBitRev;      // Bit reversal table (M)
+        float* fCos;        // cos(2*PI*k/M), k < M/2
+        float* fSin;        // -sin(2*PI*k/M), k < M/2
+        float* fSplitCos;   // cos(2*PI*k/N), k <= M
+        float* fSplitSin;   // -sin(2*PI*k/N), k <= M
+        float* fWork;       // Complex work buffer (2*M)
+
+        void Complex(float* data, bool inverse)
+        {
+            long i, j, k, len, half, step;
+
+            // Bit reversal
+            for (i = 0; i < fHalf; i++) {
+                j = fBitRev[i];
+                if (i < j) {
+                    float tr = data[2*i], ti = data[2*i + 1];
+                    data[2*i] = data[2*j]; data[2*i + 1] = data[2*j + 1];
+                    data[2*j] = tr; data[2*j + 1] = ti;
+                }
+            }
+
+            // First stage : twiddle is 1
+            for (i = 0; i < 2 * fHalf; i += 4) {
+                float tr = data[i + 2], ti = data[i + 3];
+                data[i + 2] = data[i] - tr; data[i + 3] = data[i + 1] - ti;
+                data[i] += tr; data[i + 1] += ti;
+            }
+
+            // Remaining stages
+            float sign = (inverse) ? -1.0f : 1.0f;
+            for (len = 4; len <= fHalf; len <<= 1) {
+                half = len >> 1;
+                step = fHalf / len;
+                for (i = 0; i < fHalf; i += len) {
+                    float* p1 = data + 2*i;
+                    float* p2 = p1 + 2*half;
+                    for (k = 0; k < half; k++) {
+                        float wr = fCos[k * step];
+                        float wi = sign * fSin[k * step];
+                        float tr = p2[2*k] * wr - p2[2*k + 1] * wi;
+                        float ti = p2[2*k] * wi + p2[2*k + 1] * wr;
+                        p2[2*k] = p1[2*k] - tr; p2[2*k + 1] = p1[2*k + 1] - ti;
+                        p1[2*k] += tr; p1[2*k + 1] += ti;
+                    }
+                }
+            }
+        }
+
+    public:
+
+        TRealFFT(long size): fSize(size), fHalf(size / 2)
+        {
+            long i, j, bits = 0;
+            while ((1L << bits) < fHalf) {
+                bits++;
+            }
+
+            fBitRev = new long[fHalf];
+            for (i = 0; i < fHalf; i++) {
+                long rev = 0;
+                for (j = 0; j < bits; j++) {
+                    rev |= ((i >> j) & 1) << (bits - 1 - j);
+                }
+                fBitRev[i] = rev;
+            }
+
+            fCos = new float[fHalf / 2 + 1];
+            fSin = new float[fHalf / 2 + 1];
+            for (i = 0; i <= fHalf / 2; i++) {
+                fCos[i] = float(cos(2. * M_PI * double(i) / double(fHalf)));
+                fSin[i] = float(-sin(2. * M_PI * double(i) / double(fHalf)));
+            }
+
+            fSplitCos = new float[fHalf + 1];
+            fSplitSin = new float[fHalf + 1];
+            for (i = 0; i <= fHalf; i++) {
+                fSplitCos[i] = float(cos(2. * M_PI * double(i) / double(fSize)));
+                fSplitSin[i] = float(-sin(2. * M_PI * double(i) / double(fSize)));
+            }
+
+            fWork = new float[2 * fHalf];
+        }
+        virtual ~TRealFFT()
+        {
+            delete[] fBitRev;
+            delete[] fCos;
+            delete[] fSin;
+            delete[] fSplitCos;
+            delete[] fSplitSin;
+            delete[] fWork;
+        }
+
+        long GetSize()
+        {
+            return fSize;
+        }
+
+        // in : N real samples, out : N/2 + 1 complex bins
+        void Forward(const float* in, float* out)
+        {
+            long k;
+            memcpy(fWork, in, sizeof(float) * fSize);
+            Complex(fWork, false);
+
+            out[0] = fWork[0] + fWork[1];
+            out[1] = 0.0f;
+            out[2 * fHalf] = fWork[0] - fWork[1];
+            out[2 * fHalf + 1] = 0.0f;
+
+            for (k = 1; k < fHalf; k++) {
+                float zr = fWork[2*k], zi = fWork[2*k + 1];
+                float cr = fWork[2*(fHalf - k)], ci = -fWork[2*(fHalf - k) + 1];
+                float er = 0.5f * (zr + cr), ei = 0.5f * (zi + ci);
+                float or_ = 0.5f * (zi - ci), oi = -0.5f * (zr - cr);
+                float wr = fSplitCos[k], wi = fSplitSin[k];
+                out[2*k] = er + wr * or_ - wi * oi;
+                out[2*k + 1] = ei + wr * oi + wi * or_;
+            }
+        }
+
+        // in : N/2 + 1 complex bins, out : N real samples, scaled by N/2
+        void Inverse(const float* in, float* out)
+        {
+            long k;
+
+            for (k = 0; k < fHalf; k++) {
+                float xr = in[2*k], xi = in[2*k + 1];
+                float cr = in[2*(fHalf - k)], ci = -in[2*(fHalf - k) + 1];
+                float er = 0.5f * (xr + cr), ei = 0.5f * (xi + ci);
+                float dr = 0.5f * (xr - cr), di = 0.5f * (xi - ci);
+                float wr = fSplitCos[k], wi = -fSplitSin[k];
+                float or_ = dr * wr - di * wi, oi = dr * wi + di * wr;
+                fWork[2*k] = er - oi;
+                fWork[2*k + 1] = ei + or_;
+            }
+
+            Complex(fWork, true);
+            memcpy(out, fWork, sizeof(float) * fSize);
+        }
+};
+
+typedef TRealFFT * TRealFFTPtr;
+
+#endif
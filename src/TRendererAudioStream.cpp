@@ -37,6 +37,8 @@ void TRendererAudioStream::SetStream(TAudioStreamPtr stream)
 {
     fStream = stream;
     SetManager(stream, GetManager());
+    TScratchPlanner::Plan(stream);
+    TPrefetcher::Prefetch(stream, fContext->GetHorizon());
 }
 
 void TDTRendererAudioStream::Init()
@@ -24,6 +24,8 @@ research@grame.fr
 #define __TRendererAudioStream__
 
 #include "TCmdHandler.h"
+#include "TScratchArena.h"
+#include "TPrefetchHandler.h"
 #include "TBinaryAudioStream.h"
 
 //----------------------------
@@ -48,12 +50,22 @@ class TRendererAudioStream : public TDecoratedAudioStream
         TRendererAudioStream(TAudioStreamPtr stream, TCmdManagerPtr manager)
                 : TDecoratedAudioStream(stream)
         {
+            // The stream is rendered in its own context
+            fContext = stream->GetContext();
             SetManager(stream, manager);
+            TScratchPlanner::Plan(stream);
+            TPrefetcher::Prefetch(stream, fContext->GetHorizon());
         }
         virtual ~TRendererAudioStream()
         {}
 
         void SetStream(TAudioStreamPtr stream);
+        void Reset()
+        {
+            TDecoratedAudioStream::Reset();
+            // Streams released while played are needed again
+            TPrefetcher::Prefetch(fStream, fContext->GetHorizon());
+        }
         void ClearStream()
         {
             fStream = 0;
@@ -75,16 +87,19 @@ class TDTRendererAudioStream : public TRendererAudioStream
     private:
 
         static TCmdManagerPtr fManager;
+        TCmdManagerPtr fOwnManager;     // Manager of a single renderer, the shared one if null
         TCmdManagerPtr GetManager()
         {
-            return fManager;
+            return (fOwnManager) ? fOwnManager : fManager;
         }
 
     public:
 
-        TDTRendererAudioStream(): TRendererAudioStream()
+        TDTRendererAudioStream(): TRendererAudioStream(), fOwnManager(0)
         {}
-        TDTRendererAudioStream(TAudioStreamPtr stream): TRendererAudioStream(stream, fManager)
+        TDTRendererAudioStream(TAudioStreamPtr stream): TRendererAudioStream(stream, fManager), fOwnManager(0)
+        {}
+        TDTRendererAudioStream(TAudioStreamPtr stream, TCmdManagerPtr manager): TRendererAudioStream(stream, manager), fOwnManager(manager)
         {}
         virtual ~TDTRendererAudioStream()
         {}
@@ -92,6 +107,11 @@ class TDTRendererAudioStream : public TRendererAudioStream
         static void Init();
         static void Destroy();
         static void Flush();
+
+        static TCmdManagerPtr GetCmdManager()
+        {
+            return fManager;
+        }
 };
 
 typedef TDTRendererAudioStream * TDTRendererAudioStreamPtr;
@@ -126,6 +146,11 @@ class TRTRendererAudioStream : public TRendererAudioStream
         static void Init(long thread_num);
         static void Destroy();
         static void Flush();
+
+        static TCmdManagerPtr GetCmdManager()
+        {
+            return fManager;
+        }
 };
 
 typedef TRTRendererAudioStream * TRTRendererAudioStreamPtr;
@@ -19,7 +19,6 @@ research@grame.fr
 
 */
 
-#include "TAudioGlobals.h"
 #include "TRubberBandAudioStream.h"
 #include "UTools.h"
 
@@ -33,28 +32,28 @@ TRubberBandAudioStream::TRubberBandAudioStream(TAudioStreamPtr stream, double* p
 	fPitchShiftVal = *pitch_shift;
 	fTimeStretchVal = *time_strech;
    
-	fRubberBand = new RubberBandStretcher(TAudioGlobals::fSampleRate, stream->Channels(), RubberBandStretcher::OptionProcessRealTime);
-	fBuffer = new TLocalAudioBuffer<float>(TAudioGlobals::fStreamBufferSize, TAudioGlobals::fOutput);
+	fChannels = UTools::Min(stream->Channels(), MAX_PLUG_CHANNELS);
+	fRubberBand = new RubberBandStretcher(fContext->fSampleRate, fChannels, RubberBandStretcher::OptionProcessRealTime);
 	
 	fRubberBand->setTimeRatio(1/fTimeStretchVal);
 	fRubberBand->setPitchScale(fPitchShiftVal);
     
     int i;
-    for (i = 0; i < 2; i++) {
-        fTemp1[i] = (float*)calloc(TAudioGlobals::fBufferSize, sizeof(float));
-        fTemp2[i] = (float*)calloc(TAudioGlobals::fBufferSize, sizeof(float));
+    for (i = 0; i < fChannels; i++) {
+        fTemp1[i] = UAudioTools::AlignedCalloc(fContext->fBufferSize);
+        fTemp2[i] = UAudioTools::AlignedCalloc(fContext->fBufferSize);
     }
+    ReserveScratch();
  }
 
 TRubberBandAudioStream::~TRubberBandAudioStream()
 {
 	delete fRubberBand;
-	delete fBuffer;
     
     int i;
-	for (i = 0; i < 2; i++) {
-		free(fTemp1[i]);
-        free(fTemp2[i]);
+	for (i = 0; i < fChannels; i++) {
+		UAudioTools::AlignedFree(fTemp1[i]);
+        UAudioTools::AlignedFree(fTemp2[i]);
 	}
 }
 
@@ -74,20 +73,23 @@ long TRubberBandAudioStream::Read(FLOAT_BUFFER buffer, long framesNum, long fram
 		fRubberBand->setPitchScale(fPitchShiftVal);
 	}
     
+    TSharedAudioBuffer<float> scratch(GetScratch(), fContext->fStreamBufferSize, fChannels);
+    
     while (fRubberBand->available() < framesNum) {
         int needFrames = std::min((int)framesNum, (int)fRubberBand->getSamplesRequired());
         if (needFrames > 0) {
-            UAudioTools::ZeroFloatBlk(fBuffer->GetFrame(0), TAudioGlobals::fBufferSize, TAudioGlobals::fOutput);
-            fStream->Read(fBuffer, needFrames, 0, channels);
+            UAudioTools::ZeroFloatBlk(scratch.GetFrame(0), fContext->fBufferSize, fChannels);
+            fStream->Read(&scratch, needFrames, 0, fChannels);
             // Deinterleave...
-            UAudioTools::Deinterleave(fTemp1, fBuffer->GetFrame(0), needFrames, channels);
+            UAudioTools::Deinterleave(fTemp1, scratch.GetFrame(0), needFrames, fChannels);
             fRubberBand->process(fTemp1, needFrames, false);
         }
     }
     
     fRubberBand->retrieve(fTemp2, std::min((int)framesNum, fRubberBand->available()));
-    // Interleave...
-    UAudioTools::Interleave(buffer->GetFrame(0), fTemp2, framesNum, channels);
+    // Interleave at the native channel count, then distribute channels on output
+    UAudioTools::Interleave(scratch.GetFrame(0), fTemp2, framesNum, fChannels);
+    UAudioTools::Float2FloatMix(scratch.GetFrame(0), buffer->GetFrame(framePos), framesNum, fChannels, channels);
 	return framesNum;
 }
 
@@ -99,6 +101,12 @@ void TRubberBandAudioStream::Reset()
     fRubberBand->setPitchScale(fPitchShiftVal);
 }
 
+// Input and processed buffers at the decorated stream native channel count, never live at the same time
+long TRubberBandAudioStream::ScratchSize()
+{
+    return fContext->fStreamBufferSize * fChannels;
+}
+
 TAudioStreamPtr TRubberBandAudioStream::Copy()
 {
     return new TRubberBandAudioStream(fStream->Copy(), fPitchShift, fTimeStretch);
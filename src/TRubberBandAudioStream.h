@@ -23,6 +23,8 @@ research@grame.fr
 #define __TRubberBandAudioStream__
 
 #include "TAudioStream.h"
+#include "TScratchArena.h"
+#include "TAudioConstants.h"
 #include "rubberband/RubberBandStretcher.h"
 
 //------------------------------
@@ -32,7 +34,7 @@ research@grame.fr
 \brief  A TRubberBandAudioStream object using RubberBand library.
 */
 
-class TRubberBandAudioStream : public TDecoratedAudioStream
+class TRubberBandAudioStream : public TDecoratedAudioStream, public TScratchHandler
 {
 
     private:
@@ -42,9 +44,9 @@ class TRubberBandAudioStream : public TDecoratedAudioStream
 		double fPitchShiftVal;
 		double fTimeStretchVal;
 		RubberBand::RubberBandStretcher* fRubberBand;
-		FLOAT_BUFFER fBuffer;
-        float* fTemp1[2];
-        float* fTemp2[2];
+        float* fTemp1[MAX_PLUG_CHANNELS];
+        float* fTemp2[MAX_PLUG_CHANNELS];
+        long fChannels;
 	
     public:
 
@@ -60,6 +62,7 @@ class TRubberBandAudioStream : public TDecoratedAudioStream
         void Reset();
         TAudioStreamPtr CutBegin(long frames);    // Length in frames
         TAudioStreamPtr Copy();
+        long ScratchSize();
 };
 
 typedef TRubberBandAudioStream * TRubberBandAudioStreamPtr;
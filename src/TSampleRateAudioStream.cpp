@@ -19,9 +19,9 @@ research@grame.fr
 
 */
 
-#include "TAudioGlobals.h"
 #include "TSampleRateAudioStream.h"
 #include "UTools.h"
+#include "TAudioLog.h"
 
 TSampleRateAudioStream::TSampleRateAudioStream(TAudioStreamPtr stream, double ratio, unsigned int quality)
     :TDecoratedAudioStream(stream)
@@ -49,7 +49,8 @@ TSampleRateAudioStream::TSampleRateAudioStream(TAudioStreamPtr stream, double ra
     }
     
     int error;    
-	fResampler = src_new(quality, stream->Channels(), &error);
+	fChannels = stream->Channels();
+	fResampler = src_new(quality, fChannels, &error);
     fRatio = ratio;
     if (error != 0) {
         throw - 1;
@@ -57,7 +58,8 @@ TSampleRateAudioStream::TSampleRateAudioStream(TAudioStreamPtr stream, double ra
      
     fReadPos = 0;
     fReadFrames = 0;    
-    fBuffer = new TLocalAudioBuffer<float>(TAudioGlobals::fStreamBufferSize, TAudioGlobals::fOutput);
+    fBuffer = new TLocalAudioBuffer<float>(fContext->fStreamBufferSize, fChannels);
+    ReserveScratch();
 }
 
 TSampleRateAudioStream::~TSampleRateAudioStream()
@@ -77,29 +79,34 @@ long TSampleRateAudioStream::Read(FLOAT_BUFFER buffer, long framesNum, long fram
     SRC_DATA src_data;
     bool end = false;
     
+    // Resampled buffer at the decorated stream native channel count
+    float* out = GetScratch();
+    
     while (written < framesNum && !end) {
     
         if (fReadFrames == 0) {
             // Read input
-            UAudioTools::ZeroFloatBlk(fBuffer->GetFrame(0), TAudioGlobals::fBufferSize, TAudioGlobals::fOutput);
-            fReadFrames = fStream->Read(fBuffer, TAudioGlobals::fBufferSize, 0, channels);
+            UAudioTools::ZeroFloatBlk(fBuffer->GetFrame(0), fContext->fBufferSize, fChannels);
+            fReadFrames = fStream->Read(fBuffer, fContext->fBufferSize, 0, fChannels);
             fReadPos = 0;
-            end = fReadFrames < TAudioGlobals::fBufferSize;
+            end = fReadFrames < fContext->fBufferSize;
         }
         
         src_data.data_in = fBuffer->GetFrame(fReadPos);
-        src_data.data_out = buffer->GetFrame(framePos);
+        src_data.data_out = out;
         src_data.input_frames = fReadFrames;
-        src_data.output_frames = int(framesNum - written);
+        src_data.output_frames = int(UTools::Min(framesNum - written, fContext->fBufferSize));
         src_data.end_of_input = end;
         src_data.src_ratio = fRatio;
         
         int res = src_process(fResampler, &src_data);
         if (res != 0) {
-            printf("TSampleRateAudioStream::Read ratio = %f err = %s", fRatio, src_strerror(res));
+            TAudioLog::Log("TSampleRateAudioStream::Read ratio = %f err = %s\n", fRatio, src_strerror(res));
             return written;
         }
         
+        // Resampling is done at the native channel count, channels are distributed on output
+        UAudioTools::Float2FloatMix(out, buffer->GetFrame(framePos), src_data.output_frames_gen, fChannels, channels);
         written += src_data.output_frames_gen;
         framePos += src_data.output_frames_gen;
         
@@ -116,6 +123,11 @@ void TSampleRateAudioStream::Reset()
     src_reset(fResampler);
 }
 
+long TSampleRateAudioStream::ScratchSize()
+{
+    return fContext->fBufferSize * fChannels;
+}
+
 TAudioStreamPtr TSampleRateAudioStream::Copy()
 {
     return new TSampleRateAudioStream(fStream->Copy(), fRatio);
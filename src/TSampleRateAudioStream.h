@@ -23,6 +23,7 @@ research@grame.fr
 #define __TSampleRateAudioStream__
 
 #include "TAudioStream.h"
+#include "TScratchArena.h"
 #include <samplerate.h>
 
 //------------------------------
@@ -32,13 +33,14 @@ research@grame.fr
 \brief A TSampleRateAudioStream object using LibSampleRate library.
 */
 
-class TSampleRateAudioStream : public TDecoratedAudioStream
+class TSampleRateAudioStream : public TDecoratedAudioStream, public TScratchHandler
 {
 
     private:
 
-        FLOAT_BUFFER fBuffer;
+        FLOAT_BUFFER fBuffer;       // Input buffer at the decorated stream native channel count
         SRC_STATE* fResampler;
+        long fChannels;
         double fRatio;
    
         int fReadPos;
@@ -59,12 +61,18 @@ class TSampleRateAudioStream : public TDecoratedAudioStream
         TAudioStreamPtr CutBegin(long frames);    // Length in frames
     
         TAudioStreamPtr Copy();
+        long ScratchSize();
         
         long Length()
         {
             return fStream->Length() * fRatio;
         }
         
+        long Channels()
+        {
+            return fChannels;
+        }
+        
         void SetRatio(double ratio) { fRatio = ratio; }
         double GetRatio() { return fRatio; }
         
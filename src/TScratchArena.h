@@ -0,0 +1,220 @@
+/*
+
+Copyright (C) Grame 2002-2013
+
+This library is free software; you can redistribute it and modify it under
+the terms of the GNU Library General Public License as published by the
+Free Software Foundation version 2 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public License
+for more details.
+
+You should have received a copy of the GNU Library General Public License
+along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+Grame Research Laboratory, 9, rue du Garet 69001 Lyon - France
+research@grame.fr
+
+*/
+
+#ifndef __TScratchArena__
+#define __TScratchArena__
+
+#include "TBinaryAudioStream.h"
+#include "UAudioTools.h"
+#include "la_smartpointer.h"
+#include <vector>
+#include <assert.h>
+
+using namespace std;
+
+//---------------------
+// Class TScratchArena
+//---------------------
+/*!
+\brief A set of scratch buffers shared by the streams of a rendered tree.
+*/
+
+/*
+A scratch buffer is only live during the Read call of the stream that uses it, and the Read calls
+of its descendants are nested inside. Streams at the same "scratch depth" (number of scratch using
+ancestors) are thus never live at the same time and share the same slot: the arena footprint grows
+with the tree depth, not with the number of nodes.
+*/
+
+class TScratchArena : public la_smartable
+{
+
+    private:
+
+        vector<float*> fSlots;
+        vector<long> fSizes;
+
+    public:
+
+        TScratchArena()
+        {}
+        virtual ~TScratchArena()
+        {
+            for (unsigned int i = 0; i < fSlots.size(); i++) {
+                UAudioTools::AlignedFree(fSlots[i]);
+            }
+        }
+
+        // Called when the tree is planned, not in the audio thread
+        void Reserve(long slot, long size)
+        {
+            while (long(fSlots.size()) <= slot) {
+                fSlots.push_back(0);
+                fSizes.push_back(0);
+            }
+            if (fSizes[slot] < size) {
+                UAudioTools::AlignedFree(fSlots[slot]);
+                fSlots[slot] = UAudioTools::AlignedCalloc(size);
+                fSizes[slot] = size;
+            }
+        }
+
+        float* GetSlot(long slot)
+        {
+            return fSlots[slot];
+        }
+
+        // Total size in samples
+        long GetSize()
+        {
+            long size = 0;
+            for (unsigned int i = 0; i < fSizes.size(); i++) {
+                size += fSizes[i];
+            }
+            return size;
+        }
+};
+
+typedef LA_SMARTP<TScratchArena> TScratchArenaPtr;
+
+//-----------------------
+// Class TScratchHandler
+//-----------------------
+/*!
+\brief A TScratchHandler uses a TScratchArena slot for its temporary buffers.
+*/
+
+class TScratchHandler
+{
+
+    private:
+
+        TScratchArenaPtr fArena;
+        long fSlot;
+
+    protected:
+
+        // Called in the audio thread, never allocates
+        float* GetScratch()
+        {
+            assert(fArena);
+            return fArena->GetSlot(fSlot);
+        }
+
+        // Called by the constructors, not in the audio thread: private arena for a stream read outside
+        // of a planned tree (direct use), replaced by the shared arena when the tree is planned
+        void ReserveScratch()
+        {
+            if (fArena) {
+                fArena->Reserve(fSlot, ScratchSize());
+            } else {
+                SetScratch(new TScratchArena(), 0);
+            }
+        }
+
+    public:
+
+        TScratchHandler(): fSlot(0)
+        {}
+        virtual ~TScratchHandler()
+        {}
+
+        // Needed size in samples
+        virtual long ScratchSize() = 0;
+
+        void SetScratch(TScratchArenaPtr arena, long slot)
+        {
+            arena->Reserve(slot, ScratchSize());
+            fArena = arena;
+            fSlot = slot;
+        }
+};
+
+typedef TScratchHandler * TScratchHandlerPtr;
+
+//------------------------
+// Class TScratchBoundary
+//------------------------
+/*!
+\brief Marks a stream whose decorated tree is rendered in another thread, and thus planned with its own arena.
+*/
+
+class TScratchBoundary
+{
+
+    public:
+
+        virtual ~TScratchBoundary()
+        {}
+};
+
+//-----------------------
+// Class TScratchPlanner
+//-----------------------
+/*!
+\brief Assigns the TScratchArena slots of a stream tree.
+*/
+
+class TScratchPlanner
+{
+
+    private:
+
+        static void PlanAux(TAudioStream* stream, TScratchArenaPtr arena, long depth)
+        {
+            if (!stream) {
+                return;
+            }
+
+            if (TScratchHandlerPtr handler = dynamic_cast<TScratchHandlerPtr>(stream)) {
+                handler->SetScratch(arena, depth++);
+            }
+
+            if (dynamic_cast<TScratchBoundary*>(stream)) {
+                return;
+            }
+
+            // Goes inside the two branches
+            if (TBinaryAudioStreamPtr binary = dynamic_cast<TBinaryAudioStreamPtr>(stream)) {
+                PlanAux((TAudioStream*)binary->GetBranch1(), arena, depth);
+                PlanAux((TAudioStream*)binary->GetBranch2(), arena, depth);
+            // Goes inside the unary stream
+            } else if (TUnaryAudioStreamPtr unary = dynamic_cast<TUnaryAudioStreamPtr>(stream)) {
+                PlanAux((TAudioStream*)unary->GetBranch1(), arena, depth);
+            // Goes inside all branches
+            } else if (TNaryAudioStreamPtr nary = dynamic_cast<TNaryAudioStreamPtr>(stream)) {
+                for (long i = 0; i < nary->GetBranchCount(); i++) {
+                    PlanAux((TAudioStream*)nary->GetBranch(i), arena, depth);
+                }
+            }
+        }
+
+    public:
+
+        // A new arena is used at each planning, so that a previously planned tree still owns its buffers
+        static void Plan(TAudioStream* stream)
+        {
+            PlanAux(stream, new TScratchArena(), 0);
+        }
+};
+
+#endif
@@ -23,15 +23,15 @@ research@grame.fr
 #include "TSeqAudioStream.h"
 #include "TFadeAudioStream.h"
 #include "TNullAudioStream.h"
-#include "TAudioGlobals.h"
+#include "TPrefetchHandler.h"
 
 TSeqAudioStream::TSeqAudioStream(TAudioStreamPtr s1, TAudioStreamPtr s2, long crossFade): TBinaryAudioStream(s1, s2, s1)
 {
     // A FINIR : aligner le crossFade sur des multiples de la taille des buffers
 
     if (crossFade > 0) {
-        fStream1 = new TFadeAudioStream(s1, TAudioGlobals::fBufferSize, crossFade);
-        fStream2 = new TFadeAudioStream(s2, crossFade, TAudioGlobals::fBufferSize);
+        fStream1 = new TFadeAudioStream(s1, fContext->fBufferSize, crossFade);
+        fStream2 = new TFadeAudioStream(s2, crossFade, fContext->fBufferSize);
     } else {
         fStream1 = s1;
         fStream2 = s2;
@@ -41,6 +41,7 @@ TSeqAudioStream::TSeqAudioStream(TAudioStreamPtr s1, TAudioStreamPtr s2, long cr
     fCrossFade = crossFade;
     fStream = fStream1;
     fCurFrame = 0;
+    fPrefetched = false;
 }
 
 long TSeqAudioStream::Read(FLOAT_BUFFER buffer, long framesNum, long framePos, long channels)
@@ -50,7 +51,13 @@ long TSeqAudioStream::Read(FLOAT_BUFFER buffer, long framesNum, long framePos, l
     fCurFrame += res;
 
     if (fStream == fStream1) {
+        long horizon = fContext->GetHorizon();
+        if (!fPrefetched && fCurFrame + horizon >= fFramesNum) { // fStream2 starts within the horizon
+            TPrefetcher::Prefetch(fStream2, horizon - UTools::Max(0, fFramesNum - fCurFrame));
+            fPrefetched = true;
+        }
         if (res < framesNum) { // End of fStream1
+            TPrefetcher::Release(fStream1);
             fStream = fStream2;
             if (fCurFrame > fFramesNum) { // CrossFade
                 return fStream->Read(buffer, framesNum, framePos, channels); // Mix with the end of the buffer
@@ -91,6 +98,7 @@ void TSeqAudioStream::Reset()
     TBinaryAudioStream::Reset();
     fStream = fStream1;
     fCurFrame = 0;
+    fPrefetched = false;
 }
 
 
@@ -41,6 +41,7 @@ class TSeqAudioStream : public TBinaryAudioStream
         long fCurFrame;
         long fFramesNum;
         long fCrossFade;
+        bool fPrefetched;   // fStream2 has been prefetched
 
     public:
 
@@ -64,6 +65,15 @@ class TSeqAudioStream : public TBinaryAudioStream
         {
             return new TSeqAudioStream(fStream1->Copy(), fStream2->Copy(), fCrossFade);
         }
+        long GetCrossFade()
+        {
+            return fCrossFade;
+        }
+        // Frame where fStream2 starts, computed at construction: no Length() tree walk in the audio thread
+        long GetBranch2Start()
+        {
+            return fFramesNum;
+        }
 };
 
 typedef TSeqAudioStream * TSeqAudioStreamPtr;
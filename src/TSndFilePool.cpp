@@ -0,0 +1,182 @@
+/*
+
+Copyright (C) Grame 2002-2013
+
+This library is free software; you can redistribute it and modify it under
+the terms of the GNU Library General Public License as published by the
+Free Software Foundation version 2 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public License
+for more details.
+
+You should have received a copy of the GNU Library General Public License
+along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+Grame Research Laboratory, 9, rue du Garet 69001 Lyon - France
+research@grame.fr
+
+*/
+
+#include "TSndFilePool.h"
+#include "StringTools.h"
+#include "TAudioLog.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+map<string, TSndFileHandlePtr> TSndFilePool::fHandles;
+TLockAble TSndFilePool::fLock;
+long TSndFilePool::fOpenCount = 0;
+long TSndFilePool::fBudget = 256;
+long TSndFilePool::fStamp = 0;
+
+long TSndFileHandle::Read(short* buffer, long pos, long framesNum)
+{
+    long res = 0;
+    fMutex.Lock();
+
+    if (fFile || TSndFilePool::Reopen(this)) {
+        // Sequential reads of the same stream do not need to seek
+        if (pos == fPos || sf_seek(fFile, pos, SEEK_SET) >= 0) {
+            res = long(sf_readf_short(fFile, buffer, framesNum)); // In frames
+            fPos = pos + res;
+        } else {
+            TAudioLog::Log("TSndFileHandle::Read : sf_seek error = %s\n", sf_strerror(fFile));
+        }
+    }
+
+    // Not under the pool lock: the LRU order is only approximate
+    fLastUse = ++TSndFilePool::fStamp;
+    fMutex.Unlock();
+    return res;
+}
+
+SNDFILE* TSndFilePool::OpenFile(const string& name, SF_INFO* info)
+{
+    char utf8name[512] = {0};
+	assert(name.size() < 512);
+	Convert2UTF8(name.c_str(), utf8name, 512);
+    memset(info, 0, sizeof(SF_INFO));
+	SNDFILE* file = sf_open(utf8name, SFM_READ, info);
+
+	// Needed because we later on use sf_readf_short, should be removed is sf_readf_float is used instead.
+    if (file && (info->format & SF_FORMAT_FLOAT)) {
+        int arg = SF_TRUE;
+        sf_command(file, SFC_SET_SCALE_FLOAT_INT_READ, &arg, sizeof(arg));
+    }
+
+    return file;
+}
+
+// Called with the handle lock
+bool TSndFilePool::Reopen(TSndFileHandlePtr handle)
+{
+    TLock lock(&fLock);
+    SF_INFO info;
+    handle->fFile = OpenFile(handle->fName, &info);
+    handle->fPos = 0;
+
+    if (handle->fFile) {
+        fOpenCount++;
+        Evict(handle);
+        return true;
+    } else {
+        TAudioLog::Log("TSndFilePool::Reopen : cannot open %s\n", handle->fName.c_str());
+        return false;
+    }
+}
+
+// Called with the pool lock: close the least recently read handles not being read
+void TSndFilePool::Evict(TSndFileHandlePtr keep)
+{
+    while (fOpenCount > fBudget) {
+        TSndFileHandlePtr lru = 0;
+        for (map<string, TSndFileHandlePtr>::iterator it = fHandles.begin(); it != fHandles.end(); it++) {
+            TSndFileHandlePtr handle = it->second;
+            if (handle != keep && handle->fFile && (!lru || handle->fLastUse < lru->fLastUse) && handle->fMutex.TryLock() == 0) {
+                if (lru) {
+                    lru->fMutex.Unlock();
+                }
+                lru = handle;
+            }
+        }
+        // All open handles are being read
+        if (!lru) {
+            return;
+        }
+        sf_close(lru->fFile);
+        lru->fFile = 0;
+        fOpenCount--;
+        lru->fMutex.Unlock();
+    }
+}
+
+TSndFileHandlePtr TSndFilePool::Open(const string& name)
+{
+    {
+        TLock lock(&fLock);
+        map<string, TSndFileHandlePtr>::iterator it = fHandles.find(name);
+        if (it != fHandles.end()) {
+            it->second->fRefs++;
+            return it->second;
+        }
+    }
+
+    // Opened without the pool lock, so that several files are opened in parallel
+    SF_INFO info;
+    SNDFILE* file = OpenFile(name, &info);
+    if (!file) {
+        return 0;
+    }
+
+    TLock lock(&fLock);
+    TSndFileHandlePtr handle;
+    map<string, TSndFileHandlePtr>::iterator it = fHandles.find(name);
+
+    // Opened by another thread in the meantime
+    if (it != fHandles.end()) {
+        sf_close(file);
+        handle = it->second;
+    } else {
+        handle = new TSndFileHandle(name);
+        handle->fFile = file;
+        handle->fInfo = info;
+        handle->fLastUse = ++fStamp;
+        fHandles[name] = handle;
+        fOpenCount++;
+        Evict(handle);
+    }
+
+    handle->fRefs++;
+    return handle;
+}
+
+void TSndFilePool::Retain(TSndFileHandlePtr handle)
+{
+    TLock lock(&fLock);
+    handle->fRefs++;
+}
+
+void TSndFilePool::Close(TSndFileHandlePtr handle)
+{
+    TLock lock(&fLock);
+
+    if (--handle->fRefs == 0) {
+        fHandles.erase(handle->fName);
+        if (handle->fFile) {
+            sf_close(handle->fFile);
+            fOpenCount--;
+        }
+        delete handle;
+    }
+}
+
+void TSndFilePool::SetBudget(long budget)
+{
+    TLock lock(&fLock);
+    fBudget = (budget > 0) ? budget : 1;
+    Evict(0);
+}
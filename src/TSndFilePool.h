@@ -0,0 +1,119 @@
+/*
+
+Copyright (C) Grame 2002-2013
+
+This library is free software; you can redistribute it and modify it under
+the terms of the GNU Library General Public License as published by the
+Free Software Foundation version 2 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public License
+for more details.
+
+You should have received a copy of the GNU Library General Public License
+along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+Grame Research Laboratory, 9, rue du Garet 69001 Lyon - France
+research@grame.fr
+
+*/
+
+#ifndef __TSndFilePool__
+#define __TSndFilePool__
+
+#include "TMutex.h"
+#include <sndfile.h>
+#include <string>
+#include <map>
+
+using namespace std;
+
+//----------------------
+// Class TSndFileHandle
+//----------------------
+/*!
+\brief A libsndfile handle shared by all the streams reading the same file.
+*/
+
+class TSndFileHandle
+{
+
+    friend class TSndFilePool;
+
+    private:
+
+        string fName;
+        SF_INFO fInfo;
+        SNDFILE* fFile;     // NULL when evicted, opened again by the next read
+        long fPos;          // Current file position
+        long fRefs;         // Number of streams using the handle (pool lock)
+        long fLastUse;      // LRU stamp
+        TMutex fMutex;      // Serializes positioned reads
+
+        TSndFileHandle(const string& name): fName(name), fFile(0), fPos(0), fRefs(0), fLastUse(0)
+        {}
+        virtual ~TSndFileHandle()
+        {}
+
+    public:
+
+        const SF_INFO& GetInfo()
+        {
+            return fInfo;
+        }
+
+        // Positioned read, called in the command manager threads
+        long Read(short* buffer, long pos, long framesNum);
+};
+
+typedef TSndFileHandle * TSndFileHandlePtr;
+
+//--------------------
+// Class TSndFilePool
+//--------------------
+/*!
+\brief Shares one libsndfile handle per file, and keeps the number of open files under a budget.
+*/
+
+/*
+Handles are kept by name as long as a stream uses them, so that opening another region of an already
+known file does not touch the disk. When more than fBudget files are open, the least recently read
+handles that are not being read are closed: they are transparently opened again by their next read.
+
+Lock order is handle then pool: the pool only uses TryLock on handles.
+*/
+
+class TSndFilePool
+{
+
+    friend class TSndFileHandle;
+
+    private:
+
+        static map<string, TSndFileHandlePtr> fHandles;
+        static TLockAble fLock;
+        static long fOpenCount;
+        static long fBudget;
+        static long fStamp;
+
+        static SNDFILE* OpenFile(const string& name, SF_INFO* info);
+        static bool Reopen(TSndFileHandlePtr handle);
+        static void Evict(TSndFileHandlePtr keep);
+
+    public:
+
+        // Returns NULL if the file cannot be opened
+        static TSndFileHandlePtr Open(const string& name);
+        static void Retain(TSndFileHandlePtr handle);
+        static void Close(TSndFileHandlePtr handle);
+
+        static void SetBudget(long budget);
+        static long GetOpenCount()
+        {
+            return fOpenCount;
+        }
+};
+
+#endif
@@ -19,7 +19,6 @@ research@grame.fr
 
 */
 
-#include "TAudioGlobals.h"
 #include "TSoundTouchAudioStream.h"
 #include "UTools.h"
 
@@ -31,20 +30,20 @@ TSoundTouchAudioStream::TSoundTouchAudioStream(TAudioStreamPtr stream, double* p
 	fPitchShiftVal = *pitch_shift;
 	fTimeStretchVal = *time_strech;
 	
+	fChannels = stream->Channels();
 	fSoundTouch = new soundtouch::SoundTouch();
-	fBuffer = new TLocalAudioBuffer<float>(TAudioGlobals::fStreamBufferSize, TAudioGlobals::fOutput);
 	
-	fSoundTouch->setSampleRate(TAudioGlobals::fSampleRate);
-    fSoundTouch->setChannels(TAudioGlobals::fOutput);
+	fSoundTouch->setSampleRate(fContext->fSampleRate);
+    fSoundTouch->setChannels(fChannels);
 	fSoundTouch->setSetting(SETTING_USE_AA_FILTER, 1);
 	fSoundTouch->setTempo(fTimeStretchVal);
 	fSoundTouch->setPitch(fPitchShiftVal);
+    ReserveScratch();
 }
 
 TSoundTouchAudioStream::~TSoundTouchAudioStream()
 {
 	delete fSoundTouch;
-	delete fBuffer;
 }
 
 TAudioStreamPtr TSoundTouchAudioStream::CutBegin(long frames)
@@ -52,10 +51,27 @@ TAudioStreamPtr TSoundTouchAudioStream::CutBegin(long frames)
     return new TSoundTouchAudioStream(fStream->CutBegin(frames), fPitchShift, fTimeStretch);
 }
 
+// Processing is done at the native channel count, channels are distributed on output
+
+long TSoundTouchAudioStream::Receive(FLOAT_BUFFER buffer, long framesNum, long framePos, long channels)
+{
+	long produced = 0;
+	int available;
+	float* out = GetScratch();
+	
+	while ((available = fSoundTouch->numSamples()) > 0 && produced < framesNum) {
+		long frames = fSoundTouch->receiveSamples(out, UTools::Min(available, int(UTools::Min(framesNum - produced, fContext->fBufferSize))));
+		UAudioTools::Float2FloatMix(out, buffer->GetFrame(framePos + produced), frames, fChannels, channels);
+		produced += frames;
+	}
+	
+	return produced;
+}
+
 long TSoundTouchAudioStream::Read(FLOAT_BUFFER buffer, long framesNum, long framePos, long channels)
 {
 	long read, produced, written = 0;
-	int available;
+	TSharedAudioBuffer<float> in(GetScratch(), fContext->fStreamBufferSize, fChannels);
 	
 	if (fTimeStretchVal != *fTimeStretch) {
 		fTimeStretchVal = *fTimeStretch;
@@ -67,8 +83,8 @@ long TSoundTouchAudioStream::Read(FLOAT_BUFFER buffer, long framesNum, long fram
 	}
 		
 	// Frames still available in the effect
-	if ((available = fSoundTouch->numSamples()) > 0) {
-		produced = fSoundTouch->receiveSamples(buffer->GetFrame(framePos), UTools::Min(available, int(framesNum)));
+	if (fSoundTouch->numSamples() > 0) {
+		produced = Receive(buffer, framesNum, framePos, channels);
 		
 		// Move index
 		framePos += produced;
@@ -83,13 +99,12 @@ long TSoundTouchAudioStream::Read(FLOAT_BUFFER buffer, long framesNum, long fram
 		// Compute remaining needed frames
 		do {
 			// Read input
-			UAudioTools::ZeroFloatBlk(fBuffer->GetFrame(0), TAudioGlobals::fBufferSize, TAudioGlobals::fOutput);
-			read = fStream->Read(fBuffer, TAudioGlobals::fBufferSize, 0, channels);
+			UAudioTools::ZeroFloatBlk(in.GetFrame(0), fContext->fBufferSize, fChannels);
+			read = fStream->Read(&in, fContext->fBufferSize, 0, fChannels);
 			
 			// Process buffer
-			fSoundTouch->putSamples(fBuffer->GetFrame(0), read);
-			available = fSoundTouch->numSamples();
-			produced = fSoundTouch->receiveSamples(buffer->GetFrame(framePos), UTools::Min(available, int(framesNum - written)));
+			fSoundTouch->putSamples(in.GetFrame(0), read);
+			produced = Receive(buffer, framesNum - written, framePos, channels);
 	
 			// Move index
 			framePos += produced;
@@ -109,6 +124,12 @@ void TSoundTouchAudioStream::Reset()
     fSoundTouch->setPitch(fPitchShiftVal);
 }
 
+// Input and processed buffers at the decorated stream native channel count, never live at the same time
+long TSoundTouchAudioStream::ScratchSize()
+{
+    return fContext->fStreamBufferSize * fChannels;
+}
+
 TAudioStreamPtr TSoundTouchAudioStream::Copy()
 {
     return new TSoundTouchAudioStream(fStream->Copy(), fPitchShift, fTimeStretch);
@@ -23,6 +23,7 @@ research@grame.fr
 #define __TSoundTouchAudioStream__
 
 #include "TAudioStream.h"
+#include "TScratchArena.h"
 #include "soundtouch/SoundTouch.h"
 
 //------------------------------
@@ -32,7 +33,7 @@ research@grame.fr
 \brief  A TSoundTouchAudioStream object using SoundTouch library.
 */
 
-class TSoundTouchAudioStream : public TDecoratedAudioStream
+class TSoundTouchAudioStream : public TDecoratedAudioStream, public TScratchHandler
 {
 
     private:
@@ -42,7 +43,9 @@ class TSoundTouchAudioStream : public TDecoratedAudioStream
 		double fPitchShiftVal;
 		double fTimeStretchVal;
 		soundtouch::SoundTouch* fSoundTouch;
-		FLOAT_BUFFER fBuffer;
+		long fChannels;
+		
+		long Receive(FLOAT_BUFFER buffer, long framesNum, long framePos, long channels);
 	
     public:
 
@@ -58,6 +61,7 @@ class TSoundTouchAudioStream : public TDecoratedAudioStream
         void Reset();
         TAudioStreamPtr CutBegin(long frames);    // Length in frames
         TAudioStreamPtr Copy();
+        long ScratchSize();
 };
 
 typedef TSoundTouchAudioStream * TSoundTouchAudioStreamPtr;
@@ -22,6 +22,9 @@ research@grame.fr
 
 #include "TThreadCmdManager.h"
 #include "TThreadUtils.h"
+#include "TTraceRecorder.h"
+#include "TAudioLog.h"
+#include "UTools.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <errno.h>
@@ -32,10 +35,17 @@ void* TThreadCmdManager::CmdHandler(void* arg)
 {
     TThreadCmdManager* manager = (TThreadCmdManager*) arg;
 
+    // Commands are run without the lock, so that the threads run them in parallel and ExecCmd does not wait for them
     pthread_mutex_lock(&manager->fLock);
     while (manager->fRunning) {
+        pthread_mutex_unlock(&manager->fLock);
         manager->RunAux();
-        pthread_cond_wait(&manager->fCond, &manager->fLock);
+        pthread_mutex_lock(&manager->fLock);
+        // Commands are put with the lock: a command put after this test is signaled,
+        // a command put in a lane owned by another thread is run by this thread
+        if (manager->fRunning && !manager->Runnable()) {
+            pthread_cond_wait(&manager->fCond, &manager->fLock);
+        }
     }
     pthread_mutex_unlock(&manager->fLock);
     
@@ -59,14 +69,62 @@ DWORD WINAPI TThreadCmdManager::CmdHandler(void* arg)
 
 #endif
 
-void TThreadCmdManager::RunAux()
+void TThreadCmdManager::RunCmd(TCmd* cmd)
+{
+    double start = UTools::GetTime();
+    TTraceRecorder::FlowEnd("Command", (long)cmd, start);
+    (*((CmdPtr)cmd->fun))(cmd->arg1, cmd->arg2, cmd->arg3, cmd->arg4, cmd->arg5);
+    TTraceRecorder::Complete("Command", start, UTools::GetTime(), (void*)cmd->fun);
+    lfpush(&fFreeCmd, (lifocell*)cmd);
+}
+
+bool TThreadCmdManager::RunLane(long lane)
 {
     TCmd* cmd;
+    bool run = false;
 
-    while ((cmd = (TCmd*) fifoget(&fRunningCmd))) {
-        (*((CmdPtr)cmd->fun))(cmd->arg1, cmd->arg2, cmd->arg3, cmd->arg4, cmd->arg5);
-        lfpush(&fFreeCmd, (lifocell*)cmd);
+    // A command put after the last fifoget is run by this thread after the lane is released,
+    // or by the thread that owns the lane then
+    while (fifosize(&fLaneCmd[lane]) > 0 && CAS(&fLaneOwner[lane], (void*)0, (void*)1)) {
+        while ((cmd = (TCmd*) fifoget(&fLaneCmd[lane]))) {
+            RunCmd(cmd);
+            run = true;
+        }
+        CAS(&fLaneOwner[lane], (void*)1, (void*)0);
     }
+    return run;
+}
+
+// A command is waiting and no other thread will run it
+bool TThreadCmdManager::Runnable()
+{
+    if (fifosize(&fRunningCmd) > 0) {
+        return true;
+    }
+    for (int i = 0; i < MAXLANE; i++) {
+        if (fifosize(&fLaneCmd[i]) > 0 && fLaneOwner[i] == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void TThreadCmdManager::RunAux()
+{
+    TCmd* cmd;
+    bool run;
+
+    TTraceRecorder::SetThreadName("Command manager");
+    do {
+        run = false;
+        while ((cmd = (TCmd*) fifoget(&fRunningCmd))) {
+            RunCmd(cmd);
+            run = true;
+        }
+        for (int i = 0; i < MAXLANE; i++) {
+            run |= RunLane(i);
+        }
+    } while (run);
 }
 
 TThreadCmdManager::TThreadCmdManager(long thread_num)
@@ -94,6 +152,10 @@ TThreadCmdManager::TThreadCmdManager(long thread_num)
         }
     }
 	fifoinit(&fRunningCmd);
+    for (i = 0; i < MAXLANE; i++) {
+        fifoinit(&fLaneCmd[i]);
+        fLaneOwner[i] = 0;
+    }
 
 #if defined(__APPLE__) || defined(linux)
 	struct sched_param param;
@@ -125,14 +187,14 @@ TThreadCmdManager::~TThreadCmdManager()
     pthread_cond_broadcast(&fCond);
     pthread_mutex_unlock(&fLock);
 #elif WIN32
-    fifoput(&fRunningCmd, (fifocell*)cmd);
     SetEvent(fCond);
 #endif
     
     // Wait for thread exit
     for (unsigned int i = 0; i < fThreadList.size(); i++) {
 	#if defined(__APPLE__) || defined(linux)
-        pthread_cancel(fThreadList[i]);
+        // Threads exit their loop after the broadcast: cancelling a thread waiting
+        // on the condition would make it exit with the lock held
         pthread_join(fThreadList[i], NULL); 
     #elif WIN32
 		TerminateThread(fThreadList[i],0);
@@ -157,6 +219,14 @@ TThreadCmdManager::~TThreadCmdManager()
         free(cmd);
         cmd = next;
     }
+    for (int i = 0; i < MAXLANE; i++) {
+        cmd = (TCmd*)fifoflush(&fLaneCmd[i]);
+        while (cmd) {
+            next = cmd->link;
+            free(cmd);
+            cmd = next;
+        }
+    }
 }
 
 void TThreadCmdManager::FlushCmds()
@@ -166,9 +236,24 @@ void TThreadCmdManager::FlushCmds()
     while ((cmd = (TCmd*) fifoget(&fRunningCmd))) {
         lfpush(&fFreeCmd, (lifocell*)cmd);
     }
+    for (int i = 0; i < MAXLANE; i++) {
+        while ((cmd = (TCmd*) fifoget(&fLaneCmd[i]))) {
+            lfpush(&fFreeCmd, (lifocell*)cmd);
+        }
+    }
 }
 
 void TThreadCmdManager::ExecCmdAux(CmdPtr fun, long arg1, long arg2, long arg3, long arg4, long arg5)
+{
+    PutCmd(&fLaneCmd[GetLane(arg1)], fun, arg1, arg2, arg3, arg4, arg5);
+}
+
+void TThreadCmdManager::ExecParallelCmdAux(CmdPtr fun, long arg1, long arg2, long arg3, long arg4, long arg5)
+{
+    PutCmd(&fRunningCmd, fun, arg1, arg2, arg3, arg4, arg5);
+}
+
+void TThreadCmdManager::PutCmd(fifo* ff, CmdPtr fun, long arg1, long arg2, long arg3, long arg4, long arg5)
 {
     // Get a command structure from the free command list
     // fills it and push it on the running list
@@ -181,18 +266,20 @@ void TThreadCmdManager::ExecCmdAux(CmdPtr fun, long arg1, long arg2, long arg3,
         cmd->arg3 = arg3;
         cmd->arg4 = arg4;
         cmd->arg5 = arg5;
+        TTraceRecorder::FlowStart("Command", (long)cmd);
 	// Signal the condition to wake the thread
 	#if defined(__APPLE__) || defined(linux)      
         pthread_mutex_lock(&fLock);
-        fifoput(&fRunningCmd, (fifocell*)cmd);
+        fifoput(ff, (fifocell*)cmd);
         pthread_cond_signal(&fCond);
         pthread_mutex_unlock(&fLock);
 	#elif WIN32
-		fifoput(&fRunningCmd, (fifocell*)cmd);
+		fifoput(ff, (fifocell*)cmd);
 		SetEvent(fCond);
 	#endif
     } else {
-        printf("Error : empty cmd lifo\n");
+        TTraceRecorder::Instant("Command lost", (void*)fun);
+        TAudioLog::Log("Error : empty cmd lifo\n");
     }
 }
 
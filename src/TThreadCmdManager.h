@@ -60,6 +60,7 @@ typedef struct TCmd
 }TCmd;
 
 #define MAXCOMMAND 256
+#define MAXLANE 64
 
 //-------------------------
 // Class TThreadCmdManager
@@ -165,6 +166,13 @@ That's why it is highly discouraged.
 --Jim
 */
 
+/*
+Commands working on the same object (same first argument) go to the same lane: a lane is run by a single
+thread at a time, so that the commands of a stream (Acquire, ReadBuffer, Release...) never race and
+are run in the order they were issued. Commands on different objects run in parallel in the threads.
+Parallel commands (ExecParallelCmd) go to a common fifo run by all threads.
+*/
+
 /*
 Voir aussi: technique utilise dans jack samples capture_client.c 
 */
@@ -175,9 +183,21 @@ class TThreadCmdManager : public TCmdManager
     private:
 
 	    lifo fFreeCmd;      // Commands free list
-        fifo fRunningCmd;   // Running commands
+        fifo fRunningCmd;   // Running parallel commands
+        fifo fLaneCmd[MAXLANE];                 // Running commands, by object
+        volatile long fLaneOwner[MAXLANE];      // 1 when a thread runs the lane commands
         bool fRunning;
 
+        static long GetLane(long a1)
+        {
+            return long((unsigned long)a1 / sizeof(void*) % MAXLANE);
+        }
+
+        void PutCmd(fifo* ff, CmdPtr fun, long a1, long a2, long a3, long a4, long a5);
+        void RunCmd(TCmd* cmd);
+        bool RunLane(long lane);
+        bool Runnable();
+
 	#if defined(__APPLE__) || defined(linux)
 		std::vector<pthread_t> fThreadList; // Execution thread
 		pthread_mutex_t fLock;  // Mutex
@@ -195,8 +215,13 @@ class TThreadCmdManager : public TCmdManager
         ~TThreadCmdManager();
 
         void ExecCmdAux(CmdPtr fun, long a1, long a2, long a3, long a4, long a5);
+        void ExecParallelCmdAux(CmdPtr fun, long a1, long a2, long a3, long a4, long a5);
         void RunAux();
         void FlushCmds();
+        long GetThreadCount()
+        {
+            return long(fThreadList.size());
+        }
 };
 
 typedef TThreadCmdManager * TThreadCmdManagerPtr;
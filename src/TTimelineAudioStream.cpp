@@ -0,0 +1,270 @@
+/*
+
+Copyright (C) Grame 2002-2013
+
+This library is free software; you can redistribute it and modify it under
+the terms of the GNU Library General Public License as published by the
+Free Software Foundation version 2 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public License
+for more details.
+
+You should have received a copy of the GNU Library General Public License
+along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+Grame Research Laboratory, 9, rue du Garet 69001 Lyon - France
+research@grame.fr
+
+*/
+
+#include "TTimelineAudioStream.h"
+#include "TScratchArena.h"
+#include "TPrefetchHandler.h"
+#include "TAudioLog.h"
+#include "UTools.h"
+#include "msAtomic.h"
+#include <algorithm>
+#include <limits.h>
+#include <stdio.h>
+#include <assert.h>
+
+static bool CompareStart(const TTimelineClip& clip1, const TTimelineClip& clip2)
+{
+    return clip1.fStart < clip2.fStart;
+}
+
+TTimelineIndex::TTimelineIndex(const std::vector<TTimelineClip>& clips): fClips(clips), fChannels(0)
+{
+    std::stable_sort(fClips.begin(), fClips.end(), CompareStart);
+
+    long end = 0;
+    for (unsigned int i = 0; i < fClips.size(); i++) {
+        end = UTools::Max(end, fClips[i].fStart + fClips[i].fLength);
+        fMaxEnd.push_back(end);
+        fChannels = UTools::Max(fChannels, fClips[i].fClip->Channels());
+    }
+}
+
+// fMaxEnd is sorted: binary search of the first clip ending after pos
+long TTimelineIndex::Find(long pos)
+{
+    return long(std::upper_bound(fMaxEnd.begin(), fMaxEnd.end(), pos) - fMaxEnd.begin());
+}
+
+TTimelineAudioStream::TTimelineAudioStream(TTimelineIndexPtr index, long begin, long lookahead): fIndex(index)
+{
+    fBegin = UTools::Max(0, begin);
+    fLookahead = (lookahead > 0) ? lookahead : fContext->fStreamBufferSize;
+    fCurFrame = 0;
+    fLiveCount = 0;
+
+    fReadyRead = 0;
+    fReadyWrite = 0;
+    fDoneRead = 0;
+    fDoneWrite = 0;
+
+    fNext = fIndex->Find(fBegin);
+    fInstances = 0;
+    fNextStart = 0;
+    fLimit = fBegin + fLookahead;
+
+    fGeneration = 0;
+    fFilledGeneration = 0;
+    fQueued = 0;
+
+    // Prime the ready ring directly
+    Fill();
+}
+
+TTimelineAudioStream::~TTimelineAudioStream()
+{
+    // A queued fill command holds a reference, so none is pending here
+    for (unsigned long i = fReadyRead; i != fReadyWrite; i++) {
+        fReady[i & (kVoices - 1)].fStream->removeReference();
+    }
+    for (unsigned long i = fDoneRead; i != fDoneWrite; i++) {
+        fDone[i & (kVoices - 1)]->removeReference();
+    }
+    for (long i = 0; i < fLiveCount; i++) {
+        fLive[i].fStream->removeReference();
+    }
+}
+
+// Callback called by command manager, the command holds a reference on the stream
+void TTimelineAudioStream::FillAux(TTimelineAudioStreamPtr obj, long u1, long u2, long u3, long u4)
+{
+    obj->Fill();
+    CAS(&obj->fQueued, (void*)1, (void*)0);
+    // May delete the stream in this thread
+    obj->removeReference();
+}
+
+// Called in the command manager thread, or directly when no fill is queued
+void TTimelineAudioStream::Fill()
+{
+    long generation = fGeneration;
+    // Instances are built in the context of the timeline
+    TAudioContextScope scope(fContext);
+
+    // Flush: Read does not touch the ready ring until the new generation is published
+    if (generation != fFilledGeneration) {
+        for (unsigned long i = fReadyRead; i != fReadyWrite; i++) {
+            fReady[i & (kVoices - 1)].fStream->removeReference();
+            fInstances--;
+        }
+        msAtomicSet(&fReadyWrite, fReadyRead);
+        fNext = fIndex->Find(fBegin);
+    }
+
+    // Release the finished instances
+    while (fDoneRead != fDoneWrite) {
+        fDone[fDoneRead & (kVoices - 1)]->removeReference();
+        msAtomicSet(&fDoneRead, fDoneRead + 1);
+        fInstances--;
+    }
+
+    // Instantiate the clips entering the lookahead window, the alive instances always fit in the done ring
+    while (generation == fGeneration && fNext < fIndex->GetCount() && fInstances < kVoices) {
+        const TTimelineClip& clip = fIndex->GetClip(fNext);
+        if (clip.fStart >= long(fLimit)) {
+            break;
+        }
+        // Clips before fNext may already be finished at fBegin
+        if (clip.fStart + clip.fLength > fBegin) {
+            try {
+                TAudioStreamPtr stream = (clip.fStart < fBegin) ? clip.fClip->CutBegin(fBegin - clip.fStart) : clip.fClip->Copy();
+                if (stream) {
+                    // No manager yet: the beginning of the instance is acquired here
+                    TScratchPlanner::Plan(stream);
+                    TPrefetcher::Prefetch(stream, fContext->GetHorizon());
+                    stream->addReference();
+                    fInstances++;
+                    TTimelineVoice& voice = fReady[fReadyWrite & (kVoices - 1)];
+                    voice.fStream = stream;
+                    voice.fIndex = fNext;
+                    msAtomicSet(&fReadyWrite, fReadyWrite + 1);
+                }
+            } catch (int n) {
+                TAudioLog::Log("TTimelineAudioStream::Fill exception %d \n", n);
+            }
+        }
+        fNext++;
+    }
+
+    msAtomicSet(&fNextStart, (fNext < fIndex->GetCount()) ? fIndex->GetClip(fNext).fStart : LONG_MAX);
+
+    long filled = fFilledGeneration;
+    if (generation != filled) {
+        CAS(&fFilledGeneration, (void*)filled, (void*)generation);
+    }
+}
+
+void TTimelineAudioStream::Request()
+{
+    // No manager: the rings are never filled in the audio thread
+    if (!fManager) {
+        fContext->AddDiskError();
+    } else if (CAS(&fQueued, (void*)0, (void*)1)) {
+        addReference();
+        fManager->ExecCmd((CmdPtr)FillAux, (long)this, 0, 0, 0, 0);
+    }
+}
+
+// Give a finished instance back to the fill thread
+void TTimelineAudioStream::Release(TAudioStream* stream)
+{
+    // At most kVoices instances are alive
+    assert(fDoneWrite - fDoneRead < kVoices);
+    fDone[fDoneWrite & (kVoices - 1)] = stream;
+    msAtomicSet(&fDoneWrite, fDoneWrite + 1);
+}
+
+long TTimelineAudioStream::Read(FLOAT_BUFFER buffer, long framesNum, long framePos, long channels)
+{
+    long res = UTools::Min(framesNum, Length() - fCurFrame);
+    if (res <= 0) {
+        return 0;
+    }
+
+    // Ready ring is being flushed and primed again
+    if (fFilledGeneration != fGeneration) {
+        Request();
+        if (fFilledGeneration != fGeneration) {
+            fContext->AddDiskError();
+            return res;
+        }
+    }
+
+    long pos = fBegin + fCurFrame;
+
+    // Start the clips beginning in this block
+    while (fLiveCount < kVoices && fReadyRead != fReadyWrite) {
+        TTimelineVoice voice = fReady[fReadyRead & (kVoices - 1)];
+        long start = UTools::Max(fIndex->GetClip(voice.fIndex).fStart, fBegin);
+        if (start >= pos + res) {
+            break;
+        }
+        msAtomicSet(&fReadyRead, fReadyRead + 1);
+        // Instantiated too late: the clip is played delayed
+        if (start < pos) {
+            fContext->AddDiskError();
+        }
+        TCmdHandler::SetTreeManager(voice.fStream, fManager);
+        voice.fStart = UTools::Max(start, pos);
+        fLive[fLiveCount++] = voice;
+    }
+
+    // Mix the playing clips, a finished clip is removed by swapping it with the last one
+    for (long i = 0; i < fLiveCount;) {
+        long offset = UTools::Max(0, fLive[i].fStart - pos);
+        long frames = res - offset;
+        if (fLive[i].fStream->Read(buffer, frames, framePos + offset, channels) < frames) {
+            Release(fLive[i].fStream);
+            fLive[i] = fLive[--fLiveCount];
+        } else {
+            i++;
+        }
+    }
+
+    fCurFrame += res;
+
+    // Instantiate ahead and release finished clips in the fill thread
+    msAtomicSet(&fLimit, fBegin + fCurFrame + fLookahead);
+    if (long(fNextStart) < long(fLimit) || fDoneRead != fDoneWrite) {
+        Request();
+    }
+
+    return res;
+}
+
+void TTimelineAudioStream::Reset()
+{
+    // The ready ring already starts at the beginning of the timeline
+    if (fCurFrame == 0) {
+        return;
+    }
+
+    for (long i = 0; i < fLiveCount; i++) {
+        Release(fLive[i].fStream);
+    }
+    fLiveCount = 0;
+
+    long generation = fGeneration;
+    CAS(&fGeneration, (void*)generation, (void*)(generation + 1));
+    fCurFrame = 0;
+    msAtomicSet(&fLimit, fBegin + fLookahead);
+    Request();
+}
+
+TAudioStreamPtr TTimelineAudioStream::CutBegin(long frames)
+{
+    return new TTimelineAudioStream(fIndex, fBegin + frames, fLookahead);
+}
+
+TAudioStreamPtr TTimelineAudioStream::Copy()
+{
+    return new TTimelineAudioStream(fIndex, fBegin, fLookahead);
+}
@@ -0,0 +1,188 @@
+/*
+
+Copyright (C) Grame 2002-2013
+
+This library is free software; you can redistribute it and modify it under
+the terms of the GNU Library General Public License as published by the
+Free Software Foundation version 2 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public License
+for more details.
+
+You should have received a copy of the GNU Library General Public License
+along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+Grame Research Laboratory, 9, rue du Garet 69001 Lyon - France
+research@grame.fr
+
+*/
+
+#ifndef __TTimelineAudioStream__
+#define __TTimelineAudioStream__
+
+#include "TAudioStream.h"
+#include "TCmdHandler.h"
+#include "la_smartpointer.h"
+#include "UTools.h"
+#include <vector>
+
+//---------------------
+// Class TTimelineClip
+//---------------------
+/*!
+\brief A clip scheduled on a timeline.
+*/
+
+struct TTimelineClip
+{
+    long fStart;                // Start in frames on the timeline
+    long fLength;               // Length in frames
+    TAudioStreamPtr fClip;      // Model stream, never read: played instances are copies
+
+    TTimelineClip(long start, TAudioStreamPtr clip): fStart(start), fLength(clip->Length()), fClip(clip)
+    {}
+};
+
+//----------------------
+// Class TTimelineIndex
+//----------------------
+/*!
+\brief A sorted interval index of clips, shared by the timeline streams built from it.
+*/
+
+class TTimelineIndex : public la_smartable
+{
+
+    private:
+
+        std::vector<TTimelineClip> fClips;  // Sorted by start
+        std::vector<long> fMaxEnd;          // Max end of clips [0, i]
+        long fChannels;
+
+    public:
+
+        TTimelineIndex(const std::vector<TTimelineClip>& clips);
+        virtual ~TTimelineIndex()
+        {}
+
+        // Index of the first clip that may be playing at frame pos
+        long Find(long pos);
+
+        const TTimelineClip& GetClip(long index)
+        {
+            return fClips[index];
+        }
+        long GetCount()
+        {
+            return long(fClips.size());
+        }
+        long Length()
+        {
+            return (fMaxEnd.size() > 0) ? fMaxEnd.back() : 0;
+        }
+        long Channels()
+        {
+            return fChannels;
+        }
+};
+
+typedef LA_SMARTP<TTimelineIndex> TTimelineIndexPtr;
+
+//----------------------------
+// Class TTimelineAudioStream
+//----------------------------
+/*!
+\brief A TTimelineAudioStream plays clips scheduled at given start frames.
+*/
+
+/*
+Clips are kept as models in a TTimelineIndex. A played instance of a clip is built (Copy or CutBegin)
+by the command manager threads only when the clip comes within the lookahead window, and released
+there after it is finished: the audio thread only reads the currently playing clips, whatever the total
+number of clips is.
+
+Instances go from the fill thread to the audio thread through the single producer/single consumer
+"ready" ring, and come back through the "done" ring to be released. As with TAsyncAudioStream, at most
+one fill command is queued at a time and a Reset increments a generation counter.
+The fill thread builds a new instance only while less than kVoices instances are alive (ready, playing
+or done), so the done ring never fills up and the audio thread never releases an instance itself.
+Releasing an instance may delete it in the fill thread: the stream destructors never wait on another
+thread, and a queued fill command holds a reference on the timeline for the same reason.
+
+The fill commands need a command manager: without one (stream not rendered by a renderer), a request
+is dropped and counted as a disk error, the audio thread never fills the rings synchronously.
+
+CutBegin and Copy share the index, the beginning clips are found with a binary search.
+*/
+
+class TTimelineAudioStream : public TAudioStream, public TCmdHandler
+{
+
+    private:
+
+        enum { kVoices = 256 };     // Max number of clips playing or ready to play
+
+        struct TTimelineVoice
+        {
+            TAudioStream* fStream;  // Instance, referenced
+            long fIndex;            // Clip index
+            long fStart;            // Timeline frame where the instance starts
+        };
+
+        TTimelineIndexPtr fIndex;
+        long fBegin;                // Timeline frame played at fCurFrame = 0
+        long fLookahead;            // Instantiation distance in frames
+        long fCurFrame;
+
+        TTimelineVoice fLive[kVoices];              // Audio thread only
+        long fLiveCount;
+
+        TTimelineVoice fReady[kVoices];
+        volatile unsigned long fReadyRead;          // Written by the audio thread only
+        volatile unsigned long fReadyWrite;         // Written by the fill thread only
+
+        TAudioStream* fDone[kVoices];
+        volatile unsigned long fDoneRead;           // Written by the fill thread only
+        volatile unsigned long fDoneWrite;          // Written by the audio thread only
+
+        long fNext;                                 // Next clip to instantiate, fill thread only
+        long fInstances;                            // Instances ready, playing or done, fill thread only
+        volatile unsigned long fNextStart;          // Start of the next clip to instantiate
+        volatile unsigned long fLimit;              // Instantiate clips starting before this frame
+
+        volatile long fGeneration;                  // Incremented by Reset
+        volatile long fFilledGeneration;            // Generation the ready ring content belongs to
+        volatile long fQueued;                      // 1 when a fill command is queued or running
+
+        static void FillAux(TTimelineAudioStream* obj, long u1, long u2, long u3, long u4);
+
+        void Fill();
+        void Request();
+        void Release(TAudioStream* stream);
+
+    public:
+
+        TTimelineAudioStream(TTimelineIndexPtr index, long begin, long lookahead);
+        virtual ~TTimelineAudioStream();
+
+        long Read(FLOAT_BUFFER buffer, long framesNum, long framePos, long channels);
+
+        void Reset();
+        TAudioStreamPtr CutBegin(long frames);
+        long Length()
+        {
+            return UTools::Max(0, fIndex->Length() - fBegin);
+        }
+        long Channels()
+        {
+            return fIndex->Channels();
+        }
+        TAudioStreamPtr Copy();
+};
+
+typedef TTimelineAudioStream * TTimelineAudioStreamPtr;
+
+#endif
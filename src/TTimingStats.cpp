@@ -0,0 +1,93 @@
+/*
+
+Copyright (C) Grame 2002-2013
+
+This library is free software; you can redistribute it and modify it under
+the terms of the GNU Library General Public License as published by the
+Free Software Foundation version 2 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public License
+for more details.
+
+You should have received a copy of the GNU Library General Public License
+along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+Grame Research Laboratory, 9, rue du Garet 69001 Lyon - France
+research@grame.fr
+
+*/
+
+#include "TTimingStats.h"
+#include <math.h>
+
+long TTimingStats::Log2Bin(double usec)
+{
+    long bin = 0;
+    while (usec >= 2.0 && bin < TIMING_BINS - 1) {
+        usec *= 0.5;
+        bin++;
+    }
+    return bin;
+}
+
+void TTimingStats::AddCallback(double duration, double period)
+{
+    double load = (period > 0) ? (duration * 100.0 / period) : 0;
+    long bin = long(load / 10.0);
+
+    fCallbacks++;
+    if (duration > period) {
+        fDeadlineMisses++;
+    }
+    fLoadSum += load;
+    if (load > fMaxLoad) {
+        fMaxLoad = load;
+    }
+    if (duration > fMaxDuration) {
+        fMaxDuration = duration;
+    }
+    fDurationHistogram[Log2Bin(duration * 1000000.0)]++;
+    fLoadHistogram[(bin < TIMING_BINS) ? bin : TIMING_BINS - 1]++;
+}
+
+void TTimingStats::AddInterval(double interval, double period)
+{
+    double jitter = fabs(interval - period);
+    if (jitter > fMaxJitter) {
+        fMaxJitter = jitter;
+    }
+    fJitterHistogram[Log2Bin(jitter * 1000000.0)]++;
+}
+
+void TTimingStats::Reset()
+{
+    fCallbacks = 0;
+    fDeadlineMisses = 0;
+    fLoadSum = 0;
+    fMaxLoad = 0;
+    fMaxDuration = 0;
+    fMaxJitter = 0;
+    for (long i = 0; i < TIMING_BINS; i++) {
+        fDurationHistogram[i] = 0;
+        fLoadHistogram[i] = 0;
+        fJitterHistogram[i] = 0;
+    }
+}
+
+void TTimingStats::Get(TimingStatsPtr stats)
+{
+    stats->fCallbacks = fCallbacks;
+    stats->fDeadlineMisses = fDeadlineMisses;
+    stats->fMeanLoad = (fCallbacks > 0) ? float(fLoadSum / double(fCallbacks)) : 0.f;
+    stats->fMaxLoad = float(fMaxLoad);
+    stats->fMaxDurationUsec = float(fMaxDuration * 1000000.0);
+    stats->fMaxJitterUsec = float(fMaxJitter * 1000000.0);
+    for (long i = 0; i < TIMING_BINS; i++) {
+        stats->fDurationHistogram[i] = fDurationHistogram[i];
+        stats->fLoadHistogram[i] = fLoadHistogram[i];
+        stats->fJitterHistogram[i] = fJitterHistogram[i];
+    }
+}
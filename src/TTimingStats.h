@@ -0,0 +1,92 @@
+/*
+
+Copyright (C) Grame 2002-2013
+
+This library is free software; you can redistribute it and modify it under
+the terms of the GNU Library General Public License as published by the
+Free Software Foundation version 2 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public License
+for more details.
+
+You should have received a copy of the GNU Library General Public License
+along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+Grame Research Laboratory, 9, rue du Garet 69001 Lyon - France
+research@grame.fr
+
+*/
+
+#ifndef __TTimingStats__
+#define __TTimingStats__
+
+#define TIMING_BINS 20
+
+typedef struct TimingStats * TimingStatsPtr;
+/*!
+\brief Audio callback timing statistics.
+*/
+typedef struct TimingStats {
+    long fCallbacks;                        // Number of measured callbacks
+    long fDeadlineMisses;                   // Callbacks longer than the buffer period
+    float fMeanLoad;                        // Mean DSP load in percent of the buffer period
+    float fMaxLoad;                         // Maximum DSP load in percent of the buffer period
+    float fMaxDurationUsec;                 // Maximum callback duration in microsecond
+    float fMaxJitterUsec;                   // Maximum distance between callback intervals and the buffer period
+    long fDurationHistogram[TIMING_BINS];   // Bin i counts durations in [2^i, 2^(i+1)[ microseconds (the first and last bins are open)
+    long fLoadHistogram[TIMING_BINS];       // Bin i counts loads in [10 * i, 10 * (i+1)[ percent (the last bin is open)
+    long fJitterHistogram[TIMING_BINS];     // Bin i counts jitters in [2^i, 2^(i+1)[ microseconds (the first and last bins are open)
+} TimingStats;
+
+//--------------------
+// Class TTimingStats
+//--------------------
+/*!
+\brief Timing statistics of an audio callback, updated by the audio thread.
+*/
+
+/*
+The audio thread is the only writer: counters are plain integers, readers copy them without locking
+(a copy taken while a callback is measured may mix two consecutive callbacks).
+*/
+
+class TTimingStats
+{
+
+    private:
+
+        long fCallbacks;
+        long fDeadlineMisses;
+        double fLoadSum;
+        double fMaxLoad;
+        double fMaxDuration;
+        double fMaxJitter;
+        long fDurationHistogram[TIMING_BINS];
+        long fLoadHistogram[TIMING_BINS];
+        long fJitterHistogram[TIMING_BINS];
+
+        static long Log2Bin(double usec);
+
+    public:
+
+        TTimingStats()
+        {
+            Reset();
+        }
+        virtual ~TTimingStats()
+        {}
+
+        // Durations in seconds, called in the audio thread
+        void AddCallback(double duration, double period);
+        void AddInterval(double interval, double period);
+
+        void Reset();
+        void Get(TimingStatsPtr stats);
+};
+
+typedef TTimingStats * TTimingStatsPtr;
+
+#endif
@@ -0,0 +1,156 @@
+/*
+
+Copyright (C) Grame 2002-2013
+
+This library is free software; you can redistribute it and modify it under
+the terms of the GNU Library General Public License as published by the
+Free Software Foundation version 2 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public License
+for more details.
+
+You should have received a copy of the GNU Library General Public License
+along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+Grame Research Laboratory, 9, rue du Garet 69001 Lyon - France
+research@grame.fr
+
+*/
+
+#include "TTraceRecorder.h"
+#include "msAtomic.h"
+#include <stdio.h>
+
+TTraceBuffer TTraceRecorder::fBuffers[kThreads];
+volatile long TTraceRecorder::fThreadCount = 0;
+volatile long TTraceRecorder::fDroppedThreads = 0;
+volatile long TTraceRecorder::fSession = 0;
+volatile bool TTraceRecorder::fEnabled = false;
+double TTraceRecorder::fStart = 0;
+CONTEXT_THREAD TTraceBufferPtr TTraceRecorder::fBuffer = 0;
+CONTEXT_THREAD long TTraceRecorder::fBufferSession = 0;
+
+// Claim a ring for the calling thread once per session, NULL if they are all used
+TTraceBufferPtr TTraceRecorder::GetBuffer()
+{
+    long session = fSession;
+    if (fBufferSession != session) {
+        long index;
+        fBufferSession = session;
+        fBuffer = 0;
+        do {
+            index = fThreadCount;
+            if (index >= kThreads) {
+                msAtomicAdd(&fDroppedThreads, 1);
+                return 0;
+            }
+        } while (!CAS(&fThreadCount, (void*)index, (void*)(index + 1)));
+        fBuffer = &fBuffers[index];
+    }
+    return fBuffer;
+}
+
+void TTraceRecorder::Record(char phase, const char* name, double time, double duration, long id, void* arg)
+{
+    TTraceBufferPtr buffer = GetBuffer();
+    if (buffer && buffer->fEvents) {
+        TTraceEvent& event = buffer->fEvents[buffer->fWrite & (buffer->fSize - 1)];
+        event.fTime = time;
+        event.fDuration = duration;
+        event.fName = name;
+        event.fId = id;
+        event.fArg = arg;
+        event.fPhase = phase;
+        buffer->fWrite++;
+    }
+}
+
+void TTraceRecorder::Start(long events)
+{
+    long size = 1;
+    while (size < events) {
+        size <<= 1;
+    }
+
+    fEnabled = false;
+    for (long i = 0; i < kThreads; i++) {
+        if (!fBuffers[i].fEvents) {
+            fBuffers[i].fEvents = new TTraceEvent[size];
+            fBuffers[i].fSize = size;
+        }
+        fBuffers[i].fWrite = 0;
+        fBuffers[i].fName = 0;
+    }
+    // All rings are claimed again in the new session
+    fThreadCount = 0;
+    fDroppedThreads = 0;
+    fSession++;
+    fStart = UTools::GetTime();
+    fEnabled = true;
+}
+
+void TTraceRecorder::Stop()
+{
+    fEnabled = false;
+}
+
+long TTraceRecorder::Dump(const string& name)
+{
+    FILE* file = fopen(name.c_str(), "w");
+    long count = 0;
+
+    if (!file) {
+        printf("TTraceRecorder::Dump : cannot open %s\n", name.c_str());
+        return -1;
+    }
+
+    fprintf(file, "{\"traceEvents\":[\n");
+    long threads = UTools::Min(fThreadCount, kThreads);
+
+    for (long tid = 0; tid < threads; tid++) {
+        TTraceBufferPtr buffer = &fBuffers[tid];
+        if (buffer->fName) {
+            fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%ld,\"args\":{\"name\":\"%s\"}}",
+                    (count++ > 0) ? ",\n" : "", tid, buffer->fName);
+        }
+        if (!buffer->fEvents) {
+            continue;
+        }
+        unsigned long write = buffer->fWrite;
+        unsigned long from = (write > (unsigned long)buffer->fSize) ? write - buffer->fSize : 0;
+        for (unsigned long i = from; i < write; i++) {
+            TTraceEvent& event = buffer->fEvents[i & (buffer->fSize - 1)];
+            double ts = (event.fTime - fStart) * 1e6;
+            fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"%c\",\"pid\":1,\"tid\":%ld,\"ts\":%.3f",
+                    (count++ > 0) ? ",\n" : "", event.fName, event.fPhase, tid, ts);
+            switch (event.fPhase) {
+                case 'X':
+                    fprintf(file, ",\"dur\":%.3f", event.fDuration * 1e6);
+                    break;
+                case 'i':
+                    fprintf(file, ",\"s\":\"t\"");
+                    break;
+                case 's':
+                    fprintf(file, ",\"cat\":\"cmd\",\"id\":%ld", event.fId);
+                    break;
+                case 'f':
+                    fprintf(file, ",\"cat\":\"cmd\",\"id\":%ld,\"bp\":\"e\"", event.fId);
+                    break;
+            }
+            if (event.fArg) {
+                fprintf(file, ",\"args\":{\"arg\":\"%p\"}", event.fArg);
+            }
+            fprintf(file, "}");
+        }
+    }
+
+    fprintf(file, "\n],\"otherData\":{\"droppedThreads\":\"%ld\"}}\n", fDroppedThreads);
+    if (fDroppedThreads > 0) {
+        printf("TTraceRecorder::Dump : %ld threads not recorded\n", fDroppedThreads);
+    }
+    fclose(file);
+    return count;
+}
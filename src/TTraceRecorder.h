@@ -0,0 +1,170 @@
+/*
+
+Copyright (C) Grame 2002-2013
+
+This library is free software; you can redistribute it and modify it under
+the terms of the GNU Library General Public License as published by the
+Free Software Foundation version 2 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public License
+for more details.
+
+You should have received a copy of the GNU Library General Public License
+along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+Grame Research Laboratory, 9, rue du Garet 69001 Lyon - France
+research@grame.fr
+
+*/
+
+#ifndef __TTraceRecorder__
+#define __TTraceRecorder__
+
+#include "TAudioContext.h"
+#include "UTools.h"
+#include <string>
+
+using namespace std;
+
+//--------------------
+// Struct TTraceEvent
+//--------------------
+/*!
+\brief A recorded event, names are static strings.
+*/
+
+typedef struct TTraceEvent
+{
+    double fTime;           // Start time in seconds
+    double fDuration;       // For complete events
+    const char* fName;
+    long fId;               // Flow id, or 0
+    void* fArg;
+    char fPhase;            // Chrome trace phase: 'X' complete, 'i' instant, 's' and 'f' flow start and end
+} TTraceEvent;
+
+//--------------------
+// Class TTraceBuffer
+//--------------------
+/*!
+\brief The events of one thread.
+*/
+
+class TTraceBuffer
+{
+
+    public:
+
+        TTraceEvent* fEvents;
+        long fSize;                 // Power of two
+        volatile unsigned long fWrite;
+        const char* fName;          // Thread name
+
+        TTraceBuffer(): fEvents(0), fSize(0), fWrite(0), fName(0)
+        {}
+        virtual ~TTraceBuffer()
+        {
+            delete [] fEvents;
+        }
+};
+
+typedef TTraceBuffer * TTraceBufferPtr;
+
+//---------------------
+// Class TTraceRecorder
+//---------------------
+/*!
+\brief Records the activity of the audio and command manager threads, and dumps it as a Chrome trace.
+*/
+
+/*
+Each thread writes its events in its own ring without locking: the first event of a thread claims
+one of the kThreads preallocated rings with a CAS, then the thread only touches its ring, older events
+being overwritten when it is full. Recording costs a flag test when tracing is off.
+
+Rings are allocated by the first Start and never freed. Each Start begins a new session and gives all
+rings back: a thread claims a ring again with its first event of the session, so that threads that
+have exited do not keep theirs. Threads finding no free ring are not recorded and are counted in the
+dump. Dump reads the rings without synchronization: it is exact once tracing is stopped, events written
+during the dump may be torn.
+
+The trace is written in the Chrome trace event JSON format (chrome://tracing, ui.perfetto.dev):
+audio callbacks and commands are complete events, commands are linked to the ExecCmd call that
+queued them with flow events, and disk errors are instant events.
+*/
+
+class TTraceRecorder
+{
+
+    private:
+
+        enum { kThreads = 32 };
+
+        static TTraceBuffer fBuffers[kThreads];
+        static volatile long fThreadCount;
+        static volatile long fDroppedThreads;   // Threads of the session without ring
+        static volatile long fSession;
+        static volatile bool fEnabled;
+        static double fStart;
+        static CONTEXT_THREAD TTraceBuffer* fBuffer;
+        static CONTEXT_THREAD long fBufferSession;  // Session of fBuffer
+
+        static TTraceBufferPtr GetBuffer();
+        static void Record(char phase, const char* name, double time, double duration, long id, void* arg);
+
+    public:
+
+        // Clear the previous events and start tracing, the size of the rings is set by the first call
+        static void Start(long events);
+        static void Stop();
+        static bool IsEnabled()
+        {
+            return fEnabled;
+        }
+
+        // Returns the number of written events, or a negative value if the file cannot be written
+        static long Dump(const string& name);
+
+        // Name the calling thread in the trace, the first name is kept
+        static void SetThreadName(const char* name)
+        {
+            if (fEnabled) {
+                TTraceBufferPtr buffer = GetBuffer();
+                if (buffer && !buffer->fName) {
+                    buffer->fName = name;
+                }
+            }
+        }
+
+        // A span of the calling thread
+        static void Complete(const char* name, double start, double end, void* arg)
+        {
+            if (fEnabled) {
+                Record('X', name, start, end - start, 0, arg);
+            }
+        }
+        static void Instant(const char* name, void* arg)
+        {
+            if (fEnabled) {
+                Record('i', name, UTools::GetTime(), 0, 0, arg);
+            }
+        }
+        // Links two events of different threads, the flow end binds to the span enclosing it
+        static void FlowStart(const char* name, long id)
+        {
+            if (fEnabled) {
+                Record('s', name, UTools::GetTime(), 0, id, 0);
+            }
+        }
+        static void FlowEnd(const char* name, long id, double time)
+        {
+            if (fEnabled) {
+                Record('f', name, time, 0, id, 0);
+            }
+        }
+};
+
+#endif
@@ -31,7 +31,7 @@ TTransformAudioStream::TTransformAudioStream(TAudioStreamPtr stream, TAudioEffec
     fStream = new TFadeAudioStream(new TSeqAudioStream(stream, new TNullAudioStream(fadeOut), fadeIn), fadeIn, fadeOut);
     fFadeIn = fadeIn;
     fFadeOut = fadeOut;
-	fBuffer = new TLocalAudioBuffer<float>(TAudioGlobals::fStreamBufferSize, TAudioGlobals::fOutput);
+    ReserveScratch();
 }
 
 TAudioStreamPtr TTransformAudioStream::CutBegin(long frames)
@@ -41,10 +41,13 @@ TAudioStreamPtr TTransformAudioStream::CutBegin(long frames)
 
 long TTransformAudioStream::Read(FLOAT_BUFFER buffer, long framesNum, long framePos, long channels)
 {
-	UAudioTools::ZeroFloatBlk(fBuffer->GetFrame(0), TAudioGlobals::fBufferSize, TAudioGlobals::fOutput);
-    long res = fStream->Read(fBuffer, framesNum, framePos, channels);
-    fEffectList->Process(fBuffer->GetFrame(framePos), framesNum, channels);
-	UAudioTools::MixFrameToFrameBlk1(buffer->GetFrame(framePos), fBuffer->GetFrame(framePos), framesNum, channels);
+    // View on the scratch buffer with the requested channel count
+    TSharedAudioBuffer<float> process(GetScratch(), fContext->fStreamBufferSize, channels);
+    
+	UAudioTools::ZeroFloatBlk(process.GetFrame(0), framesNum, channels);
+    long res = fStream->Read(&process, framesNum, 0, channels);
+    fEffectList->Process(process.GetFrame(0), framesNum, channels);
+	UAudioTools::MixFrameToFrameBlk1(buffer->GetFrame(framePos), process.GetFrame(0), framesNum, channels);
     return res;
 }
 
@@ -54,6 +57,12 @@ void TTransformAudioStream::Reset()
     fEffectList->Reset();
 }
 
+// Processing buffer
+long TTransformAudioStream::ScratchSize()
+{
+    return fContext->fStreamBufferSize * UTools::Max(fContext->fOutput, Channels());
+}
+
 TAudioStreamPtr TTransformAudioStream::Copy()
 {
     return new TTransformAudioStream(fStream->Copy(), fEffectList->Copy(), fFadeIn, fFadeOut);
@@ -25,6 +25,7 @@ research@grame.fr
 
 #include "TFadeAudioStream.h"
 #include "TAudioEffect.h"
+#include "UTools.h"
 
 //-----------------------------
 // Class TTransformAudioStream
@@ -33,7 +34,7 @@ research@grame.fr
 \brief  A TTransformAudioStream object will apply a list of sound effects on a stream.
 */
 
-class TTransformAudioStream : public TDecoratedAudioStream
+class TTransformAudioStream : public TDecoratedAudioStream, public TScratchHandler
 {
 
     private:
@@ -41,15 +42,12 @@ class TTransformAudioStream : public TDecoratedAudioStream
         TAudioEffectListPtr fEffectList;  	// Effect list
 		long fFadeIn;	// FadeIn time
         long fFadeOut;	// FadeOut time
-		FLOAT_BUFFER fBuffer;
 
     public:
 
         TTransformAudioStream(TAudioStreamPtr stream, TAudioEffectListPtr effect, long fadeIn, long fadeOut);
         virtual ~TTransformAudioStream()
-        {
-    		delete fBuffer;
-        }
+        {}
 
         virtual long Write(FLOAT_BUFFER buffer, long framesNum, long framePos, long channels)
         {
@@ -60,6 +58,18 @@ class TTransformAudioStream : public TDecoratedAudioStream
         void Reset();
         TAudioStreamPtr CutBegin(long frames);    // Length in frames
         TAudioStreamPtr Copy();
+        long ScratchSize();
+
+        TAudioEffectListPtr GetEffectList()
+        {
+            return fEffectList;
+        }
+        
+        // Effects may need more channels than the decorated stream provides
+        long Channels()
+        {
+            return UTools::Max(fStream->Channels(), fEffectList->Channels());
+        }
 };
 
 typedef TTransformAudioStream * TTransformAudioStreamPtr;
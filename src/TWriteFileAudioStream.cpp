@@ -21,10 +21,10 @@ research@grame.fr
 */
 
 #include "TWriteFileAudioStream.h"
-#include "TAudioGlobals.h"
 #include "UAudioTools.h"
 #include "UTools.h"
 #include "StringTools.h"
+#include "TAudioLog.h"
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
@@ -33,7 +33,7 @@ TWriteFileAudioStream::TWriteFileAudioStream(string name, TAudioStreamPtr stream
         : TFileAudioStream(name)
 {
     fChannels = stream->Channels();
-    fMemoryBuffer = new TLocalAudioBuffer<short>(TAudioGlobals::fStreamBufferSize, fChannels);
+    fMemoryBuffer = new TLocalAudioBuffer<short>(fContext->fStreamBufferSize, fChannels);
     fStream = stream;
     fFormat = format;
     fFramesNum = fStream->Length();
@@ -52,7 +52,7 @@ void TWriteFileAudioStream::Open()
 {
 	if (fFile == 0) {
 		SF_INFO info;
-		info.samplerate = TAudioGlobals::fSampleRate;
+		info.samplerate = fContext->fSampleRate;
 		info.channels = fChannels;
 		info.format = fFormat;
 		char utf8name[512] = {0};
@@ -91,7 +91,7 @@ long TWriteFileAudioStream::Read(FLOAT_BUFFER buffer, long framesNum, long frame
     TBufferedAudioStream::Write(buffer, framesNum, framePos, channels); // Write on disk
 	if (res < framesNum) {
         if (fManager == 0) {
-            printf("Error : stream rendered without command manager\n");
+            TAudioLog::Log("Error : stream rendered without command manager\n");
         }
 		assert(fManager);
 		fManager->ExecCmd((CmdPtr)CloseAux, (long)this, 0, 0, 0, 0);
@@ -37,6 +37,99 @@ research@grame.fr
 #include <Accelerate/Accelerate.h>
 #endif
 
+//-------------------
+// Class TFrameKernel
+//-------------------
+/*!
+\brief Per frame mixing kernels, templated on the channel count so that the inner channel loop is fully unrolled.
+CHANNELS = 0 is the generic version that uses the runtime channel count. Channels are processed by (left, right) pairs,
+an odd last channel uses the left gains.
+*/
+
+template <int CHANNELS>
+struct TFrameKernel
+{
+    static inline long Count(long channels)
+    {
+        return (CHANNELS > 0) ? CHANNELS : channels;
+    }
+
+    static inline void MixGain(float* dst, float* src, long framesNum, long channels, float leftamp, float rightamp)
+    {
+        long n = Count(channels);
+        for (long i = 0; i < framesNum; i++, dst += n, src += n) {
+            long j = 0;
+            for (; j + 1 < n; j += 2) {
+                dst[j] += (src[j] * leftamp);
+                dst[j + 1] += (src[j + 1] * rightamp);
+            }
+            if (j < n) {
+                dst[j] += (src[j] * leftamp);
+            }
+        }
+    }
+
+    static inline void MixMatrix(float* dst, float* src, long framesNum, long channels, float leftamp_L, float rightamp_L, float leftamp_R, float rightamp_R)
+    {
+        long n = Count(channels);
+        for (long i = 0; i < framesNum; i++, dst += n, src += n) {
+            long j = 0;
+            for (; j + 1 < n; j += 2) {
+                float x = src[j];
+                float y = src[j + 1];
+                dst[j] += (x * leftamp_L) + (y * leftamp_R);
+                dst[j + 1] += (x * rightamp_L) + (y * rightamp_R);
+            }
+            if (j < n) {
+                dst[j] += (src[j] * leftamp_L);
+            }
+        }
+    }
+
+    static inline void ReplaceGain(float* dst, float* src, long framesNum, long channels, float leftamp, float rightamp)
+    {
+        long n = Count(channels);
+        for (long i = 0; i < framesNum; i++, dst += n, src += n) {
+            long j = 0;
+            for (; j + 1 < n; j += 2) {
+                dst[j] = (src[j] * leftamp);
+                dst[j + 1] = (src[j + 1] * rightamp);
+            }
+            if (j < n) {
+                dst[j] = (src[j] * leftamp);
+            }
+        }
+    }
+};
+
+template <>
+inline void TFrameKernel<1>::MixGain(float* dst, float* src, long framesNum, long channels, float leftamp, float rightamp)
+{
+    for (long i = 0; i < framesNum; i++) {
+        dst[i] += (src[i] * leftamp);
+    }
+}
+
+template <>
+inline void TFrameKernel<2>::MixGain(float* dst, float* src, long framesNum, long channels, float leftamp, float rightamp)
+{
+    for (long i = 0; i < 2 * framesNum; i += 2) {
+        dst[i] += (src[i] * leftamp);
+        dst[i + 1] += (src[i + 1] * rightamp);
+    }
+}
+
+template <>
+inline void TFrameKernel<2>::MixMatrix(float* dst, float* src, long framesNum, long channels, float leftamp_L, float rightamp_L, float leftamp_R, float rightamp_R)
+{
+    for (long i = 0; i < 2 * framesNum; i += 2) {
+        float x = src[i];
+        float y = src[i + 1];
+        dst[i] += (x * leftamp_L) + (y * leftamp_R);
+        dst[i + 1] += (x * rightamp_L) + (y * rightamp_R);
+    }
+}
+
 //--------------------
 // Class UAudioTools
 //--------------------
@@ -119,71 +212,124 @@ class UAudioTools
 		
 		static inline void MixFrameToFrameBlk(float* dst, float* src, long framesNum, long channels)
         {
-			for (int i = 0 ; i < framesNum; i++) {
-                for (int j = 0 ; j < channels; j += 2) { // A REVOIR
-                    int index1 = i * channels + j;
-                    int index2 = index1 + 1;
-                    dst[index1] += src[index1];
-                    dst[index2] += src[index2];
-                }
-            }
+            MixSamplesBlk(dst, src, framesNum * channels);
 		}
 
         static inline void MixFrameToFrameBlk(float* dst, float* src, long framesNum, long channels, float leftamp, float rightamp)
         {
-			for (int i = 0 ; i < framesNum; i++) {
-                for (int j = 0 ; j < channels; j += 2) { // A REVOIR
-                    int index1 = i * channels + j;
-                    int index2 = index1 + 1;
-                    dst[index1] += (src[index1] * leftamp);
-                    dst[index2] += (src[index2] * rightamp);
-                }
+            switch (channels) {
+                case 1: TFrameKernel<1>::MixGain(dst, src, framesNum, channels, leftamp, rightamp); break;
+                case 2: TFrameKernel<2>::MixGain(dst, src, framesNum, channels, leftamp, rightamp); break;
+                case 4: TFrameKernel<4>::MixGain(dst, src, framesNum, channels, leftamp, rightamp); break;
+                case 6: TFrameKernel<6>::MixGain(dst, src, framesNum, channels, leftamp, rightamp); break;
+                case 8: TFrameKernel<8>::MixGain(dst, src, framesNum, channels, leftamp, rightamp); break;
+                default: TFrameKernel<0>::MixGain(dst, src, framesNum, channels, leftamp, rightamp); break;
             }
 		}
 		
 		static inline void MixFrameToFrameBlk(float* dst, float* src, long framesNum, long channels, float leftamp_L, float rightamp_L, float leftamp_R, float rightamp_R)
         {
-			for (int i = 0 ; i < framesNum; i++) {
-                for (int j = 0 ; j < channels; j += 2) { // A REVOIR
-                    int index1 = i * channels + j;
-                    int index2 = index1 + 1;
-					dst[index1] += (src[index1] * leftamp_L) + (src[index2] * leftamp_R);
-                    dst[index2] += (src[index1] * rightamp_L) + (src[index2] * rightamp_R);
-                }
+            switch (channels) {
+                case 1: TFrameKernel<1>::MixMatrix(dst, src, framesNum, channels, leftamp_L, rightamp_L, leftamp_R, rightamp_R); break;
+                case 2: TFrameKernel<2>::MixMatrix(dst, src, framesNum, channels, leftamp_L, rightamp_L, leftamp_R, rightamp_R); break;
+                case 4: TFrameKernel<4>::MixMatrix(dst, src, framesNum, channels, leftamp_L, rightamp_L, leftamp_R, rightamp_R); break;
+                case 6: TFrameKernel<6>::MixMatrix(dst, src, framesNum, channels, leftamp_L, rightamp_L, leftamp_R, rightamp_R); break;
+                case 8: TFrameKernel<8>::MixMatrix(dst, src, framesNum, channels, leftamp_L, rightamp_L, leftamp_R, rightamp_R); break;
+                default: TFrameKernel<0>::MixMatrix(dst, src, framesNum, channels, leftamp_L, rightamp_L, leftamp_R, rightamp_R); break;
             }
 		}
 		
-		static inline void MixFrameToFrameBlk1(float* dst, float* src, long framesNum, long channels)
-        {
-            for (int i = 0 ; i < framesNum; i++) {
-                for (int j = 0 ; j < channels; j++) { 
-                    long index1 = i * channels + j;
-                    dst[index1] += src[index1];
+		// Upmix from channelsIn to channelsOut (channelsIn < channelsOut) while applying the gains:
+		// a mono source is panned with (leftamp_L, rightamp_L), otherwise source channels are distributed
+		// as (j % channelsIn) and each (left, right) output pair goes through the gain matrix.
+		static inline void MixUpFrameToFrameBlk(float* dst, float* src, long framesNum, long channelsIn, long channelsOut, float leftamp_L, float rightamp_L, float leftamp_R, float rightamp_R)
+        {
+            if (channelsIn == 1) {
+                if (channelsOut == 2) {
+                    for (long i = 0; i < framesNum; i++, dst += 2) {
+                        float x = src[i];
+                        dst[0] += (x * leftamp_L);
+                        dst[1] += (x * rightamp_L);
+                    }
+                } else {
+                    for (long i = 0; i < framesNum; i++, dst += channelsOut) {
+                        float x = src[i];
+                        for (long j = 0; j < channelsOut; j++) {
+                            dst[j] += x * ((j & 1) ? rightamp_L : leftamp_L);
+                        }
+                    }
+                }
+            } else {
+                for (long i = 0; i < framesNum; i++, dst += channelsOut, src += channelsIn) {
+                    long j = 0;
+                    for (; j + 1 < channelsOut; j += 2) {
+                        float x = src[j % channelsIn];
+                        float y = src[(j + 1) % channelsIn];
+                        dst[j] += (x * leftamp_L) + (y * leftamp_R);
+                        dst[j + 1] += (x * rightamp_L) + (y * rightamp_R);
+                    }
+                    if (j < channelsOut) {
+                        dst[j] += (src[j % channelsIn] * leftamp_L);
+                    }
                 }
             }
         }
+		
+		static inline void MixFrameToFrameBlk1(float* dst, float* src, long framesNum, long channels)
+        {
+            MixSamplesBlk(dst, src, framesNum * channels);
+        }
 
         static inline void ReplaceFrameToFrameBlk(float* dst, float* src, long framesNum, long channels, float leftamp, float rightamp)
         {
-            for (int i = 0 ; i < framesNum; i++) {
-                for (int j = 0 ; j < channels; j += 2) { // A REVOIR
-                    int index1 = i * channels + j;
-                    int index2 = index1 + 1;
-                    dst[index1] = (src[index1] * leftamp);
-                    dst[index2] = (src[index2] * rightamp);
-                }
+            switch (channels) {
+                case 1: TFrameKernel<1>::ReplaceGain(dst, src, framesNum, channels, leftamp, rightamp); break;
+                case 2: TFrameKernel<2>::ReplaceGain(dst, src, framesNum, channels, leftamp, rightamp); break;
+                case 4: TFrameKernel<4>::ReplaceGain(dst, src, framesNum, channels, leftamp, rightamp); break;
+                case 6: TFrameKernel<6>::ReplaceGain(dst, src, framesNum, channels, leftamp, rightamp); break;
+                case 8: TFrameKernel<8>::ReplaceGain(dst, src, framesNum, channels, leftamp, rightamp); break;
+                default: TFrameKernel<0>::ReplaceGain(dst, src, framesNum, channels, leftamp, rightamp); break;
             }
         }
 
         static inline void ReplaceFrameToFrameBlk1(float* dst, float* src, long framesNum, long channels)
         {
-            for (int i = 0 ; i < framesNum; i++) {
-                for (int j = 0 ; j < channels; j += 2) { // A REVOIR
-                    int index1 = i * channels + j;
-                    int index2 = index1 + 1;
-                    dst[index1] = src[index1];
-                    dst[index2] = src[index2];
-                }
+            memcpy(dst, src, sizeof(float) * framesNum * channels);
+        }
+
+        // Sample oriented kernels: unrolled by 4, then the remainder
+
+        static inline void MixSamplesBlk(float* dst, float* src, long nbsamples)
+        {
+            long i = 0;
+            for (; i + 4 <= nbsamples; i += 4) {
+                dst[i] += src[i];
+                dst[i + 1] += src[i + 1];
+                dst[i + 2] += src[i + 2];
+                dst[i + 3] += src[i + 3];
+            }
+            for (; i < nbsamples; i++) {
+                dst[i] += src[i];
+            }
+        }
+
+        // Zeroed allocation aligned on PLUG_BUFFER_ALIGNMENT, to be released with AlignedFree
+        static inline float* AlignedCalloc(long nbsamples)
+        {
+            size_t size = sizeof(float) * nbsamples + PLUG_BUFFER_ALIGNMENT + sizeof(void*);
+            char* base = (char*)calloc(1, size);
+            if (!base) {
+                return 0;
+            }
+            size_t addr = (size_t)(base + sizeof(void*) + PLUG_BUFFER_ALIGNMENT - 1) & ~(size_t)(PLUG_BUFFER_ALIGNMENT - 1);
+            ((void**)addr)[-1] = base;
+            return (float*)addr;
+        }
+        
+        static inline void AlignedFree(float* ptr)
+        {
+            if (ptr) {
+                free(((void**)ptr)[-1]);
             }
         }
 
@@ -288,13 +434,26 @@ class UAudioTools
                         out[indexWrite + j] = sample;
                     }
                 }
+            } else if (channelsIn > channelsOut) { // drop extra channels
+                for (long i = 0; i < framesNum; i++) {
+                    long indexRead = i * channelsIn;
+                    long indexWrite = i * channelsOut;
+                    for (long j = 0; j < channelsOut; j++) {
+                        out[indexWrite + j] = float(in[indexRead + j]) * fGain;
+                    }
+                }
             } else {
-                for (long i = 0; i < framesNum * channelsOut; i += 4) {
+                long nbsamples = framesNum * channelsOut;
+                long i = 0;
+                for (; i + 4 <= nbsamples; i += 4) {
                     out[i] = float(in[i]) * fGain;
                     out[i + 1] = float(in[i + 1]) * fGain;
                     out[i + 2] = float(in[i + 2]) * fGain;
                     out[i + 3] = float(in[i + 3]) * fGain;
                 }
+                for (; i < nbsamples; i++) {
+                    out[i] = float(in[i]) * fGain;
+                }
             }
         }
 
@@ -312,16 +471,15 @@ class UAudioTools
                         out[indexWrite + j] += sample;
                     }
                 }
+            } else if (channelsIn > channelsOut) { // drop extra channels
+                for (long i = 0; i < framesNum; i++) {
+                    long indexRead = i * channelsIn;
+                    long indexWrite = i * channelsOut;
+                    for (long j = 0; j < channelsOut; j++) {
+                        out[indexWrite + j] += float(in[indexRead + j]) * fGain;
+                    }
+                }
             } else {
-			
-			/*
-			for (long i = 0; i < framesNum * channelsOut; i += 4) {
-				out[i] += float(in[i]) * fGain;
-				out[i + 1] += float(in[i + 1]) * fGain;
-				out[i + 2] += float(in[i + 2]) * fGain;
-				out[i + 3] += float(in[i + 3]) * fGain;
-			}
-			*/
 		
 			// Works only on Tiger... removed for now
 			#ifdef __APPLE__
@@ -329,11 +487,16 @@ class UAudioTools
 				vDSP_vflt16(in, 1, buffer, 1, framesNum * channelsOut);
 				vDSP_vsma(buffer, 1, &fGain, out, 1, out, 1, framesNum * channelsOut);
 			#else
-				for (long i = 0; i < framesNum * channelsOut; i += 4) {
+                long nbsamples = framesNum * channelsOut;
+                long i = 0;
+				for (; i + 4 <= nbsamples; i += 4) {
                     out[i] += float(in[i]) * fGain;
                     out[i + 1] += float(in[i + 1]) * fGain;
                     out[i + 2] += float(in[i + 2]) * fGain;
                     out[i + 3] += float(in[i + 3]) * fGain;
+                }
+                for (; i < nbsamples; i++) {
+                    out[i] += float(in[i]) * fGain;
                 }
 			#endif
 			
@@ -369,13 +532,24 @@ class UAudioTools
                         out[i*channelsOut + j] += (short)(ClipFloat(in[i * channelsIn + j % channelsIn]) * fGain);
                     }
                 }
+            } else if (channelsIn > channelsOut) { // drop extra channels
+                for (long i = 0; i < framesNum; i++) {
+                    for (long j = 0; j < channelsOut; j++) {
+                        out[i*channelsOut + j] += (short)(ClipFloat(in[i * channelsIn + j]) * fGain);
+                    }
+                }
             } else {
-                for (long i = 0; i < framesNum * channelsOut; i += 4) {
+                long nbsamples = framesNum * channelsOut;
+                long i = 0;
+                for (; i + 4 <= nbsamples; i += 4) {
                     out[i] += (short)(ClipFloat(in[i]) * fGain);
                     out[i + 1] += (short)(ClipFloat(in[i + 1]) * fGain);
                     out[i + 2] += (short)(ClipFloat(in[i + 2]) * fGain);
                     out[i + 3] += (short)(ClipFloat(in[i + 3]) * fGain);
                 }
+                for (; i < nbsamples; i++) {
+                    out[i] += (short)(ClipFloat(in[i]) * fGain);
+                }
             }
         }
 
@@ -387,13 +561,14 @@ class UAudioTools
                         out [i*channelsOut + j] += in[i * channelsIn + j % channelsIn];
                     }
                 }
-            } else {
-                for (long i = 0; i < framesNum * channelsOut; i += 4) {
-                    out[i] = (short)(ClipFloat(in[i]) * fGain);
-                    out[i + 1] = (short)(ClipFloat(in[i + 1]) * fGain);
-                    out[i + 2] = (short)(ClipFloat(in[i + 2]) * fGain);
-                    out[i + 3] = (short)(ClipFloat(in[i + 3]) * fGain);
+            } else if (channelsIn > channelsOut) { // drop extra channels
+                for (long i = 0; i < framesNum; i++) {
+                    for (long j = 0; j < channelsOut; j++) {
+                        out [i*channelsOut + j] += in[i * channelsIn + j];
+                    }
                 }
+            } else {
+                MixSamplesBlk(out, in, framesNum * channelsOut);
             }
         }
 
@@ -0,0 +1,65 @@
+/*
+
+Copyright (C) Grame 2002-2013
+
+This library is free software; you can redistribute it and modify it under
+the terms of the GNU Library General Public License as published by the
+Free Software Foundation version 2 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public License
+for more details.
+
+You should have received a copy of the GNU Library General Public License
+along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+Grame Research Laboratory, 9, rue du Garet 69001 Lyon - France
+research@grame.fr
+
+*/
+
+#include "UTools.h"
+
+#if defined(__APPLE__)
+	#include <mach/mach_time.h>
+	#include <unistd.h>
+#elif defined(WIN32)
+	#include <windows.h>
+#else
+	#include <time.h>
+	#include <unistd.h>
+#endif
+
+double UTools::GetTime()
+{
+#if defined(__APPLE__)
+    static mach_timebase_info_data_t info = {0, 0};
+    if (info.denom == 0) {
+        mach_timebase_info(&info);
+    }
+    return double(mach_absolute_time()) * double(info.numer) / double(info.denom) * 1e-9;
+#elif defined(WIN32)
+    LARGE_INTEGER counter, frequency;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return double(counter.QuadPart) / double(frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return double(ts.tv_sec) + double(ts.tv_nsec) * 1e-9;
+#endif
+}
+
+long UTools::GetCPUCount()
+{
+#if defined(WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return long(info.dwNumberOfProcessors);
+#else
+    long count = long(sysconf(_SC_NPROCESSORS_ONLN));
+    return (count > 0) ? count : 1;
+#endif
+}
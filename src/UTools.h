@@ -54,6 +54,11 @@ class UTools
             return (a >= b) ? a : b;
         }
 
+        // Monotonic time in seconds
+        static double GetTime();
+        // Number of available processors
+        static long GetCPUCount();
+
 };
 
 
@@ -72,4 +72,23 @@ static inline long msAtomicDec (volatile TAtomic * val)
 	return actual;
 }
 
+/* adds n to *val, returns the new value */
+static inline long msAtomicAdd (volatile long * val, long n)
+{
+    long actual;
+    do {
+        actual = *val;
+    } while (!CAS(val, (void *)actual, (void *)(actual+n)));
+	return actual + n;
+}
+
+/* stores value with a locked instruction: the writes done before are visible to the threads that read it */
+static inline void msAtomicSet (volatile unsigned long * val, unsigned long value)
+{
+    unsigned long actual;
+    do {
+        actual = *val;
+    } while (!CAS(val, (void *)actual, (void *)value));
+}
+
 #endif
@@ -22,10 +22,17 @@
 
 #include "la_smartpointer.h"
 #include "TThreadCmdManager.h"
+#include "msAtomic.h"
+
+void la_smartable::addReference()
+{
+	long refs = msAtomicAdd(&refCount, 1);
+	assert(refs > 0);
+}
 
 void la_smartable::removeReference() 
 { 
-	if (--refCount == 0) {
+	if (msAtomicAdd(&refCount, -1) == 0) {
 		delete this; 
 	}
 }
@@ -37,7 +44,7 @@ void la_smartable1::removeReferenceAux(la_smartable1* obj, long u1, long u2, lon
 
 void la_smartable1::removeReference() 
 { 
-	if (--refCount == 0 && fManager) {
+	if (msAtomicAdd(&refCount, -1) == 0 && fManager) {
 		fManager->ExecCmd((CmdPtr)removeReferenceAux, (long)this, 0, 0, 0, 0);
 	}
 }
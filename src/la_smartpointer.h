@@ -57,14 +57,14 @@ class LA_EXPORT la_smartable {
 			
 	public:
 		//! gives the reference count of the object
-		unsigned refs() const         { return refCount; }
-		//! addReference increments the ref count and checks for refCount overflow
-		void addReference()           { refCount++; assert(refCount != 0); }
+		unsigned refs() const         { return unsigned(refCount); }
+		//! addReference increments the ref count and checks for refCount overflow, atomically (commands queued to other threads hold references)
+		void addReference();
 		//! removeReference delete the object when refCount is zero		
 		virtual void removeReference();
 		
 	protected:
-		unsigned long refCount;	
+		volatile long refCount;	
 		la_smartable() : refCount(0) {}
 		la_smartable(const la_smartable&): refCount(0) {}
 		//! destructor checks for non-zero refCount
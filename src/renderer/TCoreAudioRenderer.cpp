@@ -21,7 +21,6 @@ research@grame.fr
 */
 
 #include "TCoreAudioRenderer.h"
-#include "TSharedBuffers.h"
 #include "TAudioGlobals.h"
 #include "UTools.h"
 #include <mach/mach_time.h>
@@ -21,8 +21,7 @@ research@grame.fr
 */
 
 #include "TJackAudioRenderer.h"
-#include "TAudioGlobals.h"
-#include "TSharedBuffers.h"
+#include "TAudioContext.h"
 #include "UTools.h"
 
 #ifdef WIN32
@@ -59,8 +58,9 @@ int TJackAudioRenderer::Process(jack_nframes_t nframes, void *arg)
 TJackAudioRenderer::TJackAudioRenderer(): TAudioRenderer()
 {
 	fInput = fOutput = MAX_PORTS;
-    fInputBuffer = new float[TAudioGlobals::fBufferSize * TAudioGlobals::fInput];
-    fOutputBuffer = new float[TAudioGlobals::fBufferSize * TAudioGlobals::fOutput];
+    TAudioContextPtr context = TAudioContext::GetCurrent();
+    fInputBuffer = new float[context->fBufferSize * context->fInput];
+    fOutputBuffer = new float[context->fBufferSize * context->fOutput];
 	fInput_ports = (jack_port_t**)calloc(fInput, sizeof(jack_port_t*));
 	fOutput_ports = (jack_port_t**)calloc(fOutput, sizeof(jack_port_t*));
 }
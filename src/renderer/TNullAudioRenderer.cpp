@@ -0,0 +1,241 @@
+/*
+
+Copyright (C) Grame 2002-2013
+
+This library is free software; you can redistribute it and modify it under
+the terms of the GNU Library General Public License as published by the
+Free Software Foundation version 2 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public License
+for more details.
+
+You should have received a copy of the GNU Library General Public License
+along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+Grame Research Laboratory, 9, rue du Garet 69001 Lyon - France
+research@grame.fr
+
+*/
+
+#include "TNullAudioRenderer.h"
+#include "UAudioTools.h"
+#include "UTools.h"
+#include "StringTools.h"
+#include "TAudioLog.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#ifdef WIN32
+	#define NullSleep(usec) Sleep(usec / 1000)
+#else
+	#include <unistd.h>
+	#define NullSleep(usec) usleep(usec)
+#endif
+
+TNullAudioRenderer::TNullAudioRenderer(bool paced): TAudioRenderer()
+{
+    fPaced = paced;
+    fRunning = false;
+    fCurFrame = 0;
+    fInputBuffer = 0;
+    fOutputBuffer = 0;
+    fCaptureFormat = 0;
+    fCapture = 0;
+}
+
+TNullAudioRenderer::~TNullAudioRenderer()
+{
+    Close();
+}
+
+#if defined(__APPLE__) || defined(linux)
+
+void* TNullAudioRenderer::Process(void* arg)
+{
+    static_cast<TNullAudioRendererPtr>(arg)->Render();
+    return 0;
+}
+
+#elif WIN32
+
+DWORD WINAPI TNullAudioRenderer::Process(void* arg)
+{
+    static_cast<TNullAudioRendererPtr>(arg)->Render();
+    return 0;
+}
+
+#endif
+
+void TNullAudioRenderer::Render()
+{
+    double period = double(fBufferSize) / double(fSampleRate);
+    double next = UTools::GetTime();
+
+    while (fRunning) {
+        Run(fInputBuffer, fOutputBuffer, fBufferSize);
+        if (fCapture && sf_writef_float(fCapture, fOutputBuffer, fBufferSize) != fBufferSize) {
+            TAudioLog::Log("TNullAudioRenderer::Render : sf_writef_float error = %s\n", sf_strerror(fCapture));
+        }
+        fCurFrame += fBufferSize;
+
+        if (fPaced) {
+            next += period;
+            double wait = next - UTools::GetTime();
+            if (wait > 0) {
+                NullSleep(long(wait * 1000000.0));
+            } else if (wait < -period) {
+                next = UTools::GetTime();
+            }
+        }
+    }
+}
+
+long TNullAudioRenderer::OpenDefault(long inChan, long outChan, long bufferSize, long sampleRate)
+{
+    if (bufferSize <= 0 || sampleRate <= 0) {
+        printf("TNullAudioRenderer::OpenDefault : wrong buffer size %ld or sample rate %ld\n", bufferSize, sampleRate);
+        return OPEN_ERR;
+    }
+
+    Close();
+    fInputBuffer = new float[bufferSize * UTools::Max(inChan, 1)];
+    fOutputBuffer = new float[bufferSize * UTools::Max(outChan, 1)];
+    // Input is silent
+    UAudioTools::ZeroFloatBlk(fInputBuffer, bufferSize, UTools::Max(inChan, 1));
+    fCurFrame = 0;
+    return TAudioRenderer::OpenDefault(inChan, outChan, bufferSize, sampleRate);
+}
+
+long TNullAudioRenderer::Open(long inputDevice, long outputDevice, long inChan, long outChan, long bufferSize, long sampleRate)
+{
+    return OpenDefault(inChan, outChan, bufferSize, sampleRate);
+}
+
+long TNullAudioRenderer::Close()
+{
+    Stop();
+    delete[] fInputBuffer;
+    delete[] fOutputBuffer;
+    fInputBuffer = 0;
+    fOutputBuffer = 0;
+    return NO_ERR;
+}
+
+long TNullAudioRenderer::Start()
+{
+    if (fRunning) {
+        return NO_ERR;
+    }
+    if (!fOutputBuffer) {
+        printf("TNullAudioRenderer::Start : renderer is not opened\n");
+        return OPEN_ERR;
+    }
+
+    if (fCaptureName.size() > 0) {
+        SF_INFO info;
+        info.samplerate = fSampleRate;
+        info.channels = fOutput;
+        info.format = fCaptureFormat;
+        char utf8name[512] = {0};
+
+        assert(fCaptureName.size() < 512);
+        Convert2UTF8(fCaptureName.c_str(), utf8name, 512);
+        if (!(fCapture = sf_open(utf8name, SFM_WRITE, &info))) {
+            printf("TNullAudioRenderer::Start : cannot open capture file %s\n", fCaptureName.c_str());
+            return OPEN_ERR;
+        }
+    }
+
+    fRunning = true;
+#if defined(__APPLE__) || defined(linux)
+    if (pthread_create(&fThread, NULL, Process, (void*)this) != 0) {
+        fRunning = false;
+    }
+#elif WIN32
+    DWORD id;
+    if (!(fThread = CreateThread(NULL, 0, Process, (void*)this, 0, &id))) {
+        fRunning = false;
+    }
+#endif
+
+    if (!fRunning) {
+        printf("TNullAudioRenderer::Start : cannot create thread\n");
+        if (fCapture) {
+            sf_close(fCapture);
+            fCapture = 0;
+        }
+        return OPEN_ERR;
+    }
+    return NO_ERR;
+}
+
+long TNullAudioRenderer::Stop()
+{
+    if (!fRunning) {
+        return NO_ERR;
+    }
+
+    fRunning = false;
+#if defined(__APPLE__) || defined(linux)
+    pthread_join(fThread, NULL);
+#elif WIN32
+    WaitForSingleObject(fThread, INFINITE);
+    CloseHandle(fThread);
+#endif
+
+    if (fCapture) {
+        sf_close(fCapture);
+        fCapture = 0;
+    }
+    return NO_ERR;
+}
+
+void TNullAudioRenderer::GetInfo(RendererInfoPtr info)
+{
+    info->fInput = fInput;
+    info->fOutput = fOutput;
+    info->fSampleRate = fSampleRate;
+    info->fBufferSize = fBufferSize;
+    // Time of the simulated clock
+    info->fCurFrame = fCurFrame;
+    info->fCurUsec = (fSampleRate > 0) ? ConvertSample2Usec(info->fCurFrame) : 0;
+    info->fOutputLatencyFrame = 0;
+    info->fOutputLatencyUsec = 0;
+    info->fInputLatencyFrame = 0;
+    info->fInputLatencyUsec = 0;
+}
+
+long TNullAudioRenderer::GetDeviceCount()
+{
+    return 1;
+}
+
+void TNullAudioRenderer::GetDeviceInfo(long deviceNum, DeviceInfoPtr info)
+{
+    strncpy(info->fName, (fPaced) ? "Null device" : "Null device (free-running)", sizeof(info->fName) - 1);
+    info->fName[sizeof(info->fName) - 1] = 0;
+    info->fMaxInputChannels = 256;
+    info->fMaxOutputChannels = 256;
+    info->fDefaultBufferSize = 512;
+    info->fDefaultSampleRate = 44100.0;
+}
+
+long TNullAudioRenderer::GetDefaultInputDevice()
+{
+    return 0;
+}
+
+long TNullAudioRenderer::GetDefaultOutputDevice()
+{
+    return 0;
+}
+
+void TNullAudioRenderer::SetCapture(const string& name, long format)
+{
+    fCaptureName = name;
+    fCaptureFormat = format;
+}
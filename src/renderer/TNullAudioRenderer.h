@@ -0,0 +1,105 @@
+/*
+
+Copyright (C) Grame 2002-2013
+
+This library is free software; you can redistribute it and modify it under
+the terms of the GNU Library General Public License as published by the
+Free Software Foundation version 2 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public License
+for more details.
+
+You should have received a copy of the GNU Library General Public License
+along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+Grame Research Laboratory, 9, rue du Garet 69001 Lyon - France
+research@grame.fr
+
+*/
+
+#ifndef __TNullAudioRenderer__
+#define __TNullAudioRenderer__
+
+#include "TAudioRenderer.h"
+#include <sndfile.h>
+#include <string>
+
+#if defined(__APPLE__) || defined(linux)
+	#include <pthread.h>
+#elif WIN32
+	#include <windows.h>
+#endif
+
+using namespace std;
+
+//--------------------------
+// Class TNullAudioRenderer
+//--------------------------
+/*!
+\brief A renderer without audio device, driven by its own thread.
+*/
+
+/*
+The thread calls Run with silent input buffers, either paced by a simulated clock at the sample rate
+(one buffer every fBufferSize / fSampleRate seconds, like a sound card would), or free-running as fast
+as the clients can render. Late buffers are not dropped: when more than a buffer late, the clock is
+restarted from the current time.
+
+The output can be captured in a sound file, written by the renderer thread.
+*/
+
+class TNullAudioRenderer : public TAudioRenderer
+{
+
+    private:
+
+        bool fPaced;
+        volatile bool fRunning;
+        volatile uint64_t fCurFrame;    // Written by the renderer thread only
+
+        float* fInputBuffer;
+        float* fOutputBuffer;
+
+        string fCaptureName;
+        long fCaptureFormat;
+        SNDFILE* fCapture;
+
+    #if defined(__APPLE__) || defined(linux)
+        pthread_t fThread;
+        static void* Process(void* arg);
+    #elif WIN32
+        HANDLE fThread;
+        static DWORD WINAPI Process(void* arg);
+    #endif
+
+        void Render();
+
+    public:
+
+        TNullAudioRenderer(bool paced);
+        virtual ~TNullAudioRenderer();
+
+        long OpenDefault(long inChan, long outChan, long bufferSize, long sampleRate);
+        long Open(long inputDevice, long outputDevice, long inChan, long outChan, long bufferSize, long sampleRate);
+        long Close();
+
+        long Start();
+        long Stop();
+
+        void GetInfo(RendererInfoPtr info);
+
+        long GetDeviceCount();
+        void GetDeviceInfo(long deviceNum, DeviceInfoPtr info);
+        long GetDefaultInputDevice();
+        long GetDefaultOutputDevice();
+
+        // Capture the output in a sound file from the next Start (empty name to stop capturing)
+        void SetCapture(const string& name, long format);
+};
+
+typedef TNullAudioRenderer * TNullAudioRendererPtr;
+
+#endif
@@ -21,7 +21,6 @@ research@grame.fr
 */
 
 #include "TPortAudioV19Renderer.h"
-#include "TSharedBuffers.h"
 #include "TAudioGlobals.h"
 #include "UTools.h"
 